@@ -28,6 +28,7 @@
 #include "XESInit.h"
 #include "XESIO.h"
 #include "DEMIO.h"
+#include "DEMDefs.h"
 #include "MemFileUtils.h"
 #include <CGAL/assertions.h>
  #include <CGAL/assertions_behaviour.h>
@@ -207,6 +208,12 @@ int	main(int argc, char * argv[])
 				MT_SetMeshSpecs(param1, param2);
 			}
 			
+			if(sscanf(buf,"THREADS %d", &param1) == 1)
+			{
+				printf("Using %d threads for raster passes (0 = one per core).\n", param1);
+				gDemThreads = param1;
+			}
+			
 			if(sscanf(buf,"DEFINE_CUSTOM_TERRAIN %d %s",&use_wat, cus_ter)==2)
 			{
 				proj_pt = 0;
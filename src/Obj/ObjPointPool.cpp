@@ -29,7 +29,7 @@
 using std::min;
 using std::max;
 
-ObjPointPool::ObjPointPool() : mDepth(8)
+ObjPointPool::ObjPointPool() : mIndexValid(true), mDepth(8)
 {
 }
 
@@ -41,6 +41,7 @@ void	ObjPointPool::clear(int depth)
 {
 	mData.clear();
 	mIndex.clear();
+	mIndexValid = true;
 	mDepth = depth;
 }
 
@@ -48,10 +49,24 @@ void	ObjPointPool::resize(int pts)
 {
 	mData.resize(pts * mDepth);
 	mIndex.clear();
+	mIndexValid = false;
+}
+
+// Loaders set every point of a big pool one by one, and a map insert per point cost more than the parse.  So
+// set() leaves the index alone and it's rebuilt here, first point wins - same as inserting in order would.
+void	ObjPointPool::build_index(void)
+{
+	mIndex.clear();
+	int n = count();
+	for (int i = 0; i < n; ++i)
+		mIndex.insert(index_type::value_type(key_type(get(i), get(i) + mDepth), i));
+	mIndexValid = true;
 }
 
 int		ObjPointPool::accumulate(const float pt[])
 {
+	if (!mIndexValid)
+		build_index();
 	index_type::iterator iter = mIndex.find(key_type(pt, pt + mDepth));
 	if (iter != mIndex.end())
 		return iter->second;
@@ -62,14 +77,16 @@ int		ObjPointPool::append(const float pt[])
 {
 	int ret = mData.size() / mDepth;
 	mData.insert(mData.end(), pt, pt + mDepth);
-	mIndex.insert(index_type::value_type(key_type(pt,pt+mDepth), ret));
+	if (mIndexValid)
+		mIndex.insert(index_type::value_type(key_type(pt,pt+mDepth), ret));
 	return ret;
 }
 
 void	ObjPointPool::set(int n, float pt[])
 {
 	memcpy(&mData[n*mDepth], pt, mDepth * sizeof(float));
-	mIndex.insert(index_type::value_type(key_type(pt,pt+mDepth), n));
+	mIndex.clear();
+	mIndexValid = false;
 }
 
 int		ObjPointPool::count(void) const
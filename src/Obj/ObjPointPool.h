@@ -52,6 +52,7 @@ public:
 	void	set(int n, float pt[]);			// Set an existing pt
 
 	int		count(void) const;
+	int		depth(void) const { return mDepth; }
 	float *	get(int index);
 	const float *	get(int index) const;
 
@@ -62,8 +63,11 @@ private:
 	typedef	vector<float>									key_type;
 	typedef map<key_type, int, lex_compare_vector<float> >	index_type;
 
+	void	build_index(void);
+
 	vector<float>	mData;
-	index_type		mIndex;
+	index_type		mIndex;			// Only needed to accumulate - built on the first accumulate after a bulk fill
+	bool			mIndexValid;
 	int				mDepth;
 
 };
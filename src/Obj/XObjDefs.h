@@ -245,8 +245,9 @@ struct	XObjAnim8 {
 };
 
 struct XObjManip8 {
-	XObjManip8() : v1_min(0.0f),v1_max(0.0f),v2_min(0.0f),v2_max(0.0f),mouse_wheel_delta(0.0f)
+	XObjManip8() : angle_min(0.0f),angle_max(0.0f),lift(0.0f),v1_min(0.0f),v1_max(0.0f),v2_min(0.0f),v2_max(0.0f),mouse_wheel_delta(0.0f)
 	{
+		centroid[0] = centroid[1] = centroid[2] = 0.0f;
 		axis[0] = axis[1] = axis[2] = 0.0f;
 	}
 	string					dataref1;				// Commands for, cmd manips!
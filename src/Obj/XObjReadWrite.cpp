@@ -27,6 +27,8 @@
 #include "XObjReadWrite.h"
 #include "XObjDefs.h"
 #include "AssertUtils.h"
+#include "FileUtils.h"
+#include "PlatformUtils.h"
 #include <math.h>
 
 #ifndef CRLF
@@ -123,30 +125,49 @@ inline xint TXT_MAP_str_match_space(xbyt*& c,const xbyt* c_max,const char* input
 	return xfals;
 }
 
+// Exact powers of ten - every one of these is representable in a double, so dividing by one rounds only once.
+static const double	k_pow10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Digits go into a 64-bit int and get scaled once at the end, instead of a float multiply-add (and pow) per digit.
+// This is most of the time spent loading a big OBJ, and it's more accurate too - the float accumulator rounded
+// after every digit past the 7th.
 inline xflt TXT_MAP_flt_scan(xbyt*& c,const xbyt* c_max, bool go_next_line)
 {
 	while(c< c_max && (
 		TXT_MAP_space(c) ||
 		(go_next_line && TXT_MAP_eoln(c))))	++c;
 
-	xflt ret_val	=0;
-	xint decimals	=0;
-	xint negative	=xfals;
-	xint has_decimal=xfals;
+	long long	mantissa	=0;
+	xint		digits		=0;		// significant digits in the mantissa
+	xint		scale		=0;		// power of ten the mantissa is off by
+	xint		negative	=xfals;
+	xint		has_decimal	=xfals;
 
 	while(c<c_max && !TXT_MAP_space(c) && !TXT_MAP_eoln(c))
 	{
 			 if(*c=='-')negative	=xtrue;
 		else if(*c=='+')negative	=xfals;
 		else if(*c=='.')has_decimal	=xtrue;
-		else
+		else if(digits < 18)
 		{
-			ret_val=(10*ret_val)+*c-'0';
-			if(has_decimal)decimals++;
+			mantissa=(10*mantissa)+*c-'0';
+			if(mantissa) ++digits;
+			if(has_decimal) --scale;
 		}
+		else if(!has_decimal)
+			++scale;	// out of precision - drop the digit but keep its place
 		++c;
 	}
-	return ret_val/pow((xflt)10,(xflt)decimals)*((negative)?-1.0:1.0);
+
+	const xint	pow_count = sizeof(k_pow10) / sizeof(k_pow10[0]);
+	double		ret_val = (double) mantissa;
+	if(scale < 0)
+		ret_val /= (-scale < pow_count) ? k_pow10[-scale] : pow(10.0, -scale);
+	else if(scale > 0)
+		ret_val *= ( scale < pow_count) ? k_pow10[ scale] : pow(10.0,  scale);
+	return (xflt) (negative ? -ret_val : ret_val);
 }
 
 inline xint TXT_MAP_int_scan(xbyt*& c,const xbyt* c_max, bool go_next_line)
@@ -522,9 +543,9 @@ bool	XObjWrite(const char * inFile, const XObj& inObj)
 }
 
 /****************************************************************************************
- * OBJ 8 READ
+ * OBJ 8 TEXT READ
  ****************************************************************************************/
-bool	XObj8Read(const char * inFile, XObj8& outObj)
+static bool	XObj8ReadText(unsigned char * mem_buf, int filesize, const char * inFile, XObj8& outObj)
 {
 		int 	n;
 
@@ -532,32 +553,21 @@ bool	XObj8Read(const char * inFile, XObj8& outObj)
 	outObj.texture_lit.clear();
 	outObj.texture_normal_map.clear();
 //	outObj.texture_nrm.clear();
+	outObj.texture_draped.clear();
+	outObj.particle_system.clear();
+	outObj.regions.clear();
 	outObj.indices.clear();
 	outObj.geo_tri.clear(8);
 	outObj.geo_lines.clear(6);
 	outObj.geo_lights.clear(6);
 	outObj.animation.clear();
+	outObj.manips.clear();
+	outObj.emitters.clear();
 	outObj.lods.clear();
 	outObj.use_metalness = 0;
 	outObj.glass_blending = 0;
 	outObj.fixed_heading = -1.0;
-
-	/*********************************************************************
-	 * READ FILE INTO MEM
-	 *********************************************************************/
-
-	FILE * objFile = fopen(inFile, "rb");
-	if (!objFile) return false;
-	fseek(objFile,0L,SEEK_END);
-	int filesize = ftell(objFile);
-	fseek(objFile,0L,SEEK_SET);
-	unsigned char * mem_buf = (unsigned char *) malloc(filesize);
-	if (mem_buf == NULL) { fclose(objFile); return false; }
-	if (fread(mem_buf, 1, filesize, objFile) != filesize)
-	{
-		free(mem_buf); fclose(objFile); return false;
-	}
-	fclose(objFile);
+	outObj.description.clear();
 
 	/*********************************************************************
 	 * READ HEADER
@@ -580,10 +590,7 @@ bool	XObj8Read(const char * inFile, XObj8& outObj)
 
 	// If we don't have a good version, bail.
 	if (vers != 800)
-	{
-		free(mem_buf);
 		return false;
-	}
 
 	/************************************************************
 	 * READ GEOMETRIC COMMANDS
@@ -599,6 +606,11 @@ bool	XObj8Read(const char * inFile, XObj8& outObj)
 	XObjCmd8	cmd;
 	XObjAnim8	animation;
 
+	// Commands only fill in the params they use - zero the rest so the same file always makes the same cache bytes.
+	memset(cmd.params, 0, sizeof(cmd.params));
+	cmd.idx_offset = cmd.idx_count = 0;
+	animation.axis[0] = animation.axis[1] = animation.axis[2] = 0.0f;
+
 	outObj.lods.push_back(XObjLOD8());
 	outObj.lods.back().lod_near = outObj.lods.back().lod_far = 0;
 #if XOBJ8_USE_VBO
@@ -1526,8 +1538,6 @@ bool	XObj8Read(const char * inFile, XObj8& outObj)
 		if(!ate_eoln)
 			TXT_MAP_str_scan_eoln(cur_ptr, end_ptr, NULL);
 	} // While loop
-
-	free(mem_buf);
 	
 	if(trimax != tricount)
 		LOG_MSG("E/Obj number of %s do not match POINT_COUNTS in %s\n", "VT", inFile);
@@ -1544,6 +1554,424 @@ bool	XObj8Read(const char * inFile, XObj8& outObj)
 	return true;
 }
 
+/****************************************************************************************
+ * OBJ 8 BINARY
+ ****************************************************************************************/
+
+#define	OBJ8_BINARY_MAGIC	0x3842424F		// "OBB8"
+#define	OBJ8_BINARY_VERSION	1
+
+template <class T>
+static void cache_put(string& buf, const T& v) { buf.append((const char *) &v, sizeof(v)); }
+static void cache_put(string& buf, const string& v) { cache_put(buf, (int) v.size()); buf.append(v); }
+
+// Plain-old-data arrays go out as a count and one raw block, so they come back in with a single memcpy.
+template <class T>
+static void cache_put(string& buf, const vector<T>& v)
+{
+	cache_put(buf, (int) v.size());
+	if(!v.empty()) buf.append((const char *) &v[0], v.size() * sizeof(T));
+}
+
+static void cache_put(string& buf, const ObjPointPool& pool)
+{
+	cache_put(buf, pool.depth());
+	cache_put(buf, pool.count());
+	if(pool.count()) buf.append((const char *) pool.get(0), pool.count() * pool.depth() * sizeof(float));
+}
+
+template <class T>
+static bool cache_get(const char *& p, const char * e, T& v)
+{
+	if(e - p < (ptrdiff_t) sizeof(v)) return false;
+	memcpy(&v, p, sizeof(v));
+	p += sizeof(v);
+	return true;
+}
+
+static bool cache_get(const char *& p, const char * e, string& v)
+{
+	int len;
+	if(!cache_get(p, e, len) || len < 0 || len > e - p) return false;
+	v.assign(p, len);
+	p += len;
+	return true;
+}
+
+template <class T>
+static bool cache_get(const char *& p, const char * e, vector<T>& v)
+{
+	int count;
+	if(!cache_get(p, e, count) || count < 0 || count > (e - p) / (ptrdiff_t) sizeof(T)) return false;
+	v.resize(count);
+	if(count) memcpy(&v[0], p, count * sizeof(T));
+	p += count * sizeof(T);
+	return true;
+}
+
+static bool cache_get(const char *& p, const char * e, ObjPointPool& pool)
+{
+	int depth, count;
+	if(!cache_get(p, e, depth) || depth < 1 || depth > 8) return false;
+	if(!cache_get(p, e, count) || count < 0 || count > (e - p) / (ptrdiff_t) (depth * sizeof(float))) return false;
+	pool.clear(depth);
+	pool.resize(count);
+	if(count) memcpy(pool.get(0), p, count * depth * sizeof(float));
+	p += count * depth * sizeof(float);
+	return true;
+}
+
+void	XObj8WriteBinary(const XObj8& inObj, string& outBuf)
+{
+	string& b(outBuf);
+	b.clear();
+	b.reserve(256 + inObj.indices.size() * sizeof(int) +
+		(inObj.geo_tri.count() * 8 + inObj.geo_lines.count() * 6 + inObj.geo_lights.count() * 6) * sizeof(float));
+
+	cache_put(b, (int) OBJ8_BINARY_MAGIC);
+	cache_put(b, (int) OBJ8_BINARY_VERSION);
+
+	cache_put(b, inObj.texture);
+	cache_put(b, inObj.texture_normal_map);
+	cache_put(b, inObj.texture_lit);
+	cache_put(b, inObj.texture_draped);
+	cache_put(b, inObj.use_metalness);
+	cache_put(b, inObj.glass_blending);
+	cache_put(b, inObj.particle_system);
+	cache_put(b, inObj.regions);
+	cache_put(b, inObj.indices);
+	cache_put(b, inObj.geo_tri);
+	cache_put(b, inObj.geo_lines);
+	cache_put(b, inObj.geo_lights);
+
+	cache_put(b, (int) inObj.animation.size());
+	for(vector<XObjAnim8>::const_iterator a = inObj.animation.begin(); a != inObj.animation.end(); ++a)
+	{
+		cache_put(b, a->cmd);
+		cache_put(b, a->dataref);
+		cache_put(b, a->axis);
+		cache_put(b, a->loop);
+		cache_put(b, a->keyframes);
+	}
+
+	cache_put(b, (int) inObj.manips.size());
+	for(vector<XObjManip8>::const_iterator m = inObj.manips.begin(); m != inObj.manips.end(); ++m)
+	{
+		cache_put(b, m->dataref1);
+		cache_put(b, m->dataref2);
+		cache_put(b, m->centroid);
+		cache_put(b, m->axis);
+		cache_put(b, m->angle_min);
+		cache_put(b, m->angle_max);
+		cache_put(b, m->lift);
+		cache_put(b, m->v1_min);
+		cache_put(b, m->v1_max);
+		cache_put(b, m->v2_min);
+		cache_put(b, m->v2_max);
+		cache_put(b, m->cursor);
+		cache_put(b, m->tooltip);
+		cache_put(b, m->mouse_wheel_delta);
+		cache_put(b, m->rotation_key_frames);
+		cache_put(b, m->detents);
+	}
+
+	cache_put(b, (int) inObj.emitters.size());
+	for(vector<XObjEmitter8>::const_iterator em = inObj.emitters.begin(); em != inObj.emitters.end(); ++em)
+	{
+		cache_put(b, em->name);
+		cache_put(b, em->dataref);
+		cache_put(b, em->x);	cache_put(b, em->y);	cache_put(b, em->z);
+		cache_put(b, em->psi);	cache_put(b, em->the);	cache_put(b, em->phi);
+		cache_put(b, em->v_min);
+		cache_put(b, em->v_max);
+	}
+
+	cache_put(b, (int) inObj.lods.size());
+	for(vector<XObjLOD8>::const_iterator l = inObj.lods.begin(); l != inObj.lods.end(); ++l)
+	{
+		cache_put(b, l->lod_near);
+		cache_put(b, l->lod_far);
+		cache_put(b, (int) l->cmds.size());
+		for(vector<XObjCmd8>::const_iterator c = l->cmds.begin(); c != l->cmds.end(); ++c)
+		{
+			cache_put(b, c->cmd);
+			cache_put(b, c->params);
+			cache_put(b, c->name);
+			cache_put(b, c->idx_offset);
+			cache_put(b, c->idx_count);
+		}
+	}
+
+	cache_put(b, inObj.xyz_min);
+	cache_put(b, inObj.xyz_max);
+	cache_put(b, inObj.fixed_heading);
+	cache_put(b, inObj.description);
+}
+
+bool	XObj8ReadBinary(const char * inBegin, const char * inEnd, XObj8& outObj)
+{
+	const char *	p = inBegin;
+	const char *	e = inEnd;
+	int				magic, version, count;
+
+	if(!cache_get(p, e, magic) || magic != OBJ8_BINARY_MAGIC) return false;
+	if(!cache_get(p, e, version) || version != OBJ8_BINARY_VERSION) return false;
+
+	bool ok =
+		cache_get(p, e, outObj.texture) &&
+		cache_get(p, e, outObj.texture_normal_map) &&
+		cache_get(p, e, outObj.texture_lit) &&
+		cache_get(p, e, outObj.texture_draped) &&
+		cache_get(p, e, outObj.use_metalness) &&
+		cache_get(p, e, outObj.glass_blending) &&
+		cache_get(p, e, outObj.particle_system) &&
+		cache_get(p, e, outObj.regions) &&
+		cache_get(p, e, outObj.indices) &&
+		cache_get(p, e, outObj.geo_tri) &&
+		cache_get(p, e, outObj.geo_lines) &&
+		cache_get(p, e, outObj.geo_lights);
+#if XOBJ8_USE_VBO
+	outObj.geo_VBO = 0;
+	outObj.idx_VBO = 0;
+#endif
+
+	// Every record is at least a few bytes, so a count bigger than what's left is a damaged file - don't let it
+	// make us allocate the world.
+	ok = ok && cache_get(p, e, count) && count >= 0 && count <= e - p;
+	if(ok)
+	{
+		outObj.animation.resize(count);
+		for(vector<XObjAnim8>::iterator a = outObj.animation.begin(); ok && a != outObj.animation.end(); ++a)
+			ok = cache_get(p, e, a->cmd) && cache_get(p, e, a->dataref) && cache_get(p, e, a->axis) &&
+				cache_get(p, e, a->loop) && cache_get(p, e, a->keyframes);
+	}
+
+	ok = ok && cache_get(p, e, count) && count >= 0 && count <= e - p;
+	if(ok)
+	{
+		outObj.manips.resize(count);
+		for(vector<XObjManip8>::iterator m = outObj.manips.begin(); ok && m != outObj.manips.end(); ++m)
+			ok = cache_get(p, e, m->dataref1) && cache_get(p, e, m->dataref2) &&
+				cache_get(p, e, m->centroid) && cache_get(p, e, m->axis) &&
+				cache_get(p, e, m->angle_min) && cache_get(p, e, m->angle_max) && cache_get(p, e, m->lift) &&
+				cache_get(p, e, m->v1_min) && cache_get(p, e, m->v1_max) &&
+				cache_get(p, e, m->v2_min) && cache_get(p, e, m->v2_max) &&
+				cache_get(p, e, m->cursor) && cache_get(p, e, m->tooltip) && cache_get(p, e, m->mouse_wheel_delta) &&
+				cache_get(p, e, m->rotation_key_frames) && cache_get(p, e, m->detents);
+	}
+
+	ok = ok && cache_get(p, e, count) && count >= 0 && count <= e - p;
+	if(ok)
+	{
+		outObj.emitters.resize(count);
+		for(vector<XObjEmitter8>::iterator em = outObj.emitters.begin(); ok && em != outObj.emitters.end(); ++em)
+			ok = cache_get(p, e, em->name) && cache_get(p, e, em->dataref) &&
+				cache_get(p, e, em->x) && cache_get(p, e, em->y) && cache_get(p, e, em->z) &&
+				cache_get(p, e, em->psi) && cache_get(p, e, em->the) && cache_get(p, e, em->phi) &&
+				cache_get(p, e, em->v_min) && cache_get(p, e, em->v_max);
+	}
+
+	ok = ok && cache_get(p, e, count) && count >= 0 && count <= e - p;
+	if(ok)
+	{
+		outObj.lods.resize(count);
+		for(vector<XObjLOD8>::iterator l = outObj.lods.begin(); ok && l != outObj.lods.end(); ++l)
+		{
+			ok = cache_get(p, e, l->lod_near) && cache_get(p, e, l->lod_far) &&
+				cache_get(p, e, count) && count >= 0 && count <= e - p;
+			if(ok)
+			{
+				l->cmds.resize(count);
+				for(vector<XObjCmd8>::iterator c = l->cmds.begin(); ok && c != l->cmds.end(); ++c)
+					ok = cache_get(p, e, c->cmd) && cache_get(p, e, c->params) && cache_get(p, e, c->name) &&
+						cache_get(p, e, c->idx_offset) && cache_get(p, e, c->idx_count);
+			}
+		}
+	}
+
+	ok = ok &&
+		cache_get(p, e, outObj.xyz_min) &&
+		cache_get(p, e, outObj.xyz_max) &&
+		cache_get(p, e, outObj.fixed_heading) &&
+		cache_get(p, e, outObj.description) &&
+		p == e;
+
+	return ok;
+}
+
+#if DEV
+// Field by field, bit for bit - a field the binary format forgot shows up here, where comparing the two binary dumps
+// would miss it.
+template <class T>
+static bool same_bits(const T& a, const T& b) { return memcmp(&a, &b, sizeof(T)) == 0; }
+
+template <class T>
+static bool same_bits(const vector<T>& a, const vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0);
+}
+
+static bool same_bits(const string& a, const string& b) { return a == b; }
+
+static bool same_bits(const ObjPointPool& a, const ObjPointPool& b)
+{
+	return a.depth() == b.depth() && a.count() == b.count() &&
+		(a.count() == 0 || memcmp(a.get(0), b.get(0), a.count() * a.depth() * sizeof(float)) == 0);
+}
+
+static bool XObj8Same(const XObj8& a, const XObj8& b)
+{
+	if(!same_bits(a.texture, b.texture) || !same_bits(a.texture_normal_map, b.texture_normal_map) ||
+	   !same_bits(a.texture_lit, b.texture_lit) || !same_bits(a.texture_draped, b.texture_draped) ||
+	   !same_bits(a.use_metalness, b.use_metalness) || !same_bits(a.glass_blending, b.glass_blending) ||
+	   !same_bits(a.particle_system, b.particle_system) || !same_bits(a.regions, b.regions) ||
+	   !same_bits(a.indices, b.indices) || !same_bits(a.geo_tri, b.geo_tri) ||
+	   !same_bits(a.geo_lines, b.geo_lines) || !same_bits(a.geo_lights, b.geo_lights) ||
+	   a.animation.size() != b.animation.size() || a.manips.size() != b.manips.size() ||
+	   a.emitters.size() != b.emitters.size() || a.lods.size() != b.lods.size() ||
+	   !same_bits(a.xyz_min, b.xyz_min) || !same_bits(a.xyz_max, b.xyz_max) ||
+	   !same_bits(a.fixed_heading, b.fixed_heading) || !same_bits(a.description, b.description))
+		return false;
+
+	for(int n = 0; n < a.animation.size(); ++n)
+	{
+		const XObjAnim8& x(a.animation[n]), & y(b.animation[n]);
+		if(!same_bits(x.cmd, y.cmd) || !same_bits(x.dataref, y.dataref) || !same_bits(x.axis, y.axis) ||
+		   !same_bits(x.loop, y.loop) || !same_bits(x.keyframes, y.keyframes))
+			return false;
+	}
+	for(int n = 0; n < a.manips.size(); ++n)
+	{
+		const XObjManip8& x(a.manips[n]), & y(b.manips[n]);
+		if(!same_bits(x.dataref1, y.dataref1) || !same_bits(x.dataref2, y.dataref2) ||
+		   !same_bits(x.centroid, y.centroid) || !same_bits(x.axis, y.axis) ||
+		   !same_bits(x.angle_min, y.angle_min) || !same_bits(x.angle_max, y.angle_max) || !same_bits(x.lift, y.lift) ||
+		   !same_bits(x.v1_min, y.v1_min) || !same_bits(x.v1_max, y.v1_max) ||
+		   !same_bits(x.v2_min, y.v2_min) || !same_bits(x.v2_max, y.v2_max) ||
+		   !same_bits(x.cursor, y.cursor) || !same_bits(x.tooltip, y.tooltip) ||
+		   !same_bits(x.mouse_wheel_delta, y.mouse_wheel_delta) ||
+		   !same_bits(x.rotation_key_frames, y.rotation_key_frames) || !same_bits(x.detents, y.detents))
+			return false;
+	}
+	for(int n = 0; n < a.emitters.size(); ++n)
+	{
+		const XObjEmitter8& x(a.emitters[n]), & y(b.emitters[n]);
+		if(!same_bits(x.name, y.name) || !same_bits(x.dataref, y.dataref) ||
+		   !same_bits(x.x, y.x) || !same_bits(x.y, y.y) || !same_bits(x.z, y.z) ||
+		   !same_bits(x.psi, y.psi) || !same_bits(x.the, y.the) || !same_bits(x.phi, y.phi) ||
+		   !same_bits(x.v_min, y.v_min) || !same_bits(x.v_max, y.v_max))
+			return false;
+	}
+	for(int n = 0; n < a.lods.size(); ++n)
+	{
+		const XObjLOD8& x(a.lods[n]), & y(b.lods[n]);
+		if(!same_bits(x.lod_near, y.lod_near) || !same_bits(x.lod_far, y.lod_far) || x.cmds.size() != y.cmds.size())
+			return false;
+		for(int c = 0; c < x.cmds.size(); ++c)
+		if(!same_bits(x.cmds[c].cmd, y.cmds[c].cmd) || !same_bits(x.cmds[c].params, y.cmds[c].params) ||
+		   !same_bits(x.cmds[c].name, y.cmds[c].name) ||
+		   !same_bits(x.cmds[c].idx_offset, y.cmds[c].idx_offset) || !same_bits(x.cmds[c].idx_count, y.cmds[c].idx_count))
+			return false;
+	}
+	return true;
+}
+#endif
+
+/****************************************************************************************
+ * OBJ 8 CACHE
+ ****************************************************************************************/
+
+static string	sObj8CacheFolder;
+
+void	XObj8SetCacheFolder(const string& inFolder)
+{
+	sObj8CacheFolder = inFolder;
+}
+
+// 64-bit FNV-1a of the whole file.  The cache is keyed on what's in the OBJ, not where it lives or when it was
+// touched, so copied or re-saved libraries still hit and an edited OBJ can never pick up its old geometry.
+static unsigned long long obj8_hash(const unsigned char * p, int len)
+{
+	unsigned long long h = 14695981039346656037ULL;
+	for(const unsigned char * e = p + len; p < e; ++p)
+	{
+		h ^= *p;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static bool obj8_read_cache(const string& path, XObj8& outObj)
+{
+	FILE * fi = fopen(path.c_str(), "rb");
+	if(!fi) return false;
+	fseek(fi, 0L, SEEK_END);
+	long len = ftell(fi);
+	fseek(fi, 0L, SEEK_SET);
+	vector<char> buf(len > 0 ? len : 1);
+	bool ok = len > 0 && fread(&buf[0], 1, len, fi) == len;
+	fclose(fi);
+	return ok && XObj8ReadBinary(&buf[0], &buf[0] + len, outObj);
+}
+
+static void obj8_write_cache(const string& path, const XObj8& inObj)
+{
+	string buf;
+	XObj8WriteBinary(inObj, buf);
+
+#if DEV
+	XObj8 check;
+	bool read_back = XObj8ReadBinary(buf.data(), buf.data() + buf.size(), check);
+	DebugAssert(read_back && XObj8Same(inObj, check));
+#endif
+
+	// A reader on another thread (or in another copy of the app) either finds the whole file or none of it.
+	FILE_write_file_atomic(path, buf.data(), buf.size());		// no cache next time, no big deal
+}
+
+/****************************************************************************************
+ * OBJ 8 READ
+ ****************************************************************************************/
+bool	XObj8Read(const char * inFile, XObj8& outObj)
+{
+	/*********************************************************************
+	 * READ FILE INTO MEM
+	 *********************************************************************/
+
+	FILE * objFile = fopen(inFile, "rb");
+	if (!objFile) return false;
+	fseek(objFile,0L,SEEK_END);
+	int filesize = ftell(objFile);
+	fseek(objFile,0L,SEEK_SET);
+	unsigned char * mem_buf = (unsigned char *) malloc(filesize);
+	if (mem_buf == NULL) { fclose(objFile); return false; }
+	if (fread(mem_buf, 1, filesize, objFile) != filesize)
+	{
+		free(mem_buf); fclose(objFile); return false;
+	}
+	fclose(objFile);
+
+	string cache_path;
+	if (!sObj8CacheFolder.empty())
+	{
+		char key[64];
+		snprintf(key, sizeof(key), "%016llx_%d.obj8b", obj8_hash(mem_buf, filesize), filesize);
+		cache_path = sObj8CacheFolder + DIR_STR + key;
+		if (obj8_read_cache(cache_path, outObj))
+		{
+			free(mem_buf);
+			return true;
+		}
+	}
+
+	bool ok = XObj8ReadText(mem_buf, filesize, inFile, outObj);
+	free(mem_buf);
+
+	if (ok && !cache_path.empty())
+		obj8_write_cache(cache_path, outObj);
+	return ok;
+}
+
 /****************************************************************************************
  * OBJ 8 WRITE
  ****************************************************************************************/
@@ -32,4 +32,13 @@ bool	XObjWrite(const char * inFile, const XObj& inObj);
 bool	XObj8Read(const char * inFile, XObj8& outObj);
 bool	XObj8Write(const char * inFile, const XObj8& outObj);
 
+// Binary OBJ8 - a straight dump of the XObj8 (counts followed by raw blocks) that loads with a handful of memcpys.  It is
+// only meant as a cache on the machine that wrote it: the layout is native endian and versioned, nothing more.
+void	XObj8WriteBinary(const XObj8& inObj, string& outBuf);
+bool	XObj8ReadBinary(const char * inBegin, const char * inEnd, XObj8& outObj);
+
+// If set, XObj8Read keeps a binary copy of every OBJ it parses in this folder, keyed by a hash of the file contents,
+// and loads that instead of the text the next time it sees the same file.  Empty (the default) turns the cache off.
+void	XObj8SetCacheFolder(const string& inFolder);
+
 #endif
@@ -28,7 +28,6 @@
 #include "MapDefs.h"
 #include "MapAlgs.h"
 #include "GISTool_Globals.h"
-#include <CGAL/Arr_walk_along_line_point_location.h>
 
 FAAObsTable		gFAAObs;
 
@@ -508,37 +507,38 @@ void ApplyObjects(Pmwx& ioMap)
 
 	int	placed = 0;
 
-//	CGAL::Arr_landmarks_point_location<Arrangement_2>	locator(gMap);
-	CGAL::Arr_walk_along_line_point_location<Arrangement_2>	locator(gMap);
+	DebugAssert(CGAL::is_valid(ioMap));
 
+	vector<FAAObsTable::iterator>	obs;
+	vector<Point_2>					locs;
 	for (FAAObsTable::iterator i = gFAAObs.begin(); i != gFAAObs.end(); ++i)
+	if (i->second.kind != NO_VALUE)
 	{
-		if (i->second.kind != NO_VALUE)
-		{
-			Point_2 loc = Point_2(i->second.lon, i->second.lat);
+		obs.push_back(i);
+		locs.push_back(Point_2(i->second.lon, i->second.lat));
+	}
 
-			DebugAssert(CGAL::is_valid(gMap));
-			CGAL::Object obj = locator.locate(loc);
-			Face_const_handle ff;
-			if(CGAL::assign(ff,obj))
-			{
-				Face_handle f = ioMap.non_const_handle(ff);
-				GISPointFeature_t	feat;
-					feat.mFeatType = i->second.kind;
-					feat.mLocation = loc;
-					if (i->second.agl != DEM_NO_DATA)
-						feat.mParams[pf_Height] = i->second.agl;
-					feat.mInstantiated = false;
-					f->data().mPointFeatures.push_back(feat);
-					++placed;
+	vector<Face_handle>	faces;
+	LocateFaces(ioMap, locs, faces);
+
+	for (int n = 0; n < obs.size(); ++n)
+	{
+		FAAObsTable::iterator i = obs[n];
+		Face_handle f = faces[n];
+		if (f != Face_handle())
+		{
+			GISPointFeature_t	feat;
+				feat.mFeatType = i->second.kind;
+				feat.mLocation = locs[n];
+				if (i->second.agl != DEM_NO_DATA)
+					feat.mParams[pf_Height] = i->second.agl;
+				feat.mInstantiated = false;
+				f->data().mPointFeatures.push_back(feat);
+				++placed;
 	#if 0
-					printf("Placed %s at %lf, %lf\n",
-						FetchTokenString(i->second.kind), i->second.lon, i->second.lat);
+				printf("Placed %s at %lf, %lf\n",
+					FetchTokenString(i->second.kind), i->second.lon, i->second.lat);
 	#endif
-//				if (v.size() > 1)
-//					fprintf(stderr,"WARNING (%d,%d): Point feature %lf, %lf matches multiple areas.\n",gMapWest, gMapSouth, CGAL::to_double(loc.x()), CGAL::to_double(loc.y()));
-
-			}
 		}
 	}
 	printf("Placed %d objects.\n", placed);
@@ -1364,10 +1364,14 @@ bool	ReadShapeFile(
 
 	PROGRESS_START(inFunc, 0, 1, "Reading shape file...")
 
-	CGAL::Arr_walk_along_line_point_location<Arrangement_2>	locator(io_map);
-
 	bool is_pts = shape_type == SHPT_POINT || shape_type == SHPT_POINTZ || shape_type == SHPT_POINTM;
 
+	// Read everything first, then find all the faces in one pass over the map.
+	vector<GISObjPlacement_t>		objs;
+	vector<GISPolyObjPlacement_t>	polys;
+	vector<int>						ids;
+	vector<Point_2>					locs;
+
 	int step = entity_count ? (entity_count / 150) : 2;
 	for(int n = 0; n < entity_count; ++n)
 	{
@@ -1384,20 +1388,9 @@ bool	ReadShapeFile(
 
 			SHPDestroyObject(obj);
 
-			CGAL::Object lobj = locator.locate(ben2cgal<Pmwx::Point_2>(no.mLocation));
-			Face_const_handle ff;
-			if(CGAL::assign(ff,lobj))
-			{
-				Face_handle f = io_map.non_const_handle(ff);
-				f->data().mObjs.push_back(no);
-			}
-			else
-			{
-	#if DEV
-				debug_mesh_point(no.mLocation,1,0,0);
-	#endif
-				fprintf(stderr,"WARNING: point %d could not be placed.\n", n);
-			}
+			objs.push_back(no);
+			ids.push_back(n);
+			locs.push_back(ben2cgal<Pmwx::Point_2>(no.mLocation));
 		}
 		else
 		{
@@ -1423,17 +1416,38 @@ bool	ReadShapeFile(
 			if(np.mShape.empty() || np.mShape[0].empty())
 				continue;
 
-			CGAL::Object lobj = locator.locate(ben2cgal<Pmwx::Point_2>(np.mShape[0][0]));
-			Face_const_handle ff;
-			if(CGAL::assign(ff,lobj))
+			polys.push_back(np);
+			ids.push_back(n);
+			locs.push_back(ben2cgal<Pmwx::Point_2>(np.mShape[0][0]));
+		}
+	}
+
+	vector<Face_handle>	faces;
+	LocateFaces(io_map, locs, faces);
+
+	for(int k = 0; k < ids.size(); ++k)
+	{
+		Face_handle f = faces[k];
+		if(is_pts)
+		{
+			if(f != Face_handle())
+				f->data().mObjs.push_back(objs[k]);
+			else
 			{
-				Face_handle f = io_map.non_const_handle(ff);
-				f->data().mPolyObjs.push_back(np);
+	#if DEV
+				debug_mesh_point(objs[k].mLocation,1,0,0);
+	#endif
+				fprintf(stderr,"WARNING: point %d could not be placed.\n", ids[k]);
 			}
+		}
+		else
+		{
+			if(f != Face_handle())
+				f->data().mPolyObjs.push_back(polys[k]);
 			else
 			{
 	#if DEV
-				for(vector<Polygon2>::iterator p = np.mShape.begin(); p != np.mShape.end(); ++p)
+				for(vector<Polygon2>::iterator p = polys[k].mShape.begin(); p != polys[k].mShape.end(); ++p)
 				{
 					for(Polygon2::const_side_iterator pp = p->sides_begin(); pp != p->sides_end(); ++pp)
 					{
@@ -1441,7 +1455,7 @@ bool	ReadShapeFile(
 					}
 				}
 	#endif
-				fprintf(stderr,"WARNING: polygon %d could not be placed.\n", n);
+				fprintf(stderr,"WARNING: polygon %d could not be placed.\n", ids[k]);
 			}
 		}
 	}
@@ -72,7 +72,8 @@ using std::list;
 
 
 
-bool	HandleSeg(Pmwx& inMap, double clip[4], const Point2& p1, const Point2& p2)
+// Cull segments that can't reach the crop box; the rest go into one aggregate insert once the whole file is read.
+static bool	HandleSeg(vector<Curve_2>& ioCurves, double clip[4], const Point2& p1, const Point2& p2)
 
 {
 
@@ -84,9 +85,10 @@ bool	HandleSeg(Pmwx& inMap, double clip[4], const Point2& p1, const Point2& p2)
 
 	if (p1.y() > clip[3] && p2.y() > clip[3]) return false;
 
+	if (p1 == p2) return false;								// the arrangement won't take a zero-length curve
 
-	CGAL::insert(inMap,Curve_2(Segment_2(Point_2(p1.x(),p1.y()),Point_2(p2.x(),p2.y()))));
-//	inMap.insert_edge(p1, p2, NULL, NULL);
+
+	ioCurves.push_back(Curve_2(Segment_2(Point_2(p1.x(),p1.y()),Point_2(p2.x(),p2.y()))));
 
 	return true;
 
@@ -112,7 +114,7 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 	int	k, max_east = 270000000, n_read, flip;
 
-	struct	_POINT p;
+	vector<_POINT> pts;
 
 	struct GSHHS h;
 
@@ -128,6 +130,8 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 
 
+	setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
 	n_read = fread ((void *)&h, (size_t)sizeof (struct GSHHS), (size_t)1, fp);
 
 	flip = (! (h.level > 0 && h.level < 5));	/* Take as sign that byte-swabbing is needed */
@@ -142,6 +146,10 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 
 
+	vector<Curve_2>	curves;
+
+
+
 	while (n_read == 1) {
 
 
@@ -212,17 +220,25 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 
 
-		for (k = 0; k < h.n; k++) {
+		pts.resize(h.n);
 
+		if (fread ((void *)&pts[0], (size_t)sizeof(struct _POINT), (size_t)h.n, fp) != h.n) {
 
+			fprintf (stderr, "gshhs:  Error reading file %s for polygon %d.\n", inFile, h.id);
 
-			if (fread ((void *)&p, (size_t)sizeof(struct _POINT), (size_t)1, fp) != 1) {
+			fclose (fp);
 
-				fprintf (stderr, "gshhs:  Error reading file %s for polygon %d, point %d.\n", inFile, h.id, k);
+			return false;
+
+		}
 
-				return false;
 
-			}
+
+		for (k = 0; k < h.n; k++) {
+
+
+
+			_POINT& p(pts[k]);
 
 			if (flip) {
 
@@ -240,13 +256,15 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 
 
+			now = Point2(lon, lat);
+
 			if (now.x() > 180.0) now.x_ -= 360.0;
 
 			if (k > 0)
 
 			{
 
-				if (HandleSeg(outMap, clip, last, now))
+				if (HandleSeg(curves, clip, last, now))
 
 					++keep;
 
@@ -264,7 +282,7 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 		}
 
-		if (HandleSeg(outMap, clip, now, orig))
+		if (HandleSeg(curves, clip, now, orig))
 
 			++keep;
 
@@ -282,6 +300,10 @@ bool ImportGSHHS(const char * inFile, Pmwx& outMap, double clip[4])
 
 
 
+	CGAL::insert(outMap, curves.begin(), curves.end());
+
+
+
 	printf("Read %d points, used %d points, map has %llu halfedges\n", tot, keep, (unsigned long long)outMap.number_of_halfedges());
 
 	CropMap(outMap, clip[0], clip[1], clip[2], clip[3], false , NULL);
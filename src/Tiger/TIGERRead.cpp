@@ -26,6 +26,7 @@
 #include "MemFileUtils.h"
 #include "TIGERImport.h"
 #include "CompGeomUtils.h"
+#include <thread>
 
 const double PI = 3.14159265358979323846;
 const double PI2 = PI * 2.0;
@@ -40,337 +41,382 @@ ChainInfoMap		gChains;
 LandmarkInfoMap		gLandmarks;
 PolygonInfoMap		gPolygons;
 
-inline	Point2 RawCoordToDouble(const RawCoordPair& p) { return Point2(atof(p.second.c_str()) / 1000000.0, atof(p.first.c_str()) / 1000000.0); }
+inline	Point2 RawCoordToDouble(const RawCoordPair& p) { return Point2((double) p.second / 1000000.0, (double) p.first / 1000000.0); }
 
 static	int	gPassNum = 0;
 
-// File loading routines.  Call them in the order they are listed in to
-// get correct hashing!
-
-void	TIGER_LoadRT1(MFFileSet * inSet, int inFileNumber)
+// Fields are pulled straight out of the mapped record - coordinates and IDs go from the digits to ints, and only the
+// few fields we keep as strings get copied.
+inline	RawCoordPair	ExtractRawCoord(MFTextScanner * scanner, int lonBegin, int lonEnd, int latEnd)
 {
-	// Important: we basically tag each TLID with a unique num from the file it
-	// came from.  This allows us to not load the shape points twice when loading
-	// a pair of files.
-	gPassNum++;
+	return RawCoordPair(TextScanner_ExtractLong(scanner, lonEnd, latEnd), TextScanner_ExtractLong(scanner, lonBegin, lonEnd));
+}
 
+static	MFMemFile *	TIGER_OpenRecordFile(MFFileSet * inSet, int inFileNumber, const char * inType)
+{
 	char	fname[32];
-	sprintf(fname, "TGR%05d.RT1", inFileNumber);
-	MFMemFile *	file = FileSet_OpenSpecific(inSet, fname);
-	if (file)
+	sprintf(fname, "TGR%05d.%s", inFileNumber, inType);
+	return FileSet_OpenSpecific(inSet, fname);
+}
+
+static	void	TIGER_ReadRT1(MFMemFile * file)
+{
+	MFTextScanner * scanner = TextScanner_Open(file);
+	while (!TextScanner_IsDone(scanner))
 	{
-		MFTextScanner * scanner = TextScanner_Open(file);
-		while (!TextScanner_IsDone(scanner))
+		if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
 		{
-			if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
-			{
-				TLID		tlid;
-				ChainInfo_t	ci;
-
-				tlid = TextScanner_ExtractUnsignedLong(scanner, 5, 15);
-				ci.tlid = tlid;
-				ci.one_side = TextScanner_ExtractChar(scanner, 15) == 'Y';
-				ci.owner = gPassNum;
-				ci.reversed = 0;
+			TLID		tlid;
+			ChainInfo_t	ci;
 
-				RawCoordPair	rawStart, rawEnd;
+			tlid = TextScanner_ExtractUnsignedLong(scanner, 5, 15);
+			ci.tlid = tlid;
+			ci.one_side = TextScanner_ExtractChar(scanner, 15) == 'Y';
+			ci.owner = gPassNum;
+			ci.reversed = 0;
 
 #if USE_STREET_NAMES
-				TextScanner_ExtractString(scanner, 19, 49, ci.name, true);
+			TextScanner_ExtractString(scanner, 19, 49, ci.name, true);
 #endif
-				TextScanner_ExtractString(scanner, 55, 58, ci.cfcc, false);
-				TextScanner_ExtractString(scanner, 190,200, rawStart.second, true);
-				TextScanner_ExtractString(scanner, 200,209, rawStart.first, true);
-				TextScanner_ExtractString(scanner, 209,219, rawEnd.second, true);
-				TextScanner_ExtractString(scanner, 219,228, rawEnd.first, true);
-				ci.start = rawStart.first + rawStart.second;
-				ci.end   = rawEnd.first + rawEnd.second;
-				ci.shape.push_back(RawCoordToDouble(rawStart));
-				ci.shape.push_back(RawCoordToDouble(rawEnd));
-
-				ChainInfoMap::iterator tlidP = gChains.find(tlid);
-				if (tlidP == gChains.end())
-					gChains.insert(ChainInfoMap::value_type(tlid, ci));
-				else {
-					// We need to note whether the other file has us reversed.  In one supremely nasty
-					// case, we have a closed-loop TLID - in that case, who @#$@#ing knows whether it's reversed??
-					if (ci.start == ci.end && tlidP->second.start == tlidP->second.end && tlidP->second.start == ci.start)
-						tlidP->second.reversed = 2;
-					else if (ci.start == tlidP->second.end && ci.end == tlidP->second.start)
-						tlidP->second.reversed = 1;
-					else if (ci.start == tlidP->second.start && ci.end == tlidP->second.end)
-						tlidP->second.reversed = 0;
-					else
-						fprintf(stderr,"ERROR: TLID %d has different vertices in this file than the last.\n", tlid);
-				}
-
-				NodeInfo_t		node;
-				if (gNodes.find(ci.start) == gNodes.end())
-				{
-					node.location = RawCoordToDouble(rawStart);
-					gNodes.insert(NodeInfoMap::value_type(ci.start, node));
-				}
-				if (gNodes.find(ci.end) == gNodes.end())
-				{
-					node.location = RawCoordToDouble(rawEnd);
-					gNodes.insert(NodeInfoMap::value_type(ci.end, node));
-				}
+			TextScanner_ExtractString(scanner, 55, 58, ci.cfcc, false);
+			RawCoordPair	rawStart = ExtractRawCoord(scanner, 190, 200, 209);
+			RawCoordPair	rawEnd   = ExtractRawCoord(scanner, 209, 219, 228);
+			ci.start = RawCoordToKey(rawStart);
+			ci.end   = RawCoordToKey(rawEnd);
+			ci.shape.push_back(RawCoordToDouble(rawStart));
+			ci.shape.push_back(RawCoordToDouble(rawEnd));
+
+			pair<ChainInfoMap::iterator, bool> tlidP = gChains.insert(ChainInfoMap::value_type(tlid, ci));
+			if (!tlidP.second)
+			{
+				ChainInfo_t& old(tlidP.first->second);
+				// We need to note whether the other file has us reversed.  In one supremely nasty
+				// case, we have a closed-loop TLID - in that case, who @#$@#ing knows whether it's reversed??
+				if (ci.start == ci.end && old.start == old.end && old.start == ci.start)
+					old.reversed = 2;
+				else if (ci.start == old.end && ci.end == old.start)
+					old.reversed = 1;
+				else if (ci.start == old.start && ci.end == old.end)
+					old.reversed = 0;
+				else
+					fprintf(stderr,"ERROR: TLID %d has different vertices in this file than the last.\n", tlid);
 			}
 
-			TextScanner_Next(scanner);
+			// insert leaves a node that is already there alone, so one hash per end.
+			NodeInfo_t		node;
+			node.location = RawCoordToDouble(rawStart);
+			gNodes.insert(NodeInfoMap::value_type(ci.start, node));
+			node.location = RawCoordToDouble(rawEnd);
+			gNodes.insert(NodeInfoMap::value_type(ci.end, node));
 		}
 
-		TextScanner_Close(scanner);
-		MemFile_Close(file);
+		TextScanner_Next(scanner);
 	}
+
+	TextScanner_Close(scanner);
 }
 
-void	TIGER_LoadRT2(MFFileSet * inSet, int inFileNumber)
+static	void	TIGER_ReadRT2(MFMemFile * file)
 {
-	char	fname[32];
-	sprintf(fname, "TGR%05d.RT2", inFileNumber);
-	MFMemFile *	file = FileSet_OpenSpecific(inSet, fname);
-	if (file)
+	MFTextScanner * scanner = TextScanner_Open(file);
+	while (!TextScanner_IsDone(scanner))
 	{
-		MFTextScanner * scanner = TextScanner_Open(file);
-		while (!TextScanner_IsDone(scanner))
+		if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
 		{
-			if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
-			{
-				TLID		tlid;
+			TLID		tlid;
 
-				tlid = TextScanner_ExtractUnsignedLong(scanner, 5, 15);
+			tlid = TextScanner_ExtractUnsignedLong(scanner, 5, 15);
 
-				ChainInfo_t&	ci = gChains[tlid];
-				if (ci.owner == gPassNum)
+			ChainInfo_t&	ci = gChains[tlid];
+			if (ci.owner == gPassNum)
+			{
+				for (int n = 0; n < 10; ++n)
 				{
-					for (int n = 0; n < 10; ++n)
+					RawCoordPair	cp = ExtractRawCoord(scanner, 18 + 19 * n, 28 + 19 * n, 37 + 19 * n);
+
+					// Blank and zero slots are both unused.
+					if (cp.first != 0 && cp.second != 0)
 					{
-						RawCoordPair	cp;
-						TextScanner_ExtractString(scanner, 18 + 19 * n, 28 + 19 * n, cp.second, true);
-						TextScanner_ExtractString(scanner, 28 + 19 * n, 37 + 19 * n, cp.first, true);
-
-						if ((!cp.first.empty()) &&
-							(!cp.second.empty()) &&
-							(atoi(cp.first.c_str()) != 0) &&
-							(atoi(cp.second.c_str()) != 0))
-						{
-							// IMPORTANT: Little did I realize that the tiger-line data has shape points
-							// on chains that are NOT distinct from either adjacent shape points or the end
-							// points.  So eliminate these shape points, so that we don't have zero-lengthed
-							// halfedges.
-							Point2	p(RawCoordToDouble(cp));
-							if (p != ci.shape[ci.shape.size()-2])
-								ci.shape.insert(ci.shape.end()-1, p);
-						}
+						// IMPORTANT: Little did I realize that the tiger-line data has shape points
+						// on chains that are NOT distinct from either adjacent shape points or the end
+						// points.  So eliminate these shape points, so that we don't have zero-lengthed
+						// halfedges.
+						Point2	p(RawCoordToDouble(cp));
+						if (p != ci.shape[ci.shape.size()-2])
+							ci.shape.insert(ci.shape.end()-1, p);
 					}
 				}
 			}
-
-			TextScanner_Next(scanner);
 		}
 
-		TextScanner_Close(scanner);
-		MemFile_Close(file);
+		TextScanner_Next(scanner);
 	}
+
+	TextScanner_Close(scanner);
 }
 
-void	TIGER_LoadRTP(MFFileSet * inSet, int inFileNumber)
+static	void	TIGER_ReadRTP(MFMemFile * file)
 {
-	char	fname[32];
-	sprintf(fname, "TGR%05d.RTP", inFileNumber);
-	MFMemFile *	file = FileSet_OpenSpecific(inSet, fname);
-	if (file)
+	MFTextScanner * scanner = TextScanner_Open(file);
+	while (!TextScanner_IsDone(scanner))
 	{
-		MFTextScanner * scanner = TextScanner_Open(file);
-		while (!TextScanner_IsDone(scanner))
+		if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
 		{
-			if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
-			{
 
-				CENID_POLYID	id;
-				PolygonInfo_t	info;
-				info.isWorld = false;
-				RawCoordPair	rawLoc;
-				TextScanner_ExtractString(scanner, 10, 25, id, true);
-				TextScanner_ExtractString(scanner, 35, 44, rawLoc.first, true);
-				TextScanner_ExtractString(scanner, 25, 35, rawLoc.second, true);
-				info.water = (TextScanner_ExtractChar(scanner, 44) == '1') ? 1 : 0;
-				info.location = RawCoordToDouble(rawLoc);
-				gPolygons.insert(PolygonInfoMap::value_type(id, info));
-			}
-			TextScanner_Next(scanner);
+			CENID_POLYID	id;
+			PolygonInfo_t	info;
+			info.isWorld = false;
+			TextScanner_ExtractString(scanner, 10, 25, id, true);
+			RawCoordPair	rawLoc = ExtractRawCoord(scanner, 25, 35, 44);
+			info.water = (TextScanner_ExtractChar(scanner, 44) == '1') ? 1 : 0;
+			info.location = RawCoordToDouble(rawLoc);
+			gPolygons.insert(PolygonInfoMap::value_type(id, info));
 		}
-
-		TextScanner_Close(scanner);
-		MemFile_Close(file);
+		TextScanner_Next(scanner);
 	}
+
+	TextScanner_Close(scanner);
 }
 
-void	TIGER_LoadRTI(MFFileSet * inSet, int inFileNumber)
+static	void	TIGER_ReadRTI(MFMemFile * file)
 {
-	char	fname[32];
-	sprintf(fname, "TGR%05d.RTI", inFileNumber);
-	MFMemFile *	file = FileSet_OpenSpecific(inSet, fname);
-	if (file)
+	MFTextScanner * scanner = TextScanner_Open(file);
+	while (!TextScanner_IsDone(scanner))
 	{
-		MFTextScanner * scanner = TextScanner_Open(file);
-		while (!TextScanner_IsDone(scanner))
+		if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
 		{
-			if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
-			{
-				CENID_POLYID	rid, lid;
-				TLID			tlid;
+			CENID_POLYID	rid, lid;
+			TLID			tlid;
 
-				TextScanner_ExtractString(scanner, 40, 55, lid, true);
-				TextScanner_ExtractString(scanner, 55, 70, rid, true);
-				tlid = TextScanner_ExtractUnsignedLong(scanner, 10, 20);
+			TextScanner_ExtractString(scanner, 40, 55, lid, true);
+			TextScanner_ExtractString(scanner, 55, 70, rid, true);
+			tlid = TextScanner_ExtractUnsignedLong(scanner, 10, 20);
 
-				ChainInfoMap::iterator citer = gChains.find(tlid);
-				if (citer == gChains.end())
-					fprintf(stderr,"ERROR: unknown TLID %d for polys %s, %s\n", tlid, lid.c_str(), rid.c_str());
-				else if (citer->second.reversed == 1)
-				{
-					swap(rid, lid);
-				}
-				else if (citer->second.reversed == 2)
-				{
-					// Tough case - we don't know if this TLID is reversed because the start and end nodes are the same.
-					// Well, we must be the second file to have this TLID, so...see which side is filled in.
+			ChainInfoMap::iterator citer = gChains.find(tlid);
+			if (citer == gChains.end())
+				fprintf(stderr,"ERROR: unknown TLID %d for polys %s, %s\n", tlid, lid.c_str(), rid.c_str());
+			else if (citer->second.reversed == 1)
+			{
+				swap(rid, lid);
+			}
+			else if (citer->second.reversed == 2)
+			{
+				// Tough case - we don't know if this TLID is reversed because the start and end nodes are the same.
+				// Well, we must be the second file to have this TLID, so...see which side is filled in.
 #if DEV
-					if (lid.empty() && rid.empty())
-						fprintf(stderr, "ASSERTION failure - no poly for either side of antenna.\n");
-					if (!lid.empty() && !rid.empty())
-						fprintf(stderr, "ASSERTION failure - we should have at least one empty side if we are shared.\n");
-					if (citer->second.lpoly.empty() && citer->second.rpoly.empty())
-						fprintf(stderr, "ASSERTION failure - no polygon on either side of the TLID from the last file.\n");
-					if (!citer->second.lpoly.empty() && !citer->second.rpoly.empty())
-						fprintf(stderr, "ASSERTION failure - no free slot on either side of the TLID from the last file.\n");
+				if (lid.empty() && rid.empty())
+					fprintf(stderr, "ASSERTION failure - no poly for either side of antenna.\n");
+				if (!lid.empty() && !rid.empty())
+					fprintf(stderr, "ASSERTION failure - we should have at least one empty side if we are shared.\n");
+				if (citer->second.lpoly.empty() && citer->second.rpoly.empty())
+					fprintf(stderr, "ASSERTION failure - no polygon on either side of the TLID from the last file.\n");
+				if (!citer->second.lpoly.empty() && !citer->second.rpoly.empty())
+					fprintf(stderr, "ASSERTION failure - no free slot on either side of the TLID from the last file.\n");
 #endif
-					// If we have no left poly, but we have an empty slot on the TLID already we must be reversed.
-					if (lid.empty() && citer->second.lpoly.empty())
-						swap(rid,lid);
-				}
+				// If we have no left poly, but we have an empty slot on the TLID already we must be reversed.
+				if (lid.empty() && citer->second.lpoly.empty())
+					swap(rid,lid);
+			}
 
-				if (!lid.empty())
+			// Borders just collect here - TIGER_RoughCull sorts out duplicates once, up front.
+			if (!lid.empty())
+			{
+				PolygonInfoMap::iterator liter = gPolygons.find(lid);
+				if (liter != gPolygons.end())
 				{
-					PolygonInfoMap::iterator liter = gPolygons.find(lid);
-					if (liter != gPolygons.end())
-					{
-						liter->second.border.insert(tlid);
-					}
+					liter->second.border.push_back(tlid);
 				}
+			}
 
-				if (!rid.empty())
+			if (!rid.empty())
+			{
+				PolygonInfoMap::iterator riter = gPolygons.find(rid);
+				if (riter != gPolygons.end())
 				{
-					PolygonInfoMap::iterator riter = gPolygons.find(rid);
-					if (riter != gPolygons.end())
-					{
-						riter->second.border.insert(tlid);
-					}
+					riter->second.border.push_back(tlid);
 				}
+			}
 
-				if (citer != gChains.end())
+			if (citer != gChains.end())
+			{
+				// Only set the poly IDs for the chain if its
+				// not the outside.  This way we will merge adjacent files.
+				if (!lid.empty())
 				{
-					// Only set the poly IDs for the chain if its
-					// not the outside.  This way we will merge adjacent files.
-					if (!lid.empty())
-					{
-						if (!citer->second.lpoly.empty())
-							fprintf(stderr,"ERROR: TLID %d has lpoly claimed by %s and %s\n",
-								tlid, lid.c_str(), citer->second.lpoly.c_str());
-						citer->second.lpoly = lid;
-					}
-					if (!rid.empty())
-					{
-						if (!citer->second.rpoly.empty())
-							fprintf(stderr,"ERROR: TLID %d has rpoly claimed by %s and %s\n",
-								tlid, rid.c_str(), citer->second.rpoly.c_str());
-						citer->second.rpoly = rid;
-					}
+					if (!citer->second.lpoly.empty())
+						fprintf(stderr,"ERROR: TLID %d has lpoly claimed by %s and %s\n",
+							tlid, lid.c_str(), citer->second.lpoly.c_str());
+					citer->second.lpoly = lid;
+				}
+				if (!rid.empty())
+				{
+					if (!citer->second.rpoly.empty())
+						fprintf(stderr,"ERROR: TLID %d has rpoly claimed by %s and %s\n",
+							tlid, rid.c_str(), citer->second.rpoly.c_str());
+					citer->second.rpoly = rid;
 				}
 			}
-			TextScanner_Next(scanner);
 		}
-
-		TextScanner_Close(scanner);
-		MemFile_Close(file);
+		TextScanner_Next(scanner);
 	}
-}
 
+	TextScanner_Close(scanner);
+}
 
-void	TIGER_LoadRT7(MFFileSet * inSet, int inFileNumber)
+static	void	TIGER_ReadRT7(MFMemFile * file, int inFileNumber)
 {
-	char	fname[32];
-	sprintf(fname, "TGR%05d.RT7", inFileNumber);
-	MFMemFile *	file = FileSet_OpenSpecific(inSet, fname);
-	if (file)
+	MFTextScanner * scanner = TextScanner_Open(file);
+	while (!TextScanner_IsDone(scanner))
 	{
-		MFTextScanner * scanner = TextScanner_Open(file);
-		while (!TextScanner_IsDone(scanner))
+		if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
 		{
-			if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
-			{
-				LAND			landID;
-				LandmarkInfo_t	info_t;
+			LAND			landID;
+			LandmarkInfo_t	info_t;
 
-				landID = TextScanner_ExtractUnsignedLong(scanner, 10, 20);
-				landID = landID * 100000 + inFileNumber;
+			landID = TextScanner_ExtractUnsignedLong(scanner, 10, 20);
+			landID = landID * 100000 + inFileNumber;
 
-				RawCoordPair	rawLoc;
-				TextScanner_ExtractString(scanner, 21, 24, info_t.cfcc, false);
+			TextScanner_ExtractString(scanner, 21, 24, info_t.cfcc, false);
 #if USE_LANDMARK_NAMES
-				TextScanner_ExtractString(scanner, 24, 54, info_t.name, true);
+			TextScanner_ExtractString(scanner, 24, 54, info_t.name, true);
 #endif
-				TextScanner_ExtractString(scanner, 54, 64, rawLoc.second, true);
-				TextScanner_ExtractString(scanner, 64, 73, rawLoc.first, true);
-				info_t.location = RawCoordToDouble(rawLoc);
-				if (gLandmarks.find(landID) != gLandmarks.end())
-				{
-					if (gLandmarks[landID].cfcc != info_t.cfcc)
-						fprintf(stderr,"ERROR: Landmark type conflict.\n");
-				}
-				gLandmarks.insert(LandmarkInfoMap::value_type(landID, info_t));
-			}
-			TextScanner_Next(scanner);
+			info_t.location = RawCoordToDouble(ExtractRawCoord(scanner, 54, 64, 73));
+			pair<LandmarkInfoMap::iterator, bool> landP = gLandmarks.insert(LandmarkInfoMap::value_type(landID, info_t));
+			if (!landP.second && landP.first->second.cfcc != info_t.cfcc)
+				fprintf(stderr,"ERROR: Landmark type conflict.\n");
+		}
+		TextScanner_Next(scanner);
+	}
+
+	TextScanner_Close(scanner);
+}
+
+static	void	TIGER_ReadRT8(MFMemFile * file, int inFileNumber)
+{
+	MFTextScanner * scanner = TextScanner_Open(file);
+	while (!TextScanner_IsDone(scanner))
+	{
+		if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
+		{
+			LAND			landID;
+
+			landID = TextScanner_ExtractUnsignedLong(scanner, 25, 35);
+			landID = landID * 100000 + inFileNumber;
+
+			LandmarkInfo_t&	info = gLandmarks[landID];
+			CENID_POLYID id;
+			TextScanner_ExtractString(scanner, 10, 25, id, true);
+			info.cenid_polyid.push_back(id);
 		}
 
-		TextScanner_Close(scanner);
+		TextScanner_Next(scanner);
+	}
+
+	TextScanner_Close(scanner);
+}
+
+// File loading routines.  Call them in the order they are listed in to
+// get correct hashing!
+
+void	TIGER_LoadRT1(MFFileSet * inSet, int inFileNumber)
+{
+	// Important: we basically tag each TLID with a unique num from the file it
+	// came from.  This allows us to not load the shape points twice when loading
+	// a pair of files.
+	gPassNum++;
+
+	MFMemFile *	file = TIGER_OpenRecordFile(inSet, inFileNumber, "RT1");
+	if (file)
+	{
+		TIGER_ReadRT1(file);
 		MemFile_Close(file);
 	}
 }
 
-void	TIGER_LoadRT8(MFFileSet * inSet, int inFileNumber)
+void	TIGER_LoadRT2(MFFileSet * inSet, int inFileNumber)
 {
-	char	fname[32];
-	sprintf(fname, "TGR%05d.RT8", inFileNumber);
-	MFMemFile *	file = FileSet_OpenSpecific(inSet, fname);
+	MFMemFile *	file = TIGER_OpenRecordFile(inSet, inFileNumber, "RT2");
 	if (file)
 	{
-		MFTextScanner * scanner = TextScanner_Open(file);
-		while (!TextScanner_IsDone(scanner))
-		{
-			if (TextScanner_GetBegin(scanner) != TextScanner_GetEnd(scanner))
-			{
-				LAND			landID;
+		TIGER_ReadRT2(file);
+		MemFile_Close(file);
+	}
+}
 
-				landID = TextScanner_ExtractUnsignedLong(scanner, 25, 35);
-				landID = landID * 100000 + inFileNumber;
+void	TIGER_LoadRTP(MFFileSet * inSet, int inFileNumber)
+{
+	MFMemFile *	file = TIGER_OpenRecordFile(inSet, inFileNumber, "RTP");
+	if (file)
+	{
+		TIGER_ReadRTP(file);
+		MemFile_Close(file);
+	}
+}
 
-				LandmarkInfo_t&	info = gLandmarks[landID];
-				CENID_POLYID id;
-				TextScanner_ExtractString(scanner, 10, 25, id, true);
-				info.cenid_polyid.push_back(id);
-			}
+void	TIGER_LoadRTI(MFFileSet * inSet, int inFileNumber)
+{
+	MFMemFile *	file = TIGER_OpenRecordFile(inSet, inFileNumber, "RTI");
+	if (file)
+	{
+		TIGER_ReadRTI(file);
+		MemFile_Close(file);
+	}
+}
 
-			TextScanner_Next(scanner);
-		}
+void	TIGER_LoadRT7(MFFileSet * inSet, int inFileNumber)
+{
+	MFMemFile *	file = TIGER_OpenRecordFile(inSet, inFileNumber, "RT7");
+	if (file)
+	{
+		TIGER_ReadRT7(file, inFileNumber);
+		MemFile_Close(file);
+	}
+}
 
-		TextScanner_Close(scanner);
+void	TIGER_LoadRT8(MFFileSet * inSet, int inFileNumber)
+{
+	MFMemFile *	file = TIGER_OpenRecordFile(inSet, inFileNumber, "RT8");
+	if (file)
+	{
+		TIGER_ReadRT8(file, inFileNumber);
 		MemFile_Close(file);
 	}
 }
 
+void	TIGER_LoadFileSet(MFFileSet * inSet, int inFileNumber)
+{
+	gPassNum++;
+
+	// Open everything up front on this thread - a zipped file set shares one unzip handle, so only the parsing
+	// can go wide.
+	MFMemFile *	rt1 = TIGER_OpenRecordFile(inSet, inFileNumber, "RT1");
+	MFMemFile *	rt2 = TIGER_OpenRecordFile(inSet, inFileNumber, "RT2");
+	MFMemFile *	rtp = TIGER_OpenRecordFile(inSet, inFileNumber, "RTP");
+	MFMemFile *	rti = TIGER_OpenRecordFile(inSet, inFileNumber, "RTI");
+	MFMemFile *	rt7 = TIGER_OpenRecordFile(inSet, inFileNumber, "RT7");
+	MFMemFile *	rt8 = TIGER_OpenRecordFile(inSet, inFileNumber, "RT8");
+
+	// Chains (RT1, then its shapes from RT2), polygons (RTP) and landmarks (RT7, then RT8's polygon links) each
+	// only touch their own table, so the three go side by side.  RTI ties chains to polygons and waits for both.
+	thread	chains([&]() {
+		if (rt1) TIGER_ReadRT1(rt1);
+		if (rt2) TIGER_ReadRT2(rt2);
+	});
+	thread	landmarks([&]() {
+		if (rt7) TIGER_ReadRT7(rt7, inFileNumber);
+		if (rt8) TIGER_ReadRT8(rt8, inFileNumber);
+	});
+	if (rtp) TIGER_ReadRTP(rtp);
+	chains.join();
+	landmarks.join();
+	if (rti) TIGER_ReadRTI(rti);
+
+	MFMemFile *	files[6] = { rt1, rt2, rtp, rti, rt7, rt8 };
+	for (int n = 0; n < 6; ++n)
+	if (files[n])
+		MemFile_Close(files[n]);
+}
+
 
 bool	SegmentOutOfBounds(const Point2& start, const Point2& end,
 						double inWest, double inSouth, double inEast, double inNorth)
@@ -450,12 +496,25 @@ void	TIGER_RoughCull(double inWest, double inSouth, double inEast, double inNort
 		ChainInfo_t *							chain;
 		ChainInfoMap::iterator					chainIter;
 		PolygonInfoMap::iterator 				polyIter;
-		TLIDSet::iterator			 			tlidIter;
+		TLIDVector::iterator		 			tlidIter;
 
 		bool									has_world;
 		bool									has_inside;
 
 
+	/* STEP 0 - TIDY BORDERS
+	 *
+	 * RTI loading just appends TLIDs to the borders; a TLID can be listed more than once, e.g. when two files share
+	 * it.  Make each border a sorted list of distinct TLIDs - the passes below erase a chain the first time they
+	 * see it go dead. */
+
+	for (polyIter = gPolygons.begin(); polyIter != gPolygons.end(); ++polyIter)
+	{
+		TLIDVector& border(polyIter->second.border);
+		sort(border.begin(), border.end());
+		border.erase(unique(border.begin(), border.end()), border.end());
+	}
+
 	/* STEP 1 - MARK ALL CHAINS THAT ARE OUT OF BOUNDS
 	 *
 	 * Do this once up front and cache the results. */
@@ -609,6 +668,9 @@ void	TIGER_PostProcess(Pmwx& ioMap)
 		WTPM_FaceVector		faces;
 		PolygonInfo_t		worldPoly;
 
+	lines.reserve(gChains.size());
+	faces.reserve(gPolygons.size() + 1);
+
 	// First build the world polygon
 	worldPoly.isWorld = true;
 	worldPoly.water = 1;
@@ -636,12 +698,12 @@ void	TIGER_PostProcess(Pmwx& ioMap)
 
 		NodeInfoMap::iterator startIter = gNodes.find(chainIter->second.start);
 		if (startIter == gNodes.end())
-			fprintf(stderr,"ASSERTON FAILED: Unknown start node %sfor chain %d\n", chainIter->second.start.c_str(), chainIter->first);
+			fprintf(stderr,"ASSERTON FAILED: Unknown start node %016llx for chain %d\n", chainIter->second.start, chainIter->first);
 		chainIter->second.startNode = &startIter->second;
 
 		NodeInfoMap::iterator endIter = gNodes.find(chainIter->second.end);
 		if (endIter == gNodes.end())
-			fprintf(stderr,"ASSERTON FAILED: Unknown end node %sfor chain %d\n", chainIter->second.end.c_str(), chainIter->first);
+			fprintf(stderr,"ASSERTON FAILED: Unknown end node %016llx for chain %d\n", chainIter->second.end, chainIter->first);
 		chainIter->second.endNode = &endIter->second;
 
 		lines.push_back(&chainIter->second);
@@ -649,8 +711,6 @@ void	TIGER_PostProcess(Pmwx& ioMap)
 #if !TIGER_DEBUG_LEAVE_INFO
 		chainIter->second.lpoly.clear();
 		chainIter->second.rpoly.clear();
-		chainIter->second.start.clear();
-		chainIter->second.end.clear();
 #endif
 	}
 
@@ -666,26 +726,24 @@ void	TIGER_PostProcess(Pmwx& ioMap)
 	for (PolygonInfoMap::iterator polyIter = gPolygons.begin(); polyIter != gPolygons.end(); ++polyIter)
 	{
 #if !TIGER_DEBUG_LEAVE_INFO
-		polyIter->second.border.clear();
+		TLIDVector().swap(polyIter->second.border);
 #endif
 	}
 
 	// Now that we've back-linked, cull nodes.  If some halfedges were removed, we'll have stale nodes.
-	// Collect them, then destory them.
-
-		set<RawCoordKey>	nuke;
+	// Destroy them as we go and build the node table from the valid ones that are left.
 
-	for (NodeInfoMap::iterator nodeIter = gNodes.begin(); nodeIter != gNodes.end(); ++nodeIter)
+	nodes.reserve(gNodes.size());
+	for (NodeInfoMap::iterator nodeIter = gNodes.begin(); nodeIter != gNodes.end(); )
 	{
 		if (nodeIter->second.lines.empty())
-			nuke.insert(nodeIter->first);
+			nodeIter = gNodes.erase(nodeIter);
+		else
+		{
+			nodes.push_back(&nodeIter->second);
+			++nodeIter;
+		}
 	}
-	for (set<RawCoordKey>::iterator nukeIter = nuke.begin(); nukeIter != nuke.end(); ++nukeIter)
-		gNodes.erase(*nukeIter);
-
-	// Now we build the node table, with only valid nodes.
-	for (NodeInfoMap::iterator nodeIter = gNodes.begin(); nodeIter != gNodes.end(); ++nodeIter)
-		nodes.push_back(&nodeIter->second);
 
 	WTPM_RestoreTopology(nodes, lines, faces);
 	if (gWTPMErrors)
@@ -45,6 +45,9 @@ void	TIGER_LoadRTI(MFFileSet * inSet, int inFileNumber);	// Polygon Border Info
 void	TIGER_LoadRT7(MFFileSet * inSet, int inFileNumber);	// Landmarks
 void	TIGER_LoadRT8(MFFileSet * inSet, int inFileNumber);	// Polygon Landmarks
 
+// All six of the above for one county, in the right order - the independent record types are parsed in parallel.
+void	TIGER_LoadFileSet(MFFileSet * inSet, int inFileNumber);
+
 // Once you have loaded all of the TIGER/Line files you want, call this
 // once.  This routine rebuilds the topological relationships between the
 // files, so it should only be done once after all adjacent counties are read in.
@@ -44,9 +44,9 @@ typedef	unsigned long	TLID;
 // CFCCs are 3-char codes that describe what a feature is
 typedef	string			CFCC;
 
-// Until we finish processing and correlating the data, we store lat/lons as strings
-// so that we get a perfect match (no risk of hashing problems)
-typedef	string			RawCoord;
+// TIGER stores lat/lons as fixed-width signed ints in millionths of a degree.  Until we finish processing and
+// correlating the data, we keep them as those ints so that we get a perfect match (no risk of hashing problems).
+typedef	long			RawCoord;
 
 // Land codes are ints that identify a landmark; hash with county ID to be safe
 typedef	unsigned long	LAND;
@@ -56,14 +56,16 @@ typedef	unsigned long	LAND;
 // safe way to do it.
 typedef	string			CENID_POLYID;
 
-typedef	string			RawCoordKey;
+// Lat and lon packed into one int - both fit in 32 bits, so the key is exact.
+typedef	unsigned long long	RawCoordKey;
 
-typedef	pair<RawCoord, RawCoord>	RawCoordPair;
-//typedef	vector<TLID>				TLIDVector;
-typedef set<TLID>					TLIDSet;
+typedef	pair<RawCoord, RawCoord>	RawCoordPair;		// lat, lon
+typedef	vector<TLID>				TLIDVector;
 //typedef	pair<TLID, bool>			DirectedTLID;
 //typedef	vector<DirectedTLID>		DirectedTLIDVector;
 
+inline	RawCoordKey	RawCoordToKey(const RawCoordPair& p) { return ((RawCoordKey) (unsigned int) p.first << 32) | (unsigned int) p.second; }
+
 struct	NodeInfo_t : public WTPM_Node {
 
 };
@@ -101,8 +103,9 @@ struct	LandmarkInfo_t {
 typedef	hash_map<LAND, LandmarkInfo_t>	LandmarkInfoMap;
 
 struct	PolygonInfo_t : public WTPM_Face {
-	TLIDSet						border;		// NOTE: this only exists to allow us to do rough
+	TLIDVector					border;		// NOTE: this only exists to allow us to do rough
 											// culling.  WTPM handles back-links for us for topo integration.
+											// Sorted and unique once TIGER_RoughCull starts.
 	Point2						location;	// Some point within the entity
 	int							water;		// Water code - is this polygon wet?
 
@@ -30,7 +30,9 @@
 #if LIN || APL
 #include <dirent.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
+#include <atomic>
 
 #include "zip.h"
 
@@ -345,6 +347,42 @@ int FILE_rename_file(const char * old_name, const char * new_name)
 	return 0;
 }
 
+int FILE_write_file_atomic(const string& path, const void * data, size_t len)
+{
+	static atomic<unsigned int> call_id(0);
+#if IBM
+	unsigned long pid = GetCurrentProcessId();
+#else
+	unsigned long pid = getpid();
+#endif
+	string tmp_path = path + "." + to_string(pid) + "." + to_string(call_id++) + ".tmp";
+
+	FILE * fi = fopen(tmp_path.c_str(), "wb");
+	if(!fi) return -1;
+	bool ok = fwrite(data, 1, len, fi) == len;
+	ok = (fclose(fi) == 0) && ok;
+	if(!ok)
+	{
+		FILE_delete_file(tmp_path.c_str(), false);
+		return -1;
+	}
+#if IBM
+	// MoveFileW won't replace an existing file, which is the whole point here.
+	if(!MoveFileExW(convert_str_to_utf16(tmp_path).c_str(), convert_str_to_utf16(path).c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		int err = GetLastError();
+		FILE_delete_file(tmp_path.c_str(), false);
+		return err;
+	}
+	return 0;
+#else
+	int err = FILE_rename_file(tmp_path.c_str(), path.c_str());
+	if(err)
+		FILE_delete_file(tmp_path.c_str(), false);
+	return err;
+#endif
+}
+
 int FILE_get_directory(const string& path, vector<string> * out_files, vector<string> * out_dirs)
 {
 #if IBM
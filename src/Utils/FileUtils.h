@@ -107,6 +107,11 @@ int FILE_read_file_to_string(const string& path, string& content);
 // Returns 0 for success, else last_error
 int FILE_rename_file(const char * old_name, const char * new_name);
 
+// Writes the whole of data to path by way of a temp file next to it (named for this process and call) that is then
+// renamed over path - anyone who has the old file open or memory-mapped keeps a complete copy, never a truncated one.
+// Returns 0 for success, else -1 or last_error; on failure path is left as it was.
+int FILE_write_file_atomic(const string& path, const void * data, size_t len);
+
 // Create in_dir in its parent directory
 // Returns 0 for success, else last_error
 int FILE_make_dir(const char * in_dir);
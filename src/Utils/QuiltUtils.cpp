@@ -22,13 +22,12 @@
  */
 
 #include <assert.h>
+#include <thread>
+#include <atomic>
+#include <random>
 #include "QuiltUtils.h"
 #include "BitmapUtils.h"
 
-#if IBM
-#define random rand
-#endif
-
 void	quilt_images(
 					struct ImageInfo& lhs,
 					struct ImageInfo& rhs,
@@ -46,13 +45,13 @@ void	quilt_images(
 	assert(lhs.width==res.width);
 	assert(lhs.height==res.height);
 
-	const unsigned long * s1 = (const unsigned long *) lhs.data;
-	const unsigned long * s2 = (const unsigned long *) rhs.data;
-	unsigned long * d  = (unsigned long *) res.data;
+	const quilt_pixel_t * s1 = (const quilt_pixel_t *) lhs.data;
+	const quilt_pixel_t * s2 = (const quilt_pixel_t *) rhs.data;
+	quilt_pixel_t * d  = (quilt_pixel_t *) res.data;
 
 	vector<int> l, b, r, t;
 
-	calc_four_cuts<unsigned long, unsigned long>(
+	calc_four_cuts<quilt_pixel_t, quilt_error_t>(
 						s1, 1, lhs.width + lhs.pad / 4,
 						s2, 1, rhs.width + rhs.pad / 4,
 						lhs.width, lhs.height,
@@ -64,7 +63,7 @@ void	quilt_images(
 					l,b,r,t);
 
 
-	copy_cut_edges<unsigned long>(
+	copy_cut_edges<quilt_pixel_t>(
 									s1, 1, lhs.width + lhs.pad / 4,
 									s2, 1, rhs.width + rhs.pad / 4,
 									d, 1, res.width + res.pad / 4,
@@ -73,55 +72,85 @@ void	quilt_images(
 
 }
 
-const unsigned long *	grab_patch(const unsigned long * base, int dx, int dy, int w, int h, int tile_size)
+// Run func(0..n-1), spread over all cores if threaded.  Work is handed out one index at a time, so the caller must not
+// care about the order - every index has to produce its result independently of the others.
+template <typename Func>
+static void	quilt_parallel_for(int n, bool threaded, const Func& func)
+{
+	int num_threads = threaded ? min<int>(n, max<int>(1, thread::hardware_concurrency())) : 1;
+	if(num_threads <= 1)
+	{
+		for(int i = 0; i < n; ++i)
+			func(i);
+		return;
+	}
+
+	atomic<int> next(0);
+	vector<thread> threads;
+	for(int t = 0; t < num_threads; ++t)
+		threads.push_back(thread([&]() {
+			for(int i = next++; i < n; i = next++)
+				func(i);
+		}));
+	for(auto& t : threads)
+		t.join();
+}
+
+// Every splat draws its candidates from its own generator, seeded from the texture seed and the splat's index, so
+// the candidate list does not depend on which thread or in what order the splats get run.
+const quilt_pixel_t *	grab_patch(const quilt_pixel_t * base, int dx, int dy, int w, int h, int tile_size, mt19937& rng)
 {
-	int xo = random() % (w - tile_size);
-	int yo = random() % (h - tile_size);
+	int xo = rng() % (w - tile_size);
+	int yo = rng() % (h - tile_size);
 	return base + xo * dx + yo * dy;
 }
 
 void	splat_for_spot(
-				const unsigned long *	image_src, int sdx, int sdy, int src_w, int src_h,
-					  unsigned long *	image_dst, int ddx, int ddy,			// dest pre-offset location
+				const quilt_pixel_t *	image_src, int sdx, int sdy, int src_w, int src_h,
+					  quilt_pixel_t *	image_dst, int ddx, int ddy,			// dest pre-offset location
 					  int splat_s,												// size o splat
 					  int l, int b, int r, int t,								// amount of overlap
-					  int trials)
+					  int trials,
+					  unsigned int seed, int splat_id,							// which random stream this splat uses
+					  bool threaded)											// spread the trials over all cores
 {
-	const unsigned long * best = grab_patch(image_src,sdx,sdy, src_w, src_h, splat_s);
-	unsigned long best_e = calc_overlay_error<unsigned long, unsigned long>(
-									image_dst, ddx, ddy,
-									best, sdx, sdy,
-									splat_s, splat_s,
-									l, b, r, t);
-	while(trials > 0 && best_e > 0)
+	seed_seq seq { seed, (unsigned int) splat_id };
+	mt19937 rng(seq);
+
+	vector<const quilt_pixel_t *> cand(trials + 1);
+	for(auto& c : cand)
+		c = grab_patch(image_src,sdx,sdy, src_w, src_h, splat_s, rng);
+
+	// With no overlap at all every candidate is equally good - take the first.
+	int best = 0;
+	if(l || b || r || t)
 	{
-		const unsigned long * trial = grab_patch(image_src,sdx,sdy, src_w, src_h, splat_s);
-		unsigned long trial_e = calc_overlay_error<unsigned long, unsigned long>(
-									image_dst, ddx, ddy,
-									best, sdx, sdy,
-									splat_s, splat_s,
-									l, b, r, t);
-
-		if(trial_e < best_e)
-		{
-			best_e = trial_e;
-			best = trial;
-		}
-		--trials;
+		vector<quilt_error_t> err(cand.size());
+		quilt_parallel_for((int) cand.size(), threaded && trials > 0, [&](int i) {
+			err[i] = calc_overlay_error<quilt_pixel_t, quilt_error_t>(
+										image_dst, ddx, ddy,
+										cand[i], sdx, sdy,
+										splat_s, splat_s,
+										l, b, r, t);
+		});
+		// Lowest error wins, the earliest candidate breaks ties - the same pick a serial search would make.
+		for(int i = 1; i < (int) err.size(); ++i)
+			if(err[i] < err[best])
+				best = i;
 	}
 
 	vector<int> cl, cb, cr, ct;
 
-	calc_four_cuts<unsigned long, unsigned long>(
+	calc_four_cuts<quilt_pixel_t, quilt_error_t>(
 						image_dst, ddx,ddy,
-						best, sdx, sdy,
+						cand[best], sdx, sdy,
 						splat_s, splat_s,
 						l, b, r, t,
 						cl, cb, cr, ct);
 
-	copy_cut_edges<unsigned long>(
+	copy_cut_edges<quilt_pixel_t>(
 						image_dst, ddx,ddy,
-						best, sdx, sdy,
+						cand[best], sdx, sdy,
 						image_dst, ddx,ddy,
 						splat_s, splat_s,
 						cl, cb, cr, ct);
@@ -133,7 +162,8 @@ void	make_texture(
 				struct ImageInfo&	dst,
 				int	tile_size,
 				int overlap,
-				int trials)
+				int trials,
+				unsigned int seed)
 {
 	assert(src.channels==4);
 	assert(src.pad % 4 == 0);
@@ -141,24 +171,29 @@ void	make_texture(
 	assert(dst.pad % 4 == 0);
 
 	int sdy = src.width + src.pad / 4;
-	int ddy = dst.width + src.pad / 4;
+	int ddy = dst.width + dst.pad / 4;
 
-	const unsigned long * srcp = (const unsigned long *) src.data;
-		  unsigned long * dstp = (      unsigned long *) dst.data;
+	const quilt_pixel_t * srcp = (const quilt_pixel_t *) src.data;
+		  quilt_pixel_t * dstp = (      quilt_pixel_t *) dst.data;
 
 	int scoot = tile_size - overlap;
 
 	assert(dst.width % scoot == 0);
 	assert(dst.height % scoot == 0);
+	assert(overlap <= scoot);			// Wider overlaps run the border splats off the end of the image.
 
 	int tiles_x = dst.width / scoot;
 	int tiles_y = dst.height / scoot;
 
+	// The border row and column are a chain - each splat is cut against the one before it - so those splats go one
+	// at a time and spread their trials over the cores instead.
+	int splat_id = 0;
+
 	splat_for_spot(
 						srcp, 1, sdy, src.width, src.height,
 						dstp, 1, ddy,
 						tile_size,
-						0, 0, 0, 0, trials);
+						0, 0, 0, 0, trials, seed, splat_id++, true);
 	int n;
 	for(n = 1; n < tiles_x / 2; ++n)
 	{
@@ -166,7 +201,7 @@ void	make_texture(
 						srcp, 1, sdy, src.width, src.height,
 						dstp + n * scoot, 1, ddy,
 						tile_size,
-						overlap, 0, 0, 0, trials);
+						overlap, 0, 0, 0, trials, seed, splat_id++, true);
 	}
 	for(n = 1; n < tiles_y / 2; ++n)
 	{
@@ -174,7 +209,7 @@ void	make_texture(
 						srcp, 1, sdy, src.width, src.height,
 						dstp + n * scoot * ddy, 1, ddy,
 						tile_size,
-						0, overlap, 0, 0, trials);
+						0, overlap, 0, 0, trials, seed, splat_id++, true);
 	}
 
 	rotate_inplace(dstp, 1, ddy, dst.width, dst.height, -scoot * 2, -scoot * 2);
@@ -185,7 +220,7 @@ void	make_texture(
 						srcp, 1, sdy, src.width, src.height,
 						dstp + (n-2) * scoot + ddy * (dst.height - scoot * 2), 1, ddy,
 						tile_size,
-						overlap, 0, (n == tiles_x-1) ? overlap : 0, 0, trials);
+						overlap, 0, (n == tiles_x-1) ? overlap : 0, 0, trials, seed, splat_id++, true);
 	}
 
 	for(n = tiles_y / 2; n < tiles_y; ++n)
@@ -194,7 +229,7 @@ void	make_texture(
 						srcp, 1, sdy, src.width, src.height,
 						dstp + (n-2) * scoot * ddy + dst.width - scoot * 2, 1, ddy,
 						tile_size,
-						0, overlap, 0, (n == tiles_y-1) ? overlap : 0, trials);
+						0, overlap, 0, (n == tiles_y-1) ? overlap : 0, trials, seed, splat_id++, true);
 	}
 
 	int rdx = scoot;// / 2;
@@ -202,17 +237,37 @@ void	make_texture(
 
 	rotate_inplace(dstp, 1, ddy, dst.width, dst.height, scoot * 2 - rdx, scoot * 2 - rdy);
 
-	for(int y = 1; y < tiles_y; ++y)
-	for(int x = 1; x < tiles_x; ++x)
+	// The interior splat at x,y is cut against whatever is under it, which is its left, bottom, bottom-left AND
+	// bottom-right neighbors (the splats overlap their diagonal neighbors in an overlap x overlap corner).  All of
+	// those sit on an earlier wave of x + 2y, while two splats on the same wave are at least 2 columns apart and
+	// can't touch since overlap <= scoot.  So each wave can go wide, and every splat still sees exactly the pixels it
+	// would have seen in the old row-by-row order.
+	int interior_id = splat_id;
+	vector<pair<int,int> > wave;
+
+	for(int k = 3; k <= (tiles_x-1) + 2 * (tiles_y-1); ++k)
 	{
-		splat_for_spot(
-					srcp, 1, sdy, src.width, src.height,
-					dstp + x * scoot - rdx + (y * scoot - rdy) * ddy, 1, ddy,
-					tile_size,
-					overlap,
-					overlap,
-					(x == tiles_x-1) ? overlap : 0,
-					(y == tiles_y-1) ? overlap : 0,
-					trials);
+		wave.clear();
+		for(int y = 1; y < tiles_y; ++y)
+		{
+			int x = k - 2 * y;
+			if(x >= 1 && x < tiles_x)
+				wave.push_back(pair<int,int>(x,y));
+		}
+
+		quilt_parallel_for((int) wave.size(), true, [&](int i) {
+			int x = wave[i].first;
+			int y = wave[i].second;
+			splat_for_spot(
+						srcp, 1, sdy, src.width, src.height,
+						dstp + x * scoot - rdx + (y * scoot - rdy) * ddy, 1, ddy,
+						tile_size,
+						overlap,
+						overlap,
+						(x == tiles_x-1) ? overlap : 0,
+						(y == tiles_y-1) ? overlap : 0,
+						trials, seed, interior_id + y * tiles_x + x,
+						wave.size() == 1);
+		});
 	}
 }
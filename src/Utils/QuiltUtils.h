@@ -24,8 +24,19 @@
 #ifndef QuiltUtils_H
 #define QuiltUtils_H
 
+#include <stdint.h>
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+	#define QUILT_SSE 1
+#endif
+
 struct	ImageInfo;
 
+// Pixels are handled as packed 32-bit RGBA words; the overlap error of one pixel fits in 18 bits, so the sum over a
+// whole tile is kept in 64 bits.
+typedef uint32_t	quilt_pixel_t;
+typedef uint64_t	quilt_error_t;
+
 void	quilt_images(
 					struct ImageInfo& lhs,
 					struct ImageInfo& rhs,
@@ -36,7 +47,8 @@ void	make_texture(
 				struct ImageInfo&	dst,
 				int	tile_size,
 				int overlap,
-				int trials);
+				int trials,
+				unsigned int seed = 0);			// Same seed, same texture - independent of the number of threads used.
 				
 
 inline void 	offset_cuts(vector<int>& cuts, int d)
@@ -45,7 +57,7 @@ inline void 	offset_cuts(vector<int>& cuts, int d)
 		*i += d;
 }
 
-inline unsigned long error_func(const unsigned long * c1, const unsigned long * c2)
+inline quilt_error_t error_func(const quilt_pixel_t * c1, const quilt_pixel_t * c2)
 {
 	int r1 = (*c1 & 0xFF000000) >> 24 ;
 	int g1 = (*c1 & 0x00FF0000) >> 16 ;
@@ -63,7 +75,7 @@ inline unsigned long error_func(const unsigned long * c1, const unsigned long *
 	(a1 - a2) * (a1 - a2);
 }
 
-inline unsigned long blend_func(const unsigned long * c1, const unsigned long * c2)
+inline quilt_pixel_t blend_func(const quilt_pixel_t * c1, const quilt_pixel_t * c2)
 {
 #if 0
 	return 0xFF0000FF;					// Just return a solid color...makes it easy to see the cut.
@@ -89,6 +101,34 @@ inline unsigned long blend_func(const unsigned long * c1, const unsigned long *
 	(a & 0xFF);
 }
 
+// Sum of error_func over one run of contiguous pixels.  This is the inner loop of the trial search, so the SSE2 version
+// widens 4 pixels at a time to 16 bit and squares + pairwise adds them with pmaddwd.  A lane collects 2 squares per step,
+// which overflows 32 bits only past ~66000 pixels per row.
+inline quilt_error_t error_row(const quilt_pixel_t * p1, const quilt_pixel_t * p2, int n)
+{
+	quilt_error_t e = 0;
+	int x = 0;
+#if QUILT_SSE
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc = zero;
+	for(; x + 4 <= n; x += 4)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *) (p1 + x));
+		__m128i b = _mm_loadu_si128((const __m128i *) (p2 + x));
+		__m128i dl = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		__m128i dh = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(dl, dl));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(dh, dh));
+	}
+	uint32_t lanes[4];
+	_mm_storeu_si128((__m128i *) lanes, acc);
+	e = (quilt_error_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+	for(; x < n; ++x)
+		e += error_func(p1 + x, p2 + x);
+	return e;
+}
+
 template <typename Pixel>
 void copy_rotate(
 					const Pixel * s,int	dx1,int dy1,
@@ -214,6 +254,12 @@ ErrorMetric calc_total_error(
 
 	ErrorMetric e = 0;
 
+	if(dx1 == 1 && dx2 == 1)
+	{
+		for(int y = 0; y < height; ++y)
+			e += error_row(PIXEL1(0,y),PIXEL2(0,y),width);
+	}
+	else
 	for(int y = 0; y < height; ++y)
 	for(int x = 0; x < width ; ++x)
 		e += error_func(PIXEL1(x,y),PIXEL2(x,y));
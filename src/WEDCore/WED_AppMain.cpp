@@ -32,6 +32,7 @@
 #include "WED_Application.h"
 #include "WED_Document.h"
 #include "FileUtils.h"
+#include "PlatformUtils.h"
 #include "WED_FileCache.h"
 #include "WED_Menus.h"
 #include "WED_PackageMgr.h"
@@ -43,6 +44,7 @@
 #include "GUI_Window.h"
 #include "GUI_Prefs.h"
 #include "GUI_Resources.h"
+#include "XObjReadWrite.h"
 
 #include <ctime>
 
@@ -224,6 +226,16 @@ int main(int argc, char * argv[])
 
 	start->ShowMessage("Initializing WED File Cache");
 	gFileCache.init();
+	{
+		// Not in the file cache's own folder - it throws out anything it didn't write itself.
+		string obj_cache = GetCacheFolder();
+		if(!obj_cache.empty())
+		{
+			obj_cache += DIR_STR "wed_obj_cache";
+			if(FILE_make_dir_exist(obj_cache.c_str()) == 0)
+				XObj8SetCacheFolder(obj_cache);
+		}
+	}
 
 	start->ShowMessage("Loading ENUM system...");
 	WED_AssertInit();
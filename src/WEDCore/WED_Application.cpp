@@ -160,6 +160,11 @@ void WED_Settings::ReceiveMessage(
 			gOrthoExport = ((GUI_Button *) inParam)->GetValue();
 			this->TakeFocus();
 	}
+	else if(inMsg == (intptr_t) &gBinaryProject)
+	{
+			gBinaryProject = ((GUI_Button *) inParam)->GetValue();
+			this->TakeFocus();
+	}
 	else if (inMsg == kMsg_Close)
 	{
 		this->TakeFocus();
@@ -202,6 +207,15 @@ WED_Settings::WED_Settings(GUI_Commander * cmdr) : GUI_Window("WED Preferences",
 	png_btn->SetValue(gOrthoExport);
 	png_btn->SetMsg((intptr_t) &gOrthoExport, (intptr_t) png_btn);
 
+	GUI_Button * bin_btn = new GUI_Button("check_buttons.png",btn_Check,k_no, k_no, k_yes, k_yes);
+	bin_btn->SetBounds(340,205,510,205+GUI_GetImageResourceHeight("check_buttons.png")/3);
+	bin_btn->Show();
+	bin_btn->SetDescriptor("Binary Projects");
+	bin_btn->SetParent(this);
+	bin_btn->AddListener(this);
+	bin_btn->SetValue(gBinaryProject);
+	bin_btn->SetMsg((intptr_t) &gBinaryProject, (intptr_t) bin_btn);
+
 	int field_height = gFontSize+gFontSize/2;
 
 	mCustom_box = new GUI_TextField(true, this);
@@ -31,12 +31,318 @@
 #include "WED_Errors.h"
 #include "WED_XMLWriter.h"
 #include "WED_Messages.h"
+#include "WED_Version.h"
+#include "IODefs.h"
+#include "FileUtils.h"
+#include "MemFileUtils.h"
+#include "PerfUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+#include <thread>
+
+#if IBM
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+	Binary project layout - all native endian, like the undo buffers:
+
+	bin_header_t
+	object records			raw WriteTo() streams, back to back
+	extra blob				opaque to us - the document's prefs
+	class table				NUL terminated class names, referenced by index
+	index					bin_rec_t[num_objects], sorted by ID
+
+	The WriteTo streams are not versioned, so we only read files written by the exact same WED version.
+*/
+
+#define	BIN_MAGIC		"WEDb"
+#define	BIN_FORMAT		1
+
+struct	bin_header_t {
+	char		magic[4];
+	int32_t		format;
+	int32_t		wed_version;
+	int32_t		next_id;
+	int32_t		num_classes;
+	int32_t		num_objects;
+	int64_t		class_offset;
+	int64_t		index_offset;
+	int64_t		extra_offset;
+	int64_t		extra_length;
+};
+
+// Reads one object record out of the memory mapped file.  A record that is too short is damaged; rather than
+// walking off the end of the map we zero-fill and let the caller know.
+class	bin_rec_reader : public IOReader {
+public:
+	bin_rec_reader(const char * b, const char * e) : p(b), e(e), bad(false) { }
+
+	virtual	void	ReadShort(short& v) { read(&v, sizeof(v)); }
+	virtual	void	ReadInt(int& v) { read(&v, sizeof(v)); }
+	virtual	void	ReadFloat(float& v) { read(&v, sizeof(v)); }
+	virtual	void	ReadDouble(double& v) { read(&v, sizeof(v)); }
+	virtual	void	ReadBulk(char * inBuf, int inLength, bool inZip) { read(inBuf, inLength); }
+
+	bool	is_bad(void) const { return bad; }
+
+	const char *	take(size_t len)		// Raw access to the next len bytes, NULL if there aren't that many
+	{
+		if(len > (size_t) (e - p))
+		{
+			p = e;
+			bad = true;
+			return NULL;
+		}
+		const char * r = p;
+		p += len;
+		return r;
+	}
+
+private:
+	void	read(void * dst, size_t len)
+	{
+		if(len > (size_t) (e - p))
+		{
+			memset(dst, 0, len);
+			p = e;
+			bad = true;
+		}
+		else
+		{
+			memcpy(dst, p, len);
+			p += len;
+		}
+	}
+
+	const char *	p;
+	const char *	e;
+	bool			bad;
+};
+
+class	bin_rec_writer : public IOWriter {
+public:
+	virtual	void	WriteShort(short v) { write(&v, sizeof(v)); }
+	virtual	void	WriteInt(int v) { write(&v, sizeof(v)); }
+	virtual	void	WriteFloat(float v) { write(&v, sizeof(v)); }
+	virtual	void	WriteDouble(double v) { write(&v, sizeof(v)); }
+	virtual	void	WriteBulk(const char * inBuf, int inLength, bool inZip) { write(inBuf, inLength); }
+
+	vector<char>	data;
+
+	void	write(const void * src, size_t len)
+	{
+		const char * c = (const char *) src;
+		data.insert(data.end(), c, c + len);
+	}
+};
+
+/*
+	Journal layout:
+
+	journal_header_t
+	entries, each:	int32 payload length, payload, uint32 checksum of the payload
+	payload:		int32 object count, then per object: int32 id, int32 class name length (0 = object was deleted),
+					class name, int32 data length, WriteTo() data
+
+	A crash can leave a torn entry at the end - replay stops at the first entry that is short or fails its checksum.
+*/
+
+#define	JOURNAL_MAGIC			"WEDj"
+#define	JOURNAL_COMPACT_MIN		(16L*1024L*1024L)	// Don't bother compacting journals smaller than this...
+#define	JOURNAL_COMPACT_RATIO	4					// ...or less than this many times the size of the last compaction.
+
+struct	journal_header_t {
+	char		magic[4];
+	int32_t		wed_version;
+	int64_t		base_stamp;
+};
+
+static uint32_t	journal_checksum(const char * p, size_t len)
+{
+	uint32_t h = 2166136261u;						// FNV-1a
+	while(len--)
+	{
+		h ^= (unsigned char) *p++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// Owns the journal file and the thread that writes it.  The archive serializes entries on the main thread (that's
+// where the objects live) and hands them over; the writer batches whatever has queued up into one write + fsync.
+class	WED_ArchiveJournal {
+public:
+	WED_ArchiveJournal(const string& path) : mPath(path), mFile(NULL), mSize(0), mQuit(false),
+		mFailed(false), mBytesWritten(0), mSyncs(0), mSyncMicroseconds(0)
+	{
+		mThread = thread(&WED_ArchiveJournal::WriterThread, this);
+	}
+
+	~WED_ArchiveJournal()
+	{
+		Stop();
+	}
+
+	void	Stop(void)						// Drains the queue first - nothing committed gets lost on a clean close.
+	{
+		if(!mThread.joinable())
+			return;
+		{
+			lock_guard<mutex> lock(mLock);
+			mQuit = true;
+		}
+		mWake.notify_one();
+		mThread.join();
+		if(mFile)
+			fclose(mFile);
+		mFile = NULL;
+	}
+
+	void	Append(vector<char>& entry)
+	{
+		mSize += entry.size();
+		Queue(false, entry);
+	}
+
+	void	Replace(vector<char>& contents)
+	{
+		mSize = contents.size();
+		Queue(true, contents);
+	}
+
+	long long	Size(void) const { return mSize; }
+	bool		Failed(void) const { return mFailed; }
+
+	void		GetStats(long long& bytes_written, int& syncs, double& sync_seconds) const
+	{
+		bytes_written = mBytesWritten;
+		syncs = mSyncs;
+		sync_seconds = mSyncMicroseconds / 1000000.0;
+	}
+
+	const string&	GetPath(void) const { return mPath; }
+
+private:
+
+	struct	job_t {
+		bool			replace;
+		vector<char>	data;
+	};
+
+	void	Queue(bool replace, vector<char>& data)
+	{
+		{
+			lock_guard<mutex> lock(mLock);
+			mJobs.push_back(job_t());
+			mJobs.back().replace = replace;
+			mJobs.back().data.swap(data);
+		}
+		mWake.notify_one();
+	}
+
+	static bool	sync_file(FILE * fi)
+	{
+		if(fflush(fi) != 0) return false;
+#if IBM
+		return _commit(_fileno(fi)) == 0;
+#else
+		return fsync(fileno(fi)) == 0;
+#endif
+	}
+
+	// Replacing goes through a temp file so a crash mid-way leaves the old journal intact.
+	bool	WriteReplacement(const vector<char>& data)
+	{
+		if(mFile)
+			fclose(mFile);
+		mFile = NULL;
+
+		string temp_path = mPath + ".tmp";
+		FILE * fi = fopen(temp_path.c_str(), "wb");
+		if(fi == NULL)
+			return false;
+		bool ok = fwrite(data.data(), 1, data.size(), fi) == data.size() && sync_file(fi);
+		ok = (fclose(fi) == 0) && ok;
+#if IBM
+		if(ok && FILE_exists(mPath.c_str()))
+			FILE_delete_file(mPath.c_str(), false);
+#endif
+		ok = ok && FILE_rename_file(temp_path.c_str(), mPath.c_str()) == 0;
+		mFile = fopen(mPath.c_str(), "ab");
+		return ok && mFile != NULL;
+	}
+
+	void	WriterThread(void)
+	{
+		unique_lock<mutex> lock(mLock);
+		while(true)
+		{
+			mWake.wait(lock, [this] { return mQuit || !mJobs.empty(); });
+			if(mJobs.empty())
+				break;
+
+			list<job_t> jobs;
+			jobs.swap(mJobs);
+			lock.unlock();
+
+			unsigned long long start = query_hpc();
+			bool ok = true, need_sync = false;
+			for(list<job_t>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+			{
+				if(j->replace)
+				{
+					ok = WriteReplacement(j->data) && ok;
+					need_sync = false;
+				}
+				else if(mFile)
+				{
+					ok = fwrite(j->data.data(), 1, j->data.size(), mFile) == j->data.size() && ok;
+					need_sync = true;
+				}
+				else
+					ok = false;
+				mBytesWritten += j->data.size();
+			}
+			if(need_sync)
+				ok = sync_file(mFile) && ok;
+			if(!ok)
+				mFailed = true;
+			mSyncMicroseconds += (long long) hpc_to_microseconds(query_hpc() - start);
+			++mSyncs;
+
+			lock.lock();
+		}
+	}
+
+	string					mPath;
+	FILE *					mFile;
+	long long				mSize;			// What the file will hold once the queue is written - main thread only
+
+	thread					mThread;
+	mutex					mLock;
+	condition_variable		mWake;
+	list<job_t>				mJobs;
+	bool					mQuit;
+
+	atomic<bool>			mFailed;
+	atomic<long long>		mBytesWritten;
+	atomic<int>				mSyncs;
+	atomic<long long>		mSyncMicroseconds;
+};
 
 WED_Archive::WED_Archive(IResolver * r) : mResolver(r), mDying(false), mUndo(NULL), mUndoMgr(NULL),
  #if WITHNWLINK
  mNWAdapter(NULL),
  #endif
- mID(1), mOpCount(0), mCacheKey(0)
+ mID(1), mOpCount(0), mBulkDepth(0), mBulkFirstID(0), mCacheKey(0), mBinFile(NULL), mMaterializing(false),
+ mJournal(NULL), mJournalBase(0), mJournalCompactSize(0)
 {
 
 }
@@ -50,6 +356,9 @@ WED_Archive::~WED_Archive()
 	for (ObjectMap::iterator i = mObjects.begin(); i != mObjects.end(); ++i)
 	if (i->second)
 		i->second->Delete();
+
+	CloseBinary();
+	delete mJournal;
 }
 
 void WED_Archive::SetUndo(WED_UndoLayer * inUndo)
@@ -61,8 +370,13 @@ void WED_Archive::SetUndo(WED_UndoLayer * inUndo)
 WED_Persistent *	WED_Archive::Fetch(int id) const
 {
 	ObjectMap::const_iterator iter = mObjects.find(id);
-	if (iter == mObjects.end()) return NULL;
-	return iter->second;
+	if (iter != mObjects.end()) return iter->second;
+
+	// Not instantiated yet - if it lives in the binary file, bring it in now.  This is logically const:
+	// the object was "there" all along, we just hadn't paid for it.
+	const bin_rec_t * rec = FindRecord(id);
+	if (rec == NULL) return NULL;
+	return const_cast<WED_Archive *>(this)->Materialize(*rec);
 }
 
 void		WED_Archive::ChangedObject(WED_Persistent * inObject, int change_kind)
@@ -73,6 +387,8 @@ void		WED_Archive::ChangedObject(WED_Persistent * inObject, int change_kind)
 	if (mNWAdapter) mNWAdapter->ObjectChanged(inObject, change_kind);
 #endif
 	if (mUndo == UNDO_DISCARD) return;
+	if (mBulkDepth > 0 && inObject->GetID() >= mBulkFirstID) return;		// Born in this load - undo just deletes it.
+	if (mJournal) mJournalPending.insert(inObject->GetID());
 	if (mUndo)	mUndo->ObjectChanged(inObject, change_kind);
 	else		DebugAssert(!"Error: object changed outside of a command.");
 }
@@ -80,6 +396,13 @@ void		WED_Archive::ChangedObject(WED_Persistent * inObject, int change_kind)
 void		WED_Archive::AddObject(WED_Persistent * inObject)
 {
 	if (mDying) return;
+	if (mMaterializing)
+	{
+		// Lazily loaded objects are not a change - keep them away from undo, cache key and network.
+		mID = max(mID,inObject->GetID()+1);
+		mObjects[inObject->GetID()] = inObject;
+		return;
+	}
 	++mCacheKey;
 	mID = max(mID,inObject->GetID()+1);
 	ObjectMap::iterator iter = mObjects.find(inObject->GetID());
@@ -91,6 +414,7 @@ void		WED_Archive::AddObject(WED_Persistent * inObject)
 	if (mNWAdapter) mNWAdapter->ObjectCreated(inObject);
 #endif
 	if (mUndo == UNDO_DISCARD) return;
+	if (mJournal) mJournalPending.insert(inObject->GetID());
 	if (mUndo) mUndo->ObjectCreated(inObject);
 
 	else		DebugAssert(!"Error: object changed outside of a command.");
@@ -107,6 +431,7 @@ void		WED_Archive::RemoveObject(WED_Persistent * inObject)
 	if (mNWAdapter) mNWAdapter->ObjectDestroyed(inObject);
 #endif
 	if (mUndo == UNDO_DISCARD) return;
+	if (mJournal) mJournalPending.insert(inObject->GetID());
 	if (mUndo) mUndo->ObjectDestroyed(inObject);
 	else		DebugAssert(!"Error: object changed outside of a command.");
 }
@@ -115,15 +440,25 @@ void	WED_Archive::ClearAll(void)
 {
 	++mCacheKey;
 
+	// Everything has to be real before we nuke it, so the undo layer can record it.
+	MaterializeAll();
+	CloseBinary();
+
 	for (ObjectMap::iterator ob = mObjects.begin(); ob != mObjects.end(); ++ob)
 	if (ob->second != NULL)
 		ob->second->Delete();
+
+	mJournalPending.clear();
+	mJournalTouched.clear();
 }
 
 void			WED_Archive::SaveToXML(WED_XMLElement * parent)
 {
 	// old code bumps cache key on save...wHY?!
 	//++mCacheKey;
+	// Everything is in memory after this, so let go of a binary file - the caller may be about to replace it.
+	MaterializeAll();
+	CloseBinary();
 	WED_XMLElement * obj = parent->add_sub_element("objects");
 	for (ObjectMap::iterator ob = mObjects.begin(); ob != mObjects.end(); ++ob)
 	if(ob->second != NULL)
@@ -154,6 +489,8 @@ void			WED_Archive::__StartCommand(const string& inName, const char * file, int
 void			WED_Archive::CommitCommand(void)
 {
 	DebugAssert(mUndoMgr != NULL);
+	DebugAssert(mBulkDepth == 0);		// A bulk load must not outlive its command...
+	mBulkDepth = 0;						// ...and if one did, it must not swallow the next command's undo.
 	// Inc this first, so that anyone listening (via the undo mgr) sees we are dirty!
 	++mOpCount;
 	mUndoMgr->CommitCommand();
@@ -167,6 +504,7 @@ void			WED_Archive::CommitCommand(void)
 void			WED_Archive::AbortCommand(void)
 {
 	++mCacheKey;
+	mBulkDepth = 0;			// An import that bailed out may not have ended its bulk load.
 
 	DebugAssert(mUndoMgr != NULL);
 	mUndoMgr->AbortCommand();
@@ -177,6 +515,36 @@ int	WED_Archive::NewID(void)
 	return mID++;
 }
 
+void	WED_Archive::BeginBulkLoad(void)
+{
+	DebugAssert(mUndo != NULL);		// Must be inside a command, so the load undoes as one.
+	if (mBulkDepth++ == 0)
+		mBulkFirstID = mID;
+}
+
+void	WED_Archive::ReserveObjects(int count)
+{
+	// Grow geometrically - callers hint in small steps, and a rehash per step would cost more than it saves.
+	size_t want = mObjects.size() + max(count, 0);
+	if (want > mObjects.bucket_count() * mObjects.max_load_factor())
+		mObjects.reserve(max(want, 2 * mObjects.size()));
+}
+
+void	WED_Archive::EndBulkLoad(void)
+{
+	if (mBulkDepth == 0)
+	{
+		DebugAssert(mUndo == NULL);		// Only once the command ended the load for us.
+		return;
+	}
+	if (--mBulkDepth == 0)
+	{
+		++mCacheKey;
+		if (mUndo != NULL && mUndo != UNDO_DISCARD)
+			BroadcastMessage(msg_ArchiveChangedEphemerally, mUndo->GetChangeMask());
+	}
+}
+
 long long WED_Archive::CacheKey(void)
 {
 	return mCacheKey;
@@ -189,54 +557,327 @@ int		WED_Archive::IsDirty(void)
 
 void	WED_Archive::Validate(void)
 {
+	// Validating may fetch (and thus materialize) peers, which would invalidate our iterator - so work off a copy.
+	vector<WED_Persistent *> objs;
+	objs.reserve(mObjects.size());
 	for (ObjectMap::iterator ob = mObjects.begin(); ob != mObjects.end(); ++ob)
 	if (ob->second != NULL)
-		ob->second->Validate();
+		objs.push_back(ob->second);
+	for (vector<WED_Persistent *>::iterator o = objs.begin(); o != objs.end(); ++o)
+		(*o)->Validate();
 }
 
+//------------------------------------------------------------------------------------------------------------
+// BINARY PROJECTS
+//------------------------------------------------------------------------------------------------------------
 
-void		WED_Archive::StartElement(
-								WED_XMLReader * reader,
-								const XML_Char *	name,
-								const XML_Char **	atts)
+bool	WED_Archive::LoadFromBinary(const string& path, string& out_extra)
 {
-	const XML_Char ** a = atts;
-	const char * class_name = NULL;
-	const char * id_str = NULL;
-	while(*a)
+	DebugAssert(mBinFile == NULL);
+
+	// We are loading into a cleared archive - forget the IDs of the objects that were just deleted,
+	// or they would hide the records of the same ID in the file.
+	for (ObjectMap::iterator ob = mObjects.begin(); ob != mObjects.end(); )
+	if (ob->second == NULL)
+		ob = mObjects.erase(ob);
+	else
 	{
-		if(strcmp(*a,"class")==0)
+		DebugAssert(!"Binary load into a non-empty archive.");
+		++ob;
+	}
+
+	int next_id;
+	if(!OpenBinary(path, &out_extra, &next_id))
+		return false;
+
+	mID = max(mID, next_id);
+	mOpCount = 0;
+	++mCacheKey;
+	LOG_MSG("I/Archive indexed %d objects from %s\n", (int) mBinIndex.size(), path.c_str());
+	return true;
+}
+
+bool	WED_Archive::SaveToBinary(const string& path, const string& backup_path, const string& extra)
+{
+	string temp_path = path + ".tmp";
+	FILE * fi = fopen(temp_path.c_str(), "wb");
+	if(fi == NULL)
+		return false;
+
+	bin_header_t hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, BIN_MAGIC, 4);
+	hdr.format = BIN_FORMAT;
+	hdr.wed_version = WED_VERSION_NUMERIC;
+	hdr.next_id = mID;
+	fwrite(&hdr, sizeof(hdr), 1, fi);			// Placeholder, rewritten once we know the offsets.
+
+	// Every live ID - both instantiated objects and records still sitting in the old file.
+	vector<int> ids;
+	ids.reserve(mObjects.size() + mBinIndex.size());
+	for (ObjectMap::iterator ob = mObjects.begin(); ob != mObjects.end(); ++ob)
+	if (ob->second != NULL)
+		ids.push_back(ob->first);
+	for (vector<bin_rec_t>::iterator r = mBinIndex.begin(); r != mBinIndex.end(); ++r)
+	if (mObjects.count(r->id) == 0)
+		ids.push_back(r->id);
+	sort(ids.begin(), ids.end());
+
+	map<string, int>	class_idx;
+	vector<string>		classes;
+	vector<bin_rec_t>	index;
+	index.reserve(ids.size());
+	int64_t				pos = sizeof(hdr);
+	bin_rec_writer		buf;
+	int					num_written = 0;
+
+	for (vector<int>::iterator i = ids.begin(); i != ids.end(); ++i)
+	{
+		ObjectMap::iterator ob = mObjects.find(*i);
+		WED_Persistent * obj = (ob == mObjects.end()) ? NULL : ob->second;
+		const bin_rec_t * old_rec = FindRecord(*i);
+
+		string			cls;
+		const char *	data;
+		size_t			len;
+
+		if(obj && (obj->GetDirty() || old_rec == NULL))
 		{
-			++a;
-			class_name = *a;
-			++a;
+			buf.data.clear();
+			obj->WriteTo(&buf);
+			cls = obj->GetClass();
+			data = buf.data.empty() ? "" : &buf.data[0];
+			len = buf.data.size();
+			++num_written;
 		}
-		if(strcmp(*a,"id")==0)
+		else
 		{
-			++a;
-			id_str = *a;
-			++a;
+			DebugAssert(old_rec);
+			cls = mBinClasses[old_rec->class_idx];
+			data = MemFile_GetBegin(mBinFile) + old_rec->offset;
+			len = old_rec->length;
 		}
-		else
+
+		map<string, int>::iterator ci = class_idx.find(cls);
+		if(ci == class_idx.end())
 		{
-			++a;
-			++a;
+			ci = class_idx.insert(map<string, int>::value_type(cls, classes.size())).first;
+			classes.push_back(cls);
 		}
+
+		bin_rec_t rec = { *i, ci->second, pos, (int64_t) len };
+		index.push_back(rec);
+		fwrite(data, 1, len, fi);
+		pos += len;
+	}
+
+	hdr.extra_offset = pos;
+	hdr.extra_length = extra.size();
+	fwrite(extra.data(), 1, extra.size(), fi);
+	pos += extra.size();
+
+	hdr.class_offset = pos;
+	hdr.num_classes = classes.size();
+	for (vector<string>::iterator c = classes.begin(); c != classes.end(); ++c)
+	{
+		fwrite(c->c_str(), 1, c->size() + 1, fi);
+		pos += c->size() + 1;
 	}
+
+	hdr.index_offset = pos;
+	hdr.num_objects = index.size();
+	if(!index.empty())
+		fwrite(&index[0], sizeof(bin_rec_t), index.size(), fi);
+
+	fseek(fi, 0, SEEK_SET);
+	fwrite(&hdr, sizeof(hdr), 1, fi);
+
+	bool ok = ferror(fi) == 0;
+	ok = (fclose(fi) == 0) && ok;
+	if(!ok)
+	{
+		FILE_delete_file(temp_path.c_str(), false);
+		return false;
+	}
+
+	// The new file is complete - only now can we let go of the old one, which we were copying records from.
+	CloseBinary();
+	if(FILE_exists(path.c_str()))
+	{
+		if(FILE_exists(backup_path.c_str()))
+			FILE_delete_file(backup_path.c_str(), false);
+		FILE_rename_file(path.c_str(), backup_path.c_str());
+	}
+	if(FILE_rename_file(temp_path.c_str(), path.c_str()) != 0)
+	{
+		// Keep the objects we haven't materialized yet reachable - the temp file has them all.
+		OpenBinary(temp_path, NULL, NULL);
+		return false;
+	}
+	if(!OpenBinary(path, NULL, NULL))
+		return false;
+
+	for (ObjectMap::iterator ob = mObjects.begin(); ob != mObjects.end(); ++ob)
+	if (ob->second != NULL)
+		ob->second->SetDirty(0);
+
+	mOpCount = 0;
+	LOG_MSG("I/Archive saved %d objects to %s, %d of them serialized\n", (int) index.size(), path.c_str(), num_written);
+	return true;
+}
+
+void	WED_Archive::MaterializeAll(void)
+{
+	for (vector<bin_rec_t>::iterator r = mBinIndex.begin(); r != mBinIndex.end(); ++r)
+	if (mObjects.count(r->id) == 0)
+		Materialize(*r);
+}
+
+bool	WED_Archive::OpenBinary(const string& path, string * out_extra, int * out_next_id)
+{
+	MFMemFile * f = MemFile_Open(path.c_str());
+	if(f == NULL)
+		return false;
+
+	const char * b = MemFile_GetBegin(f);
+	int64_t file_len = MemFile_GetEnd(f) - b;
+
+	bin_header_t hdr;
+	if(file_len < (int64_t) sizeof(hdr))
+	{
+		MemFile_Close(f);
+		return false;
+	}
+	memcpy(&hdr, b, sizeof(hdr));
+	if(memcmp(hdr.magic, BIN_MAGIC, 4) != 0 || hdr.format != BIN_FORMAT || hdr.wed_version != WED_VERSION_NUMERIC)
+	{
+		LOG_MSG("I/Archive %s is not a binary project of this WED version\n", path.c_str());
+		MemFile_Close(f);
+		return false;
+	}
+
+	if(hdr.num_objects < 0 || hdr.num_classes < 0 ||
+	   hdr.extra_offset < 0 || hdr.extra_length < 0 || hdr.extra_offset + hdr.extra_length > file_len ||
+	   hdr.class_offset < 0 || hdr.class_offset > file_len ||
+	   hdr.index_offset < 0 || hdr.index_offset + (int64_t) sizeof(bin_rec_t) * hdr.num_objects > file_len)
+	{
+		MemFile_Close(f);
+		WED_ThrowPrintf("Binary project %s is damaged (bad header).", path.c_str());
+	}
+
+	vector<string> classes;
+	const char * c = b + hdr.class_offset;
+	const char * c_end = b + hdr.index_offset;
+	for (int n = 0; n < hdr.num_classes; ++n)
+	{
+		const char * z = (const char *) memchr(c, 0, max<int64_t>(c_end - c, 0));
+		if(z == NULL)
+		{
+			MemFile_Close(f);
+			WED_ThrowPrintf("Binary project %s is damaged (bad class table).", path.c_str());
+		}
+		classes.push_back(string(c, z));
+		c = z + 1;
+	}
+
+	vector<bin_rec_t> index(hdr.num_objects);
+	if(hdr.num_objects)
+		memcpy(&index[0], b + hdr.index_offset, sizeof(bin_rec_t) * hdr.num_objects);
+	for (int n = 0; n < hdr.num_objects; ++n)
+	{
+		const bin_rec_t& r(index[n]);
+		if(r.class_idx < 0 || r.class_idx >= hdr.num_classes ||
+		   r.offset < (int64_t) sizeof(hdr) || r.length < 0 || r.offset + r.length > file_len ||
+		   (n > 0 && r.id <= index[n-1].id))
+		{
+			MemFile_Close(f);
+			WED_ThrowPrintf("Binary project %s is damaged (bad index entry %d).", path.c_str(), n);
+		}
+	}
+
+	if(out_extra)
+		out_extra->assign(b + hdr.extra_offset, hdr.extra_length);
+	if(out_next_id)
+		*out_next_id = hdr.next_id;
+
+	mBinFile = f;
+	mBinClasses.swap(classes);
+	mBinIndex.swap(index);
+	return true;
+}
+
+void	WED_Archive::CloseBinary(void)
+{
+	if(mBinFile)
+		MemFile_Close(mBinFile);
+	mBinFile = NULL;
+	mBinClasses.clear();
+	mBinIndex.clear();
+}
+
+const WED_Archive::bin_rec_t *	WED_Archive::FindRecord(int in_id) const
+{
+	vector<bin_rec_t>::const_iterator r = lower_bound(mBinIndex.begin(), mBinIndex.end(), in_id,
+		[](const bin_rec_t& lhs, int rhs) { return lhs.id < rhs; });
+	if(r == mBinIndex.end() || r->id != in_id)
+		return NULL;
+	return &*r;
+}
+
+WED_Persistent *	WED_Archive::Materialize(const bin_rec_t& rec)
+{
+	DebugAssert(mObjects.count(rec.id) == 0);
+
+	mMaterializing = true;
+	WED_Persistent * obj = WED_Persistent::CreateByClass(mBinClasses[rec.class_idx].c_str(), this, rec.id);
+	mMaterializing = false;
+	if(obj == NULL)
+	{
+		LOG_MSG("E/Archive unknown class %s for object %d\n", mBinClasses[rec.class_idx].c_str(), rec.id);
+		return NULL;
+	}
+
+	const char * p = MemFile_GetBegin(mBinFile) + rec.offset;
+	bin_rec_reader reader(p, p + rec.length);
+	if(obj->ReadFrom(&reader))
+		obj->PostChangeNotify();
+	if(reader.is_bad())
+		LOG_MSG("E/Archive record for object %d (%s) is truncated\n", rec.id, obj->GetClass());
+
+	// Fresh from the DB - by definition clean.
+	obj->SetDirty(0);
+	return obj;
+}
+
+
+// Makes the object for an <object> element and hands the rest of the element to it.
+static WED_Persistent * create_from_xml(WED_XMLReader * reader, const XML_Char ** atts, WED_Archive * archive, bool detached)
+{
+	const char * class_name = get_att("class", atts);
+	const char * id_str = get_att("id", atts);
 	if(id_str == NULL || class_name == NULL)
 	{
 		reader->FailWithError("Object missing ID/Class.");
-		return;
+		return NULL;
 	}
 
-	WED_Persistent * new_obj = WED_Persistent::CreateByClass(class_name, this, atoi(id_str));
+	WED_Persistent * new_obj = detached ? WED_Persistent::CreateDetached(class_name, archive, atoi(id_str))
+										: WED_Persistent::CreateByClass(class_name, archive, atoi(id_str));
 	if(new_obj==NULL)
 	{
 		reader->FailWithError("Create obj failed.");
-		return;
+		return NULL;
 	}
 	new_obj->FromXML(reader, atts);
+	return new_obj;
+}
 
+void		WED_Archive::StartElement(
+								WED_XMLReader * reader,
+								const XML_Char *	name,
+								const XML_Char **	atts)
+{
+	create_from_xml(reader, atts, this, false);
 }
 
 void		WED_Archive::EndElement(void)
@@ -248,3 +889,335 @@ void		WED_Archive::PopHandler(void)
 	mOpCount = 0;
 	++mCacheKey;
 }
+
+//------------------------------------------------------------------------------------------------------------
+// CRASH JOURNAL
+//------------------------------------------------------------------------------------------------------------
+
+void	WED_Archive::OpenJournal(const string& path, long long base_stamp)
+{
+	DebugAssert(mJournal == NULL);
+	mJournal = new WED_ArchiveJournal(path);
+	mJournalBase = base_stamp;
+	mJournalPending.clear();
+
+	// If we just replayed a journal, its changes are now only in memory - start out with them compacted.
+	CompactJournal();
+}
+
+void	WED_Archive::ResetJournal(long long base_stamp)
+{
+	if(mJournal == NULL) return;
+	mJournalBase = base_stamp;
+	mJournalTouched.clear();
+	CompactJournal();
+}
+
+void	WED_Archive::CloseJournal(bool discard)
+{
+	if(mJournal == NULL) return;
+
+	long long bytes;
+	int syncs;
+	double sync_secs;
+	string path(mJournal->GetPath());
+
+	mJournal->Stop();
+	mJournal->GetStats(bytes, syncs, sync_secs);
+	LOG_MSG("I/Journal closed %s: %lld bytes written in %d syncs taking %.3lf sec\n", path.c_str(), bytes, syncs, sync_secs);
+
+	delete mJournal;
+	mJournal = NULL;
+
+	mJournalPending.clear();
+	if(discard)
+		FILE_delete_file(path.c_str(), false);
+}
+
+void	WED_Archive::JournalCommit(void)
+{
+	if(mJournal == NULL || mJournalPending.empty())
+	{
+		mJournalPending.clear();
+		return;
+	}
+
+	vector<char> entry;
+	WriteJournalEntry(entry, mJournalPending);
+	mJournalTouched.insert(mJournalPending.begin(), mJournalPending.end());
+	mJournalPending.clear();
+	mJournal->Append(entry);
+
+	if(mJournal->Failed())
+	{
+		LOG_MSG("E/Journal can not write %s - closing it, changes are no longer protected until saved\n", mJournal->GetPath().c_str());
+		CloseJournal(false);
+		return;
+	}
+
+	if(mJournal->Size() > max<long long>(JOURNAL_COMPACT_MIN, JOURNAL_COMPACT_RATIO * mJournalCompactSize))
+		CompactJournal();
+}
+
+void	WED_Archive::JournalAbort(void)
+{
+	// The aborted command's changes have been backed out - nothing to record.
+	mJournalPending.clear();
+}
+
+void	WED_Archive::CompactJournal(void)
+{
+	unsigned long long start = query_hpc();
+	long long old_size = mJournal->Size();
+
+	vector<char> contents;
+	WriteJournalHeader(contents);
+	if(!mJournalTouched.empty())
+		WriteJournalEntry(contents, mJournalTouched);
+	mJournalCompactSize = contents.size();
+	mJournal->Replace(contents);
+
+	LOG_MSG("I/Journal compacted %lld to %lld bytes (%d objects) in %.3lf sec\n", old_size, mJournalCompactSize,
+		(int) mJournalTouched.size(), hpc_to_microseconds(query_hpc() - start) / 1000000.0);
+}
+
+void	WED_Archive::WriteJournalHeader(vector<char>& out)
+{
+	journal_header_t hdr;
+	memcpy(hdr.magic, JOURNAL_MAGIC, 4);
+	hdr.wed_version = WED_VERSION_NUMERIC;
+	hdr.base_stamp = mJournalBase;
+	const char * c = (const char *) &hdr;
+	out.insert(out.end(), c, c + sizeof(hdr));
+}
+
+void	WED_Archive::WriteJournalEntry(vector<char>& out, const set<int>& ids)
+{
+	bin_rec_writer w;
+	w.WriteInt(0);				// Payload length, patched below
+	w.WriteInt(ids.size());
+	for(set<int>::const_iterator i = ids.begin(); i != ids.end(); ++i)
+	{
+		ObjectMap::iterator ob = mObjects.find(*i);
+		WED_Persistent * obj = (ob == mObjects.end()) ? NULL : ob->second;
+		w.WriteInt(*i);
+		if(obj)
+		{
+			const char * cls = obj->GetClass();
+			int cls_len = strlen(cls);
+			w.WriteInt(cls_len);
+			w.WriteBulk(cls, cls_len, false);
+			size_t len_pos = w.data.size();
+			w.WriteInt(0);
+			obj->WriteTo(&w);
+			int32_t data_len = w.data.size() - len_pos - sizeof(int32_t);
+			memcpy(&w.data[len_pos], &data_len, sizeof(data_len));
+		}
+		else
+			w.WriteInt(0);
+	}
+	int32_t payload_len = w.data.size() - sizeof(int32_t);
+	memcpy(&w.data[0], &payload_len, sizeof(payload_len));
+	uint32_t sum = journal_checksum(&w.data[sizeof(int32_t)], payload_len);
+	w.write(&sum, sizeof(sum));
+
+	out.insert(out.end(), w.data.begin(), w.data.end());
+}
+
+int		WED_Archive::ReplayJournal(const string& path, long long base_stamp, bool apply)
+{
+	MFMemFile * f = MemFile_Open(path.c_str());
+	if(f == NULL)
+		return -1;
+
+	const char * p = MemFile_GetBegin(f);
+	const char * e = MemFile_GetEnd(f);
+
+	journal_header_t hdr;
+	if(e - p < (ptrdiff_t) sizeof(hdr))
+	{
+		MemFile_Close(f);
+		return -1;
+	}
+	memcpy(&hdr, p, sizeof(hdr));
+	if(memcmp(hdr.magic, JOURNAL_MAGIC, 4) != 0 || hdr.wed_version != WED_VERSION_NUMERIC || hdr.base_stamp != base_stamp)
+	{
+		MemFile_Close(f);
+		return -1;
+	}
+	p += sizeof(hdr);
+
+	int num_entries = 0;
+	set<int> post_ids;
+	while(e - p >= (ptrdiff_t) (2 * sizeof(int32_t)))
+	{
+		int32_t payload_len;
+		uint32_t sum;
+		memcpy(&payload_len, p, sizeof(payload_len));
+		if(payload_len < (int32_t) sizeof(int32_t) || e - p - sizeof(int32_t) - sizeof(sum) < (size_t) payload_len)
+			break;
+		const char * payload = p + sizeof(int32_t);
+		memcpy(&sum, payload + payload_len, sizeof(sum));
+		if(sum != journal_checksum(payload, payload_len))
+			break;
+		p = payload + payload_len + sizeof(sum);
+		++num_entries;
+
+		if(!apply)
+			continue;
+
+		bin_rec_reader reader(payload, payload + payload_len);
+		int num_objs;
+		reader.ReadInt(num_objs);
+		while(num_objs-- > 0 && !reader.is_bad())
+		{
+			int id, cls_len, data_len;
+			reader.ReadInt(id);
+			reader.ReadInt(cls_len);
+			if(cls_len <= 0)
+			{
+				if(WED_Persistent * obj = Fetch(id))
+					obj->Delete();
+				post_ids.erase(id);
+				mJournalTouched.insert(id);
+				continue;
+			}
+			const char * cls = reader.take(cls_len);
+			reader.ReadInt(data_len);
+			const char * data = reader.take(max(data_len, 0));
+			if(cls == NULL || data == NULL)
+				break;
+
+			WED_Persistent * obj = Fetch(id);
+			if(obj)
+				obj->StateChanged();
+			else
+				obj = WED_Persistent::CreateByClass(string(cls, cls_len).c_str(), this, id);
+			if(obj == NULL)
+			{
+				LOG_MSG("E/Journal unknown class %s for object %d\n", string(cls, cls_len).c_str(), id);
+				continue;
+			}
+			bin_rec_reader obj_reader(data, data + data_len);
+			if(obj->ReadFrom(&obj_reader))
+				post_ids.insert(id);
+			obj->SetDirty(1);
+			mJournalTouched.insert(id);
+		}
+	}
+	MemFile_Close(f);
+
+	for(set<int>::iterator i = post_ids.begin(); i != post_ids.end(); ++i)
+		if(WED_Persistent * obj = Fetch(*i))
+			obj->PostChangeNotify();
+
+	if(apply)
+		LOG_MSG("I/Journal replayed %d commands from %s\n", num_entries, path.c_str());
+	return num_entries;
+}
+
+//------------------------------------------------------------------------------------------------------------
+// PARALLEL XML LOAD
+//------------------------------------------------------------------------------------------------------------
+
+// Top level handler for one worker's slice of the <objects> body.  Objects are built detached - the archive and
+// undo system are main-thread only - and attached in document order once all workers are done.
+class	xml_slice_handler : public WED_XMLHandler {
+public:
+	xml_slice_handler(WED_Archive * archive) : mArchive(archive) { }
+
+	virtual void		StartElement(
+								WED_XMLReader * reader,
+								const XML_Char *	name,
+								const XML_Char **	atts)
+	{
+		if(strcmp(name,"objects")==0)			// The wrapper we put around the slice
+			return;
+		if(WED_Persistent * obj = create_from_xml(reader, atts, mArchive, true))
+			objs.push_back(obj);
+	}
+	virtual	void		EndElement(void) { }
+	virtual	void		PopHandler(void) { }
+
+	vector<WED_Persistent *>	objs;
+	string						err;
+
+private:
+	WED_Archive *		mArchive;
+};
+
+string	WED_Archive::ReadObjectsParallel(const char * begin, const char * end)
+{
+	static const char	obj_tag[] = "<object ";
+	static const char	wrap_begin[] = "<objects>";
+	static const char	wrap_end[] = "</objects>";
+
+	unsigned long long start = query_hpc();
+
+	// Cut the body into one slice per thread, each starting at an <object> tag.  Object elements never nest and
+	// '<' is always escaped in attribute values, so the tag can only show up where an object starts.
+	int num_threads = max(1u, thread::hardware_concurrency());
+	vector<const char *> cuts(1, begin);
+	for(int n = 1; n < num_threads; ++n)
+	{
+		const char * target = max(cuts.back(), begin + (end - begin) * n / num_threads);
+		const char * c = search(target, end, obj_tag, obj_tag + sizeof(obj_tag) - 1);
+		if(c != end && c != cuts.back())
+			cuts.push_back(c);
+	}
+	cuts.push_back(end);
+	int num_slices = cuts.size() - 1;
+
+	vector<xml_slice_handler *> slices;
+	for(int n = 0; n < num_slices; ++n)
+		slices.push_back(new xml_slice_handler(this));
+
+	atomic<int> next_slice(0);
+	auto worker = [&]()
+	{
+		int n;
+		while((n = next_slice++) < num_slices)
+		{
+			WED_XMLReader reader;
+			reader.PushHandler(slices[n]);
+			vector<pair<const char *, size_t> > pieces;
+			pieces.push_back(make_pair(wrap_begin, sizeof(wrap_begin) - 1));
+			pieces.push_back(make_pair(cuts[n], (size_t) (cuts[n+1] - cuts[n])));
+			pieces.push_back(make_pair(wrap_end, sizeof(wrap_end) - 1));
+			slices[n]->err = reader.ReadPieces(pieces);
+		}
+	};
+	vector<thread> threads;
+	for(int t = 1; t < min(num_threads, num_slices); ++t)
+		threads.push_back(thread(worker));
+	worker();
+	for(vector<thread>::iterator t = threads.begin(); t != threads.end(); ++t)
+		t->join();
+
+	unsigned long long parsed = query_hpc();
+
+	// Link pass: hand the objects to the archive (and the undo layer) in document order, exactly as a serial load would.
+	string err;
+	int num_objs = 0;
+	for(vector<xml_slice_handler *>::iterator s = slices.begin(); s != slices.end(); ++s)
+	{
+		if(err.empty())
+			err = (*s)->err;
+		for(vector<WED_Persistent *>::iterator o = (*s)->objs.begin(); o != (*s)->objs.end(); ++o)
+			(*o)->AttachToArchive();
+		num_objs += (*s)->objs.size();
+	}
+
+	// A failed slice leaves a partial load - back it out again so the caller can retry or report on a clean archive.
+	if(!err.empty())
+		for(vector<xml_slice_handler *>::iterator s = slices.begin(); s != slices.end(); ++s)
+			for(vector<WED_Persistent *>::iterator o = (*s)->objs.begin(); o != (*s)->objs.end(); ++o)
+				(*o)->Delete();
+
+	for(vector<xml_slice_handler *>::iterator s = slices.begin(); s != slices.end(); ++s)
+		delete *s;
+
+	LOG_MSG("I/Archive XML: %d objects parsed on %d threads in %.3lf sec, linked in %.3lf sec\n", num_objs, min(num_threads, num_slices),
+		hpc_to_microseconds(parsed - start) / 1000000.0, hpc_to_microseconds(query_hpc() - parsed) / 1000000.0);
+	return err;
+}
@@ -42,8 +42,39 @@
 	Also note that undo DOESN'T restore dirtiness yet - if we delete an obj and undo, the same data WILL be written out to the archive
 	because the undo system isn't smart enough to see what happened.
 
+	BINARY PROJECTS
+
+	Besides XML, the archive can live in a binary container: one record per object (the same WriteTo stream the undo
+	system uses) plus a sorted ID index.  The file is memory mapped and objects are only materialized on their first
+	Fetch - so a big project opens without parsing the whole thing.  On save, clean objects are copied straight from
+	the old file as raw bytes; only dirty objects are serialized again.
+
+	Materialization happens inside Fetch and is NOT thread safe - code that fans out to worker threads must call
+	MaterializeAll first (WED_BuildCachesRecursive does).
+
+	CRASH JOURNAL
+
+	While a journal is open, every committed command (and every undo/redo) appends the new state of the objects it
+	touched - again as WriteTo streams - to a journal file.  A background thread writes and fsyncs it, so the UI
+	never waits on the disk.  The journal is tied to the saved file it extends by a stamp; a full save resets it.
+	When it grows too big relative to what it describes, it is compacted down to one entry holding the current state
+	of every object touched since the last save.  After a crash, ReplayJournal brings those changes back.
+
+	BULK LOADING
+
+	Importers that build hundreds of thousands of objects bracket the work with BeginBulkLoad/EndBulkLoad, inside
+	their command.  Every ID handed out after BeginBulkLoad belongs to the load, and changes to those objects skip
+	the undo layer and the journal - their creation is already recorded, which is all undo needs to take the whole
+	import back in one step.  Change broadcasts are held back until EndBulkLoad sends one for the lot.
+	Use WED_BulkLoadGuard rather than calling the pair by hand, so a throw out of the import still ends the load.
+	Committing or aborting the command ends any load still open inside it.
+
 */
 
+#include <set>
+#include <vector>
+#include <stdint.h>
+
 #include "WED_XMLReader.h"
 
 class	WED_Persistent;
@@ -51,6 +82,8 @@ class	WED_UndoLayer;
 class	WED_UndoMgr;
 class	WED_XMLElement;
 class	IResolver;
+class	WED_ArchiveJournal;
+struct	MFMemFile;
 #if WITHNWLINK
 class	WED_NWLinkAdapter;
 #endif
@@ -77,6 +110,24 @@ public:
 
 	void			ClearAll(void);
 	void			SaveToXML(WED_XMLElement * parent);
+
+	// Binary container IO.  Load returns false if the file is not a binary project written by this version
+	// of WED, throws if it is damaged.  The extra blob carries the document's own data (prefs) along.
+	bool			LoadFromBinary(const string& path, string& out_extra);
+	bool			SaveToBinary(const string& path, const string& backup_path, const string& extra);
+	void			MaterializeAll(void);
+
+	// Parses and builds the <object> elements between begin and end (the body of an <objects> element) on
+	// several threads.  Returns an error message or "" - on error the archive is left as it was.
+	string			ReadObjectsParallel(const char * begin, const char * end);
+
+	// Crash journal.  Replay returns the number of commands in the journal (applying them if asked to), or -1
+	// if there is no journal that belongs to the given saved file.  Apply only inside a command.
+	void			OpenJournal(const string& path, long long base_stamp);
+	void			ResetJournal(long long base_stamp);
+	void			CloseJournal(bool discard);
+	bool			IsJournaling(void) const { return mJournal != NULL; }
+	int				ReplayJournal(const string& path, long long base_stamp, bool apply);
 #if WITHNWLINK
 	void			SetNWLinkAdapter(WED_NWLinkAdapter * inAdapter);
 #endif
@@ -87,6 +138,12 @@ public:
 	void			AbortCommand(void);
 
 	int				NewID(void);
+
+	// Bulk loading - see above.  Reserve is a hint of how many more objects are coming.
+	void			BeginBulkLoad(void);
+	void			ReserveObjects(int count);
+	void			EndBulkLoad(void);
+	bool			IsBulkLoading(void) const { return mBulkDepth > 0; }
 	int				IsDirty(void);	// returns operation count since save, 0 if we're saved, or positive if new changes, or negative if saved changes were undone.
 
 	long long		CacheKey(void);
@@ -109,6 +166,24 @@ private:
 	void			AddObject		(WED_Persistent * inObject);
 	void			RemoveObject	(WED_Persistent * inObject);
 
+	struct	bin_rec_t {
+		int32_t		id;
+		int32_t		class_idx;
+		int64_t		offset;
+		int64_t		length;
+	};
+
+	bool				OpenBinary(const string& path, string * out_extra, int * out_next_id);
+	void				CloseBinary(void);
+	const bin_rec_t *	FindRecord(int in_id) const;
+	WED_Persistent *	Materialize(const bin_rec_t& rec);
+
+	void				JournalCommit(void);
+	void				JournalAbort(void);
+	void				CompactJournal(void);
+	void				WriteJournalHeader(vector<char>& out);
+	void				WriteJournalEntry(vector<char>& out, const set<int>& ids);
+
 	friend class	WED_Persistent;
 	friend	class	WED_UndoMgr;
 	typedef hash_map<int, WED_Persistent *>	ObjectMap;
@@ -128,10 +203,35 @@ private:
 	int				mID;
 	int				mOpCount;
 
+	int				mBulkDepth;
+	int				mBulkFirstID;	// Objects at or past this ID were made by the bulk load
+
 	long long		mCacheKey;
 
 	IResolver *		mResolver;
 
+	MFMemFile *			mBinFile;		// Binary project we are lazily loading from, if any
+	vector<string>		mBinClasses;
+	vector<bin_rec_t>	mBinIndex;		// Sorted by ID
+	bool				mMaterializing;
+
+	WED_ArchiveJournal *	mJournal;
+	long long				mJournalBase;
+	long long				mJournalCompactSize;	// Size of the journal right after the last compaction
+	set<int>				mJournalPending;		// Touched by the current command
+	set<int>				mJournalTouched;		// Touched since the last full save
+
+};
+
+// Scoped BeginBulkLoad/EndBulkLoad pair.
+class	WED_BulkLoadGuard {
+public:
+	WED_BulkLoadGuard(WED_Archive * inArchive) : mArchive(inArchive) { mArchive->BeginBulkLoad(); }
+	~WED_BulkLoadGuard() { mArchive->EndBulkLoad(); }
+private:
+	WED_BulkLoadGuard(const WED_BulkLoadGuard&);
+	WED_BulkLoadGuard& operator=(const WED_BulkLoadGuard&);
+	WED_Archive *	mArchive;
 };
 
 #endif
@@ -789,7 +789,7 @@ void apply_split(T& container, F filter)
 // 2. Then, throw out everything on the wrong side of the split line.
 // 3. Repeat 1 & 2 for all 4 sides of our AABB.
 
-void	clip_segments(vector<Segment2>& out_segs, const Bbox2& box)
+static void	clip_segments_general(vector<Segment2>& out_segs, const Bbox2& box)
 {
 	split_at_line_h			split_bot(box.ymin()), split_top(box.ymax());
 	split_at_line_v			split_lft(box.xmin()), split_rgt(box.xmax());
@@ -806,7 +806,7 @@ void	clip_segments(vector<Segment2>& out_segs, const Bbox2& box)
 	apply_filter(out_segs, clip_rgt);
 }
 
-void	clip_segments(vector<Segment2p>& out_segs, const Bbox2& box)
+static void	clip_segments_general(vector<Segment2p>& out_segs, const Bbox2& box)
 {
 	split_at_line_h			split_bot(box.ymin()), split_top(box.ymax());
 	split_at_line_v			split_lft(box.xmin()), split_rgt(box.xmax());
@@ -823,7 +823,7 @@ void	clip_segments(vector<Segment2p>& out_segs, const Bbox2& box)
 	apply_filter(out_segs, clip_rgt);
 }
 
-void	clip_segments(vector<Bezier2>& out_segs, const Bbox2& box)
+static void	clip_segments_general(vector<Bezier2>& out_segs, const Bbox2& box)
 {
 	split_at_line_h			split_bot(box.ymin()), split_top(box.ymax());
 	split_at_line_v			split_lft(box.xmin()), split_rgt(box.xmax());
@@ -840,7 +840,7 @@ void	clip_segments(vector<Bezier2>& out_segs, const Bbox2& box)
 	apply_filter(out_segs, clip_rgt);
 }
 
-void	clip_segments(vector<Bezier2p>& out_segs, const Bbox2& box)
+static void	clip_segments_general(vector<Bezier2p>& out_segs, const Bbox2& box)
 {
 	split_at_line_h			split_bot(box.ymin()), split_top(box.ymax());
 	split_at_line_v			split_lft(box.xmin()), split_rgt(box.xmax());
@@ -857,6 +857,162 @@ void	clip_segments(vector<Bezier2p>& out_segs, const Bbox2& box)
 	apply_filter(out_segs, clip_rgt);
 }
 
+// ------------------------------------------------------------------------------------------------------------------------
+// BATCH SEGMENT CLIPPING
+// ------------------------------------------------------------------------------------------------------------------------
+
+void	clip_outcodes(const double * x, const double * y, int n, const Bbox2& box, unsigned char * out_codes)
+{
+	const double xmin = box.xmin(), xmax = box.xmax(), ymin = box.ymin(), ymax = box.ymax();
+
+	// No branches and no early exits, so this vectorizes.
+	for(int i = 0; i < n; ++i)
+	{
+		const double px = x[i], py = y[i];
+		out_codes[i] =  (px <  xmin)       | ((px >  xmax) << 1) | ((py <  ymin) << 2) | ((py >  ymax) << 3) |
+					   ((px <= xmin) << 4) | ((px >= xmax) << 5) | ((py <= ymin) << 6) | ((py >= ymax) << 7);
+	}
+}
+
+// The points that bound a curve - a bezier lies within the hull of its control points.
+static int	curve_points(const Segment2& s, double * x, double * y)
+{
+	x[0] = s.p1.x();	y[0] = s.p1.y();
+	x[1] = s.p2.x();	y[1] = s.p2.y();
+	return 2;
+}
+
+static int	curve_points(const Bezier2& b, double * x, double * y)
+{
+	x[0] = b.p1.x();	y[0] = b.p1.y();
+	x[1] = b.c1.x();	y[1] = b.c1.y();
+	x[2] = b.c2.x();	y[2] = b.c2.y();
+	x[3] = b.p2.x();	y[3] = b.p2.y();
+	return 4;
+}
+
+// Sorts the segments into keep / drop / "needs real clipping" with one outcode pass.  Runs of segments that need
+// clipping go through the general clipper together; since it maps every input element to its pieces in order,
+// the output is exactly what clipping the whole vector would give.
+template <typename S>
+void	clip_segments_batched(vector<S>& io_segs, const Bbox2& box, void (* clip_general)(vector<S>&, const Bbox2&))
+{
+	enum { seg_keep, seg_drop, seg_clip };
+
+	// DSF export calls us once per entity, mostly with a handful of segments - those get classified on the stack.
+	const int		small_n = 16;
+	double			xs_small[4 * small_n], ys_small[4 * small_n];
+	unsigned char	codes_small[4 * small_n], kind_small[small_n];
+	vector<double>			xs_big, ys_big;
+	vector<unsigned char>	codes_big, kind_big;
+
+	int n = io_segs.size();
+	double *		xs = xs_small, * ys = ys_small;
+	unsigned char *	codes = codes_small, * kind = kind_small;
+	if(n > small_n)
+	{
+		xs_big.resize(4 * n);		xs = &xs_big[0];
+		ys_big.resize(4 * n);		ys = &ys_big[0];
+		codes_big.resize(4 * n);	codes = &codes_big[0];
+		kind_big.resize(n);			kind = &kind_big[0];
+	}
+
+	int np = 0;
+	for(int i = 0; i < n; ++i)
+		np += curve_points(io_segs[i], xs + np, ys + np);
+	clip_outcodes(xs, ys, np, box, codes);
+
+	const int per_seg = np / n;							// every curve of one type has the same number of points
+	int n_keep = 0, n_clip = 0;
+	for(int i = 0; i < n; ++i)
+	{
+		unsigned char any = 0, all = 0xFF;
+		for(int k = i * per_seg; k < (i + 1) * per_seg; ++k)
+		{
+			any |= codes[k];
+			all &= codes[k];
+		}
+		if(all & clip_out_any)			kind[i] = seg_drop;		// entirely beyond one side
+		else if(any == 0)				kind[i] = seg_keep;		// strictly inside
+		else							kind[i] = seg_clip;
+		n_keep += kind[i] == seg_keep;
+		n_clip += kind[i] == seg_clip;
+	}
+
+	if(n_keep == n)										// nothing near the box edges - the usual case
+		return;
+
+	if(n_clip == 0)										// only drops - squeeze them out in place
+	{
+		int d = 0;
+		for(int i = 0; i < n; ++i)
+		if(kind[i] == seg_keep)
+		{
+			if(d != i)
+				io_segs[d] = io_segs[i];
+			++d;
+		}
+		io_segs.erase(io_segs.begin() + d, io_segs.end());
+		return;
+	}
+
+	if(n <= small_n)									// too few to be worth splitting into runs
+	{
+		clip_general(io_segs, box);
+		return;
+	}
+
+	vector<S>	result, run;
+	result.reserve(n);
+	for(int i = 0; i < n; ++i)
+	{
+		if(kind[i] == seg_drop)
+			continue;
+		if(kind[i] == seg_keep)
+		{
+			if(!run.empty())
+			{
+				clip_general(run, box);
+				result.insert(result.end(), run.begin(), run.end());
+				run.clear();
+			}
+			result.push_back(io_segs[i]);
+		}
+		else
+			run.push_back(io_segs[i]);
+	}
+	if(!run.empty())
+	{
+		clip_general(run, box);
+		result.insert(result.end(), run.begin(), run.end());
+	}
+	io_segs.swap(result);
+}
+
+void	clip_segments(vector<Segment2>& out_segs, const Bbox2& box)
+{
+	if(!out_segs.empty())
+		clip_segments_batched<Segment2>(out_segs, box, clip_segments_general);
+}
+
+void	clip_segments(vector<Segment2p>& out_segs, const Bbox2& box)
+{
+	if(!out_segs.empty())
+		clip_segments_batched<Segment2p>(out_segs, box, clip_segments_general);
+}
+
+void	clip_segments(vector<Bezier2>& out_segs, const Bbox2& box)
+{
+	if(!out_segs.empty())
+		clip_segments_batched<Bezier2>(out_segs, box, clip_segments_general);
+}
+
+void	clip_segments(vector<Bezier2p>& out_segs, const Bbox2& box)
+{
+	if(!out_segs.empty())
+		clip_segments_batched<Bezier2p>(out_segs, box, clip_segments_general);
+}
+
 // ------------------------------------------------------------------------------------------------------------------------
 // UTILITIES FOR POLYGON CLIPPING
 // ------------------------------------------------------------------------------------------------------------------------
@@ -1826,6 +1982,11 @@ bool clip_general_polygon(const vector<GP>& in_pwh, vector<vector<GP> >& out_pwh
 		}
 	}
 
+	// Only after the degenerate side check - a bad polygon is still an error when it's off the box.
+	if(bounds.xmax() < box.xmin() || bounds.xmin() > box.xmax() ||
+	   bounds.ymax() < box.ymin() || bounds.ymin() > box.ymax())
+		return true;								// entirely beyond one side - nothing is left
+
 	clipping_line	left (true, box.xmin(),-1);
 	clipping_line	right(true, box.xmax(), 1);
 	
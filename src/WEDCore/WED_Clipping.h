@@ -84,8 +84,25 @@
 	In other words, the poly-line clipper is really a segment clipper that clips a list of 
 	segments.
 
+	BATCH CLASSIFICATION
+
+	Most of what gets clipped isn't anywhere near the box edges.  So before any of the above runs,
+	clip_outcodes classifies all points of the input at once (x and y in separate arrays, in a loop
+	the compiler can vectorize) against the four box sides.  Anything strictly inside is kept as is,
+	anything strictly beyond one side is dropped, and only what's left over takes the slow path.
+
 */
 
+enum {
+	clip_out_left	= 1,		// x <  xmin
+	clip_out_right	= 2,		// x >  xmax
+	clip_out_bottom	= 4,		// y <  ymin
+	clip_out_top	= 8,		// y >  ymax
+	clip_out_any	= 15		// the high four bits repeat the four tests, but including the box edge itself
+};
+
+void	clip_outcodes(const double * x, const double * y, int n, const Bbox2& box, unsigned char * out_codes);
+
 void	clip_segments(vector<Segment2>& out_segs, const Bbox2& box);
 void	clip_segments(vector<Segment2p>& out_segs, const Bbox2& box);
 void	clip_segments(vector<Bezier2>& out_segs, const Bbox2& box);
@@ -30,6 +30,7 @@
 #include "WED_Document.h"
 #include "WED_PackageMgr.h"
 #include "FileUtils.h"
+#include "MemFileUtils.h"
 #include "MathUtils.h"
 #include "PlatformUtils.h"
 #include "AptIO.h"
@@ -66,6 +67,7 @@ int gModeratorMode;
 int gFontSize;
 string gCustomSlippyMap;
 int gOrthoExport;
+int gBinaryProject;
 
 static set<WED_Document *> sDocuments;
 static map<string,string>	sGlobalPrefs;
@@ -119,6 +121,7 @@ WED_Document::WED_Document(
 
 WED_Document::~WED_Document()
 {
+	mArchive.CloseJournal(true);			// Closed cleanly - whatever wasn't saved was meant to be thrown away.
 	delete mTexMgr;
 	delete mResourceMgr;
 	delete mLibraryMgr;
@@ -165,10 +168,26 @@ WED_NWLinkAdapter *	WED_Document::GetNWLink(void)
 	return mNWLink;
 }
 #endif
+
+// Identifies the saved file a crash journal extends - a journal is only replayed on top of that exact file.
+static long long file_stamp(const string& path)
+{
+	struct stat meta;
+	if(FILE_get_file_meta_data(path, meta) != 0)
+		return 0;
+	return (long long) meta.st_size * 1000003LL ^ (long long) meta.st_mtime;
+}
+
 void	WED_Document::Save(void)
 {
 	BroadcastMessage(msg_DocWillSave, reinterpret_cast<uintptr_t>(static_cast<IDocPrefs *>(this)));
 
+	if(gBinaryProject)
+	{
+		SaveBinary();
+		return;
+	}
+
 	enum {none,nobackup,both};
 	int stage = none;
 
@@ -279,6 +298,13 @@ void	WED_Document::Save(void)
 		// This is the save-was-okay case.
 		mOnDisk=true;
 		mPrefsChanged=false;
+
+		// The XML is the newest now - a binary version left over would win on the next open.
+		string bin = mFilePath + ".bin";
+		if(FILE_exists(bin.c_str()))
+			FILE_delete_file(bin.c_str(), false);
+
+		mArchive.ResetJournal(file_stamp(xml));
 	}
 
 	//if the second backup still exists after the error handling
@@ -298,31 +324,57 @@ void	WED_Document::Revert(void)
 			return;
 	}
 
+	// A journal left behind without us having it open means we crashed - offer its changes below.  On a
+	// revert from the menu the journal holds exactly what the user wants to throw away.
+	bool recover = !mArchive.IsJournaling();
+	mArchive.CloseJournal(true);
+
 	mDocPrefs.clear();
 	mUndo.__StartCommand("Revert from Saved.",__FILE__,__LINE__);
 
+	string fname(mFilePath);
+	fname+=".xml";
+	string bname(mFilePath);
+	bname+=".bin";
+	bool bin_loaded = false;
 	try {
 		WED_XMLReader	reader;
 		reader.PushHandler(this);
-		string fname(mFilePath);
-		fname+=".xml";
 		mArchive.ClearAll();
 
+		// A binary project is used if it is at least as new as the XML.  Saving as XML deletes it, so
+		// a newer XML means somebody edited it outside of WED.
+		if(FILE_exists(bname.c_str()) && FILE_date_cmpr(bname.c_str(), fname.c_str()) != dcr_secondIsNew)
+		{
+			LOG_MSG("I/Doc reading binary from %s\n", bname.c_str());
+			string extra;
+			// Falling back to an older XML here would quietly lose the user's latest work.
+			if(!mArchive.LoadFromBinary(bname, extra))
+				WED_ThrowPrintf("The binary project %s was written by a different version of WED.", bname.c_str());
+			if(!ReadBinaryPrefs(extra))
+				WED_ThrowPrintf("Unable to read prefs from binary file %s", bname.c_str());
+			bin_loaded = true;
+		}
+
 		// First: try to IO the XML file.
-		bool xml_exists;
-		LOG_MSG("I/Doc reading XML from %s\n", fname.c_str());
+		bool xml_exists = bin_loaded;
+		if(!bin_loaded)
+		{
+			LOG_MSG("I/Doc reading XML from %s\n", fname.c_str());
 
-		string result = reader.ReadFile(fname.c_str(),&xml_exists);
+			string result = ReadXML(reader, fname, &xml_exists);
+
+			if(xml_exists && !result.empty())
+			{
+				LOG_MSG("E/Doc Error reading XML %s",result.c_str());
+				WED_ThrowPrintf("Unable to open XML file: %s",result.c_str());
+			}
+		}
 
 		for (auto sp : mDocPrefs)
 			LOG_MSG("I/Doc prefs %s = %s\n", sp.first.c_str(), sp.second.c_str());
 		LOG_FLUSH();
 
-		if(xml_exists && !result.empty())
-		{
-			LOG_MSG("E/Doc Error reading XML %s",result.c_str());
-			WED_ThrowPrintf("Unable to open XML file: %s",result.c_str());
-		}
 		if(xml_exists)
 		{
 			mOnDisk=true;
@@ -361,7 +413,15 @@ void	WED_Document::Revert(void)
 	}
 	mUndo.CommitCommand();
 
-	if(WED_Repair(this))
+	if(bin_loaded)
+	{
+		// Objects of a binary project come in without the undo system seeing them, so undoing past this
+		// point can't work.  We also skip the repair pass: the file was written by this WED from a repaired
+		// document, and walking the whole world would instantiate every object right away.
+		mUndo.PurgeUndo();
+		mUndo.PurgeRedo();
+	}
+	else if(WED_Repair(this))
 	{
 		string msg = string("Warning: the package '") + mPackage + string("' has some corrupt contents."
 					"They have been deleted so that the document can be opened.  If you have a better backup of the project, do not save these changes.");
@@ -369,6 +429,27 @@ void	WED_Document::Revert(void)
 		mUndo.PurgeUndo();
 	}
 
+	string jname(mFilePath);
+	jname+=".journal";
+	long long stamp = file_stamp(bin_loaded ? bname : fname);
+	if(recover)
+	{
+		int n = mArchive.ReplayJournal(jname, stamp, false);
+		if(n > 0)
+		{
+			string msg = "WED did not close the package '" + mPackage + "' properly. Do you want to recover the edits that were not saved?";
+			if(ConfirmMessage(msg.c_str(), "Recover", "Discard"))
+			{
+				mArchive.StartCommand("Recover Unsaved Edits");
+				mArchive.ReplayJournal(jname, stamp, true);
+				mArchive.CommitCommand();
+			}
+		}
+		else if(n < 0 && FILE_exists(jname.c_str()))
+			LOG_MSG("I/Doc ignoring journal %s, it does not belong to the saved project\n", jname.c_str());
+	}
+	mArchive.OpenJournal(jname, stamp);
+
 	BroadcastMessage(msg_DocLoaded, reinterpret_cast<uintptr_t>(static_cast<IDocPrefs *>(this)));
 }
 
@@ -586,6 +667,7 @@ void	WED_Document::ReadGlobalPrefs(void)
 	gFontSize = intlim(FontSize, 10, 18);
 	GUI_SetFontSizes(gFontSize);
 	gOrthoExport = atoi(GUI_GetPrefString("preferences","OrthoExport","1"));
+	gBinaryProject = atoi(GUI_GetPrefString("preferences","BinaryProject","0"));
 }
 
 void	WED_Document::WriteGlobalPrefs(void)
@@ -596,6 +678,7 @@ void	WED_Document::WriteGlobalPrefs(void)
 	string FontSize(to_string(gFontSize));
 	GUI_SetPrefString("preferences","FontSize",FontSize.c_str());
 	GUI_SetPrefString("preferences","OrthoExport",gOrthoExport ? "1" : "0");
+	GUI_SetPrefString("preferences","BinaryProject",gBinaryProject ? "1" : "0");
 
 	for (map<string,string>::iterator i = sGlobalPrefs.begin(); i != sGlobalPrefs.end(); ++i)
 		if(i->first != "doc/xml_compatibility")          // why NOT write that ? Cuz WED 2.0 ... 2.2 read that and if an PRE wed-2.0 document
@@ -750,4 +833,140 @@ void		WED_Document::WriteXML(FILE * xml_file)
 	}
 }
 
+// Big documents are nearly all <objects> body - that part is parsed on all cores by the archive, while the
+// reader only sees the rest of the document with an empty <objects> element in it.
+#define PARALLEL_XML_MIN_BYTES	(8*1024*1024)
+
+string		WED_Document::ReadXML(WED_XMLReader& reader, const string& path, bool * exists)
+{
+	static const char	objs_begin[] = "<objects>";
+	static const char	objs_end[] = "</objects>";
+
+	MFMemFile * mf = MemFile_Open(path.c_str());
+	if(mf == NULL || MemFile_GetEnd(mf) - MemFile_GetBegin(mf) < PARALLEL_XML_MIN_BYTES)
+	{
+		if(mf) MemFile_Close(mf);
+		return reader.ReadFile(path.c_str(), exists);
+	}
+
+	const char * b = MemFile_GetBegin(mf);
+	const char * e = MemFile_GetEnd(mf);
+	const char * body_b = search(b, e, objs_begin, objs_begin + sizeof(objs_begin) - 1);
+	const char * body_e = body_b == e ? e : search(body_b, e, objs_end, objs_end + sizeof(objs_end) - 1);
+	if(body_e == e)
+	{
+		MemFile_Close(mf);
+		return reader.ReadFile(path.c_str(), exists);
+	}
+	body_b += sizeof(objs_begin) - 1;
+	if(exists) *exists = true;
+
+	vector<pair<const char *, size_t> > skeleton;
+	skeleton.push_back(make_pair(b, (size_t) (body_b - b)));
+	skeleton.push_back(make_pair(body_e, (size_t) (e - body_e)));
+	string result = reader.ReadPieces(skeleton);
+	if(result.empty())
+	{
+		result = mArchive.ReadObjectsParallel(body_b, body_e);
+		if(!result.empty())
+		{
+			// The slicing can be fooled by hand-edited files (e.g. an <object tag inside a comment) - the archive
+			// backed out, so give the plain reader a go before calling the file broken.
+			LOG_MSG("I/Doc parallel XML load failed (%s), reading serially\n", result.c_str());
+			WED_XMLReader serial_reader;
+			serial_reader.PushHandler(this);
+			result = serial_reader.ReadFile(path.c_str(), exists);
+		}
+	}
+	MemFile_Close(mf);
+	return result;
+}
+
+void		WED_Document::SaveBinary(void)
+{
+	string bin = mFilePath + ".bin";
+	string bak = mFilePath + ".bak.bin";
+
+	if(!mArchive.SaveToBinary(bin, bak, WriteBinaryPrefs()))
+	{
+		string msg = "Error while writing '" + bin + "'.";
+		DoUserAlert(msg.c_str());
+		return;
+	}
+	mOnDisk=true;
+	mPrefsChanged=false;
+	mArchive.ResetJournal(file_stamp(bin));
+}
+
+// The doc prefs ride along in the binary project as a simple length-prefixed blob.
+static void	put_int(string& b, int v)			{ int32_t i = v; b.append((const char *) &i, sizeof(i)); }
+static void	put_str(string& b, const string& s)	{ put_int(b, s.size()); b.append(s); }
+
+static bool	get_int(const char *& p, const char * e, int& v)
+{
+	int32_t i;
+	if(e - p < (ptrdiff_t) sizeof(i)) return false;
+	memcpy(&i, p, sizeof(i));
+	p += sizeof(i);
+	v = i;
+	return true;
+}
+
+static bool	get_str(const char *& p, const char * e, string& s)
+{
+	int l;
+	if(!get_int(p, e, l) || l < 0 || e - p < l) return false;
+	s.assign(p, l);
+	p += l;
+	return true;
+}
+
+string		WED_Document::WriteBinaryPrefs(void) const
+{
+	string b;
+	put_int(b, mDocPrefs.size());
+	for(map<string,string>::const_iterator p = mDocPrefs.begin(); p != mDocPrefs.end(); ++p)
+	{
+		put_str(b, p->first);
+		put_str(b, p->second);
+	}
+	put_int(b, mDocPrefsItems.size());
+	for(map<string,set<int> >::const_iterator pi = mDocPrefsItems.begin(); pi != mDocPrefsItems.end(); ++pi)
+	{
+		put_str(b, pi->first);
+		put_int(b, pi->second.size());
+		for(set<int>::const_iterator i = pi->second.begin(); i != pi->second.end(); ++i)
+			put_int(b, *i);
+	}
+	return b;
+}
+
+bool		WED_Document::ReadBinaryPrefs(const string& blob)
+{
+	const char * p = blob.data();
+	const char * e = p + blob.size();
+	int n, m, v;
+	string key, val;
+
+	mDocPrefs.clear();
+	mDocPrefsItems.clear();
 
+	if(!get_int(p, e, n)) return false;
+	while(n-- > 0)
+	{
+		if(!get_str(p, e, key) || !get_str(p, e, val)) return false;
+		mDocPrefs[key] = val;
+	}
+	if(!get_int(p, e, n)) return false;
+	while(n-- > 0)
+	{
+		if(!get_str(p, e, key) || !get_int(p, e, m)) return false;
+		set<int>& ip(mDocPrefsItems[key]);
+		while(m-- > 0)
+		{
+			if(!get_int(p, e, v)) return false;
+			ip.insert(v);
+		}
+	}
+	return true;
+}
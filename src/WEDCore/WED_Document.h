@@ -136,6 +136,10 @@ private:
 	bool				ReadPrefInternal(const char * in_key, unsigned type, string &out_value) const;
 
 	void				WriteXML(FILE * fi);
+	string				ReadXML(WED_XMLReader& reader, const string& path, bool * exists);
+	void				SaveBinary(void);
+	string				WriteBinaryPrefs(void) const;
+	bool				ReadBinaryPrefs(const string& blob);
 
 	//Member Variables
 
@@ -51,6 +51,8 @@ extern int gModeratorMode;
 extern int gFontSize;
 /* Switch format for orthophoto tiles export */
 extern int gOrthoExport;
+/* Save projects as memory-mapped binary earth.wed.bin instead of earth.wed.xml */
+extern int gBinaryProject;
 
 enum WED_Export_Target {
 		wet_xplane_900,		// X-Plane 9-compatible DSFs.
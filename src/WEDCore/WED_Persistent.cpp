@@ -108,6 +108,14 @@ WED_Persistent * WED_Persistent::CreateByClass(const char * class_id, WED_Archiv
 	return ret;
 }
 
+WED_Persistent * WED_Persistent::CreateDetached(const char * class_id, WED_Archive * parent, int id)
+{
+	// find, not [] - this runs on several threads at once.
+	hash_map<string, WED_Persistent::CTOR_f>::const_iterator i = sStaticCtors.find(class_id);
+	if(i == sStaticCtors.end()) return NULL;
+	return i->second(parent, id);
+}
+
 void			WED_Persistent::SetDirty(int dirty)
 {
 	mDirty = dirty;
@@ -171,6 +171,10 @@ public:
 	// Persistent creation-destruction:
 	static	void			Register(const char * id, CTOR_f ctor);
 	static	WED_Persistent *CreateByClass(const char * id, WED_Archive * parent, int in_ID);
+	// Two-phase CreateByClass for loaders that build objects on worker threads: the object is not known to
+	// the archive (or undo) until AttachToArchive is called from the main thread.
+	static	WED_Persistent *CreateDetached(const char * id, WED_Archive * parent, int in_ID);
+			void			AttachToArchive(void) { PostCtor(); }
 
 							WED_Persistent(WED_Archive * parent);
 							WED_Persistent(WED_Archive * parent, int inID);
@@ -104,6 +104,7 @@ WED_ResourceMgr::~WED_ResourceMgr()
 
 void	WED_ResourceMgr::Purge(void)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	for(auto& i : mObj)
 		for(auto j : i.second)
 			delete j;
@@ -175,6 +176,7 @@ XObj8 * WED_ResourceMgr::LoadObj(const string& abspath)
 
 bool	WED_ResourceMgr::GetObjRelative(const string& obj_path, const string& parent_path, XObj8 const *& obj)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 /* This is ised to resolve objects referenced inside other non-obj assets like .agp, .fac or .str
    These can be either vpaths or paths relative to the art assets location.
    If it a vpath - its got to be known to the library manager.
@@ -216,6 +218,7 @@ bool	WED_ResourceMgr::GetObjRelative(const string& obj_path, const string& paren
 
 bool	WED_ResourceMgr::GetObj(const string& vpath, XObj8 const *& obj, int variant)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	if(toupper(vpath[vpath.size()-3]) != 'O') return false;   // save time by not trying to load .agp's
 
 //printf("GetObj %s' V=%d\n", path.c_str(), variant);
@@ -258,6 +261,7 @@ bool	WED_ResourceMgr::GetObj(const string& vpath, XObj8 const *& obj, int varian
 
 bool 	WED_ResourceMgr::SetPolUV(const string& path, Bbox2 box)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mPol.find(path);
 	if(i != mPol.end())
 	{
@@ -270,6 +274,7 @@ bool 	WED_ResourceMgr::SetPolUV(const string& path, Bbox2 box)
 
 bool	WED_ResourceMgr::GetLin(const string& path, lin_info_t const *& info)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mLin.find(path);
 	if(i != mLin.end())
 	{
@@ -397,6 +402,7 @@ bool	WED_ResourceMgr::GetLin(const string& path, lin_info_t const *& info)
 
 bool	WED_ResourceMgr::GetStr(const string& path, str_info_t const *& info)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mStr.find(path);
 	if(i != mStr.end())
 	{
@@ -454,6 +460,7 @@ bool	WED_ResourceMgr::GetStr(const string& path, str_info_t const *& info)
 
 bool	WED_ResourceMgr::GetPol(const string& path, pol_info_t const*& info)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mPol.find(path);
 	if(i != mPol.end())
 	{
@@ -553,6 +560,7 @@ bool	WED_ResourceMgr::GetPol(const string& path, pol_info_t const*& info)
 
 void WED_ResourceMgr::WritePol(const string& abspath, const pol_info_t& out_info)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	FILE * fi = fopen(abspath.c_str(), "w");
 	if(!fi)	return;
 	fprintf(fi,"A\n850\nDRAPED_POLYGON\n\n");
@@ -585,6 +593,7 @@ void	WED_ResourceMgr::ReceiveMessage(
 
 bool	WED_ResourceMgr::GetFac(const string& vpath, fac_info_t const *& info, int variant)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mFac.find(vpath);
 	int first_needed = 0;
 	if(i != mFac.end())
@@ -1117,6 +1126,7 @@ struct tree_t {
 
 bool	WED_ResourceMgr::GetFor(const string& path, XObj8 const *& obj)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mFor.find(path);
 	if(i != mFor.end())
 	{
@@ -1427,6 +1437,7 @@ void WED_ResourceMgr::setup_tile(agp_t::tile_t * agp, int rotation, const string
 
 bool	WED_ResourceMgr::GetAGP(const string& path, agp_t const *& info)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mAGP.find(path);
 	if(i != mAGP.end())
 	{
@@ -1710,6 +1721,7 @@ bool	WED_ResourceMgr::GetAGP(const string& path, agp_t const *& info)
 #if ROAD_EDITING
 bool	WED_ResourceMgr::GetRoad(const string& path, const road_info_t *& out_info)
 {
+	lock_guard<recursive_mutex> lock(mLock);
 	auto i = mRoad.find(path);
 	if(i != mRoad.end())
 	{
@@ -50,6 +50,7 @@
 #include "XObjDefs.h"
 #include "CompGeomDefs2.h"
 #include <list>
+#include <mutex>
 
 class	WED_LibraryMgr;
 
@@ -248,6 +249,7 @@ private:
 	unordered_map<string,road_info_t>		mRoad;
 #endif
 	WED_LibraryMgr *				mLibrary;
+	recursive_mutex					mLock;			// lookups come from validation and export worker threads, too
 };
 
 #endif /* WED_ResourceMgr_H */
@@ -96,7 +96,8 @@ void	WED_UndoLayer::ObjectChanged(WED_Persistent * inObject, int change_kind)
 		info.buffer->WriteInt(inObject->GetDirty());
 		mObjects.insert(ObjInfoMap::value_type(inObject->GetID(), info));
 	}
-	mArchive->BroadcastMessage(msg_ArchiveChangedEphemerally, GetChangeMask());
+	if (!mArchive->IsBulkLoading())
+		mArchive->BroadcastMessage(msg_ArchiveChangedEphemerally, GetChangeMask());
 }
 
 void	WED_UndoLayer::ObjectDestroyed(WED_Persistent * inObject)
@@ -161,7 +162,7 @@ void	WED_UndoLayer::Execute(void)
 			if(obj->ReadFrom(i->second.buffer))
 				needs_post_call.push_back(obj);
 			i->second.buffer->ReadInt(d);
-			obj->SetDirty(d);
+			obj->SetDirty(1);		// Not d - we may have saved since, and the DB now holds the state we are undoing.
 			break;
 		case op_Destroyed:
 			obj = WED_Persistent::CreateByClass(i->second.the_class, mArchive, i->first);
@@ -171,7 +172,7 @@ void	WED_UndoLayer::Execute(void)
 			if(obj->ReadFrom(i->second.buffer))
 				needs_post_call.push_back(obj);
 			i->second.buffer->ReadInt(d);
-			obj->SetDirty(d);
+			obj->SetDirty(1);
 			break;
 		}
 	}
@@ -95,6 +95,7 @@ void	WED_UndoMgr::CommitCommand(void)
 {
 	Assert(mCommand != NULL);
 	mArchive->SetUndo(NULL);
+	mArchive->JournalCommit();
 	if (mCommand->Empty())
 	{
 		delete mCommand;
@@ -117,6 +118,7 @@ void	WED_UndoMgr::AbortCommand(void)
 	delete mCommand;
 	mCommand = NULL;
 	mArchive->SetUndo(NULL);
+	mArchive->JournalAbort();
 }
 
 bool	WED_UndoMgr::HasUndo(void) const
@@ -150,6 +152,7 @@ void	WED_UndoMgr::Undo(void)
 	int change_mask = undo->GetChangeMask();
 	undo->Execute();
 	mArchive->SetUndo(NULL);
+	mArchive->JournalCommit();
 	mRedo.push_front(redo);
 	delete undo;
 	mUndo.pop_back();
@@ -167,6 +170,7 @@ void	WED_UndoMgr::Redo(void)
 	int change_mask = redo->GetChangeMask();
 	redo->Execute();
 	mArchive->SetUndo(NULL);
+	mArchive->JournalCommit();
 	mUndo.push_back(undo);
 	delete redo;
 	mRedo.pop_front();
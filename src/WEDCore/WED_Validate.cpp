@@ -83,6 +83,7 @@
 #include "PlatformUtils.h"
 #include "STLUtils.h"
 #include "MathUtils.h"
+#include "PerfUtils.h"
 
 #include "WED_Document.h"
 #include "WED_FileCache.h"
@@ -90,6 +91,7 @@
 #include "GUI_Resources.h"
 #include "XESConstants.h"
 
+#include <atomic>
 #include <iomanip>
 #include <thread>
 
@@ -108,6 +110,26 @@
 
 #define DBG_LIN_COLOR 1,0,1,1,0,1
 
+// Seconds spent in each group of checks, summed over all airports. Goes to the log, so the slow checks stand out.
+typedef map<string, double> check_times_t;
+
+class	StCheckTimer {
+	check_times_t&		mTimes;
+	const char *		mCheck;
+	unsigned long long	mStart;
+public:
+	StCheckTimer(check_times_t& times, const char * check) : mTimes(times), mCheck(check), mStart(query_hpc()) { }
+	~StCheckTimer() { Next(nullptr); }
+
+	void Next(const char * check)		// charge the time so far to the current check and start timing another one
+	{
+		unsigned long long now = query_hpc();
+		mTimes[mCheck] += hpc_to_microseconds(now - mStart) / 1000000.0;
+		mCheck = check;
+		mStart = now;
+	}
+};
+
 static int strlen_utf8(const string& str)
 {
     unsigned char c;
@@ -2276,7 +2298,8 @@ static void ValidateRoads(const vector<WED_RoadEdge *> roads, validation_error_v
 #pragma mark -
 //------------------------------------------------------------------------------------------------------------------------------------
 
-static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs, WED_LibraryMgr * lib_mgr, WED_ResourceMgr * res_mgr, MFMemFile * mf)
+static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs, WED_LibraryMgr * lib_mgr, WED_ResourceMgr * res_mgr, MFMemFile * mf,
+							   check_times_t& times)
 {
 	vector<WED_Runway *>			runways;
 	vector<WED_Helipad *>			helipads;
@@ -2360,6 +2383,7 @@ static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs,
 	apt->GetName(name);
 	apt->GetICAO(icao);
 
+	StCheckTimer timer(times, "names and types");
 	ValidateAptName(name, icao, msgs, apt);
 
 	validate_error_t err_type = gExportTarget == wet_gateway ? err_airport_no_rwys_sealanes_or_helipads : warn_airport_no_rwys_sealanes_or_helipads;
@@ -2381,10 +2405,12 @@ static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs,
 			Assert("Unknown Airport Type");
 	}
 
+	timer.Next("doubled nodes");
 	set<WED_Thing*> points = WED_select_doubles(apt);
 	if (points.size())
 		msgs.push_back(validation_error_t("Airport contains doubled ATC routing nodes. These should be merged.", err_airport_ATC_network, points, apt));
 
+	timer.Next("ATC runway and flow checks");
 	CheckDuplicateNames(helipads,msgs,apt,"A helipad name is used more than once.");
 	if(!CheckDuplicateNames(runway_or_sealane,msgs,apt,"A runway or sealane name is used more than once."))
 	{
@@ -2393,8 +2419,10 @@ static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs,
 		ValidateATCFlows(flows, freqs, apt, msgs, legal_rwy_oneway);
 	}
 
+	timer.Next("frequencies");
 	bool has_ATC = ValidateAirportFrequencies(freqs, apt, msgs);
 
+	timer.Next("signs, taxiways and trucks");
 	for(auto s : signs)
 		ValidateOneTaxiSign(s, msgs, apt);
 
@@ -2407,6 +2435,7 @@ static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs,
 	for(auto t_park : truck_parking_locs)
 		ValidateOneTruckParking(t_park, msgs ,apt);
 
+	timer.Next("runways, helipads and ramps");
 	for(auto r : runway_or_sealane)
 		ValidateOneRunwayOrSealane(r, msgs, apt);
 
@@ -2417,8 +2446,10 @@ static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs,
 	for(auto r : ramps)
 		ai_useable_ramps += ValidateOneRampPosition(r, msgs, apt, runways);
 
+	timer.Next("roads");
 	ValidateRoads(roads, msgs, apt);
 
+	timer.Next("metadata, size and boundary");
 	if(gExportTarget >= wet_xplane_1050)
 	{
 		ValidateAirportMetadata(apt,msgs,apt);
@@ -2576,10 +2607,16 @@ static void ValidateOneAirport(WED_Airport* apt, validation_error_vector& msgs,
 			msgs.push_back(validation_error_t("Only Orthophotos with automatic subtexture selection can be exported to the Gateway. Please hide or remove selected Orthophotos.",
 						err_gateway_orthophoto_cannot_be_exported, orthos_illegal, apt));
 		if(mf)
+		{
+			timer.Next("CIFP");
 			ValidateCIFP(runways, sealanes, legal_rwy_oneway, mf, msgs, apt);
+		}
 	}
 
+	timer.Next("point sequences");
 	ValidatePointSequencesRecursive(apt, msgs,apt);
+
+	timer.Next("DSF resources");
 	ValidateDSFRecursive(apt, lib_mgr, msgs, apt);
 }
 
@@ -2608,8 +2645,46 @@ validation_result_t	WED_ValidateApt(WED_Document * resolver, WED_MapPane * pane,
 #if 0 // DEV
 	auto t0 = std::chrono::high_resolution_clock::now();
 #endif
-	for(auto a : apts)
-		ValidateOneAirport(a, msgs, lib_mgr, res_mgr, mf);
+	// Airports are validated in parallel. Nothing in here modifies the document, the only shared state that gets built
+	// along the way are the entity caches - so build those up front. Each airport reports into its own list and the
+	// lists are appended in document order afterwards, so the message order is the same no matter the threading.
+
+#if DEV
+	long long doc_key = wrl->GetArchive()->CacheKey();
+#endif
+	WED_BuildCachesRecursive(wrl);
+
+	int num_threads = min((int) apts.size(), max((int) thread::hardware_concurrency(), 1));
+	vector<validation_error_vector>	apt_msgs(apts.size());
+	vector<check_times_t>			thread_times(num_threads);
+	vector<thread>					threads;
+	atomic<int>						next_apt(0);
+
+	auto validate_worker = [&](int thread_idx)
+	{
+		int a;
+		while((a = next_apt++) < apts.size())
+			ValidateOneAirport(apts[a], apt_msgs[a], lib_mgr, res_mgr, mf, thread_times[thread_idx]);
+	};
+
+	for(int i = 1; i < num_threads; ++i)
+		threads.push_back(thread(validate_worker, i));
+	if(num_threads > 0)
+		validate_worker(0);
+	for(auto& t : threads)
+		t.join();
+
+	DebugAssert(doc_key == wrl->GetArchive()->CacheKey());
+
+	for(auto& m : apt_msgs)
+		msgs.insert(msgs.end(), m.begin(), m.end());
+
+	check_times_t times;
+	for(auto& tt : thread_times)
+		for(auto& t : tt)
+			times[t.first] += t.second;
+	for(auto& t : times)
+		LOG_MSG("I/Val %d airports: %8.3lf sec spent on %s\n", (int) apts.size(), t.second, t.first.c_str());
 
 	vector<WED_RoadEdge*> off_airport_roads;
 
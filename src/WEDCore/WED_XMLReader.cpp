@@ -100,6 +100,39 @@ string	WED_XMLReader::ReadFile(const char * filename, bool * exists)
 	return err;
 }
 
+string	WED_XMLReader::ReadPieces(const vector<pair<const char *, size_t> >& pieces)
+{
+	XML_ParserReset(parser, NULL);
+	XML_SetElementHandler(parser, StartElementHandler, EndElementHandler);
+	XML_SetUserData(parser, reinterpret_cast<void*>(this));
+
+	for(vector<pair<const char *, size_t> >::const_iterator p = pieces.begin(); p != pieces.end(); ++p)
+	{
+		const char * b = p->first;
+		const char * e = p->first + p->second;
+		while(b < e)
+		{
+			int len = min<size_t>(e - b, 1024*1024);		// expat takes an int
+			if(XML_Parse(parser, b, len, 0) == XML_STATUS_ERROR)
+			{
+				XML_Error code = XML_GetErrorCode(parser);
+				if(err.empty())
+					err = XML_ErrorString(code);
+				printf("%s At: %zd,%zd\n", err.c_str(), XML_GetCurrentLineNumber(parser), XML_GetCurrentColumnNumber(parser));
+				return err;
+			}
+			b += len;
+		}
+	}
+	XML_Parse(parser, NULL, 0, 1);
+	XML_Error result = XML_GetErrorCode(parser);
+
+	if(err.empty() &&  result != XML_ERROR_NONE)
+		err = XML_ErrorString(result);
+
+	return err;
+}
+
 void	WED_XMLReader::StartElementHandler(void *userData,
 						const XML_Char *name,
 						const XML_Char **atts)
@@ -27,6 +27,7 @@
 class	WED_XMLReader;
 
 #include <list>
+#include <vector>
 #include <expat.h>
 
 inline const XML_Char * get_att(const char * name, const XML_Char ** atts)
@@ -68,6 +69,8 @@ public:
 	
 	// Returns err msg or "" for none.
 	string	ReadFile(const char * filename, bool * exists);
+	// Parses text that is already in memory, fed piece by piece as if it was one file.
+	string	ReadPieces(const vector<pair<const char *, size_t> >& pieces);
 
 private:
 
@@ -105,7 +105,8 @@ void	WED_Entity::CacheInval(int flags)
 int	WED_Entity::CacheBuild(int flags) const
 {
 	int needed_flags = flags & ~cache_valid_;
-	cache_valid_ |= needed_flags;
+	if(needed_flags)						// don't write when valid - parallel DSF export reads entities from many threads
+		cache_valid_ |= needed_flags;
 	return needed_flags;
 }
 
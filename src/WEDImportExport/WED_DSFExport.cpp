@@ -60,6 +60,12 @@
 #include "STLUtils.h"
 #include "WED_RoadEdge.h"
 
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #if DEV
 #include "PerfUtils.h"
 #endif
@@ -72,16 +78,75 @@
 // something on the ragged edge.
 #define DSF_EXTRA_1021 0.25
 
+// Upper limit for the decoded orthophoto source images we keep around during an export. A single image is always
+// kept, no matter how large - but once we have more than one, the least recently used ones are dropped first.
+#define ORTHO_CACHE_MAX_BYTES (1024L*1024L*1024L)
+
 // various pieces of information about the currently running export
 
 struct DSF_export_info_t
 {
-	ImageInfo	orthoImg;      // in case an orthoimage is to be converted/exported, store its info, so it does not need to be loaded it repeatedly
-	string		orthoFile;     // path to last orthoImage - so we know if there is a 2nd one to deal with - in which case we drop the first
+	typedef shared_ptr<const ImageInfo>	image_ref;
+
+	// Orthoimages to be converted/exported are loaded only once and shared by all tiles they span. The image
+	// handed out stays valid for as long as the caller holds on to it, even if the cache drops it meanwhile.
+	// Returns nullptr if the image can not be loaded. out_loaded is set if the file had to be (re-)read from disk.
+	image_ref	get_ortho(const string& abs_path, bool * out_loaded = nullptr);
+	bool		empty(void);
+
+private:
+	struct	ortho_t {
+		string		path;
+		image_ref	img;
+		size_t		bytes;
+	};
 
-	DSF_export_info_t() { orthoImg.data = NULL; }
+	mutex			mLock;
+	list<ortho_t>	mOrthos;		// most recently used first
+	size_t			mBytes = 0;
 };
 
+DSF_export_info_t::image_ref DSF_export_info_t::get_ortho(const string& abs_path, bool * out_loaded)
+{
+	if(out_loaded) *out_loaded = false;
+	lock_guard<mutex> lock(mLock);
+
+	for(auto o = mOrthos.begin(); o != mOrthos.end(); ++o)
+		if(o->path == abs_path)
+		{
+			mOrthos.splice(mOrthos.begin(), mOrthos, o);
+			return o->img;
+		}
+
+	ImageInfo * img = new ImageInfo;
+	if(LoadBitmapFromAnyFile(abs_path.c_str(), img))   // to cut into pieces, only. Make sure its not forcibly rescaled
+	{
+		delete img;
+		return nullptr;
+	}
+	if(out_loaded) *out_loaded = true;
+
+	ortho_t o;
+	o.path  = abs_path;
+	o.img   = image_ref(img, [](const ImageInfo * i) { DestroyBitmap(i); delete i; });
+	o.bytes = (img->width * img->channels + img->pad) * img->height;
+	mBytes += o.bytes;
+	mOrthos.push_front(o);
+
+	while(mOrthos.size() > 1 && mBytes > ORTHO_CACHE_MAX_BYTES)
+	{
+		mBytes -= mOrthos.back().bytes;
+		mOrthos.pop_back();
+	}
+	return o.img;
+}
+
+bool DSF_export_info_t::empty(void)
+{
+	lock_guard<mutex> lock(mLock);
+	return mOrthos.empty();
+}
+
 extern int gOrthoExport;
 
 //---------------------------------------------------------------------------------------------------------------------------------------
@@ -513,7 +578,7 @@ void dsf_road_grid_helper::export_to_dsf(
 // some big item goes across buckets and we lose precision.
 #define DSF_DIVISIONS 32
 
-static bool g_dropped_pts = false;
+static thread_local bool g_dropped_pts = false;		// per thread, as tiles are exported in parallel
 
 struct	DSF_ResourceTable {
 	DSF_ResourceTable() { for(int i = 0; i < 7; ++i) show_level_obj[i] = show_level_pol[i] = -1; cur_filter = -1;}
@@ -1954,32 +2019,22 @@ static int	DSF_ExportTileRecursive(
 	#if DEV
 					StElapsedTime	etime("DDS export time");
 	#endif
-					if(export_info->orthoFile != absPathIMG)
+					bool img_loaded;
+					DSF_export_info_t::image_ref img = export_info->get_ortho(absPathIMG, &img_loaded);
+					if(!img)
 					{
-						if(!export_info->orthoFile.empty())
-						{
-							Assert(export_info->orthoImg.data);
-							free(export_info->orthoImg.data);
-							export_info->orthoImg.data = NULL;
-							export_info->orthoFile = "";
-						}
-						if(LoadBitmapFromAnyFile(absPathIMG.c_str(),&export_info->orthoImg)) // to cut into pieces, only. Make sure its not forcibly rescaled
-						{
-							DoUserAlert((msg + "Unable to convert the image file '" + absPathIMG + "'to a DDS file, aborting DSF Export.").c_str());
-							return -1;
-						}
-						else
-						{
-							export_info->orthoFile = absPathIMG;
-
-							// force reload of texture from disk - for visual confirmation that WED realized the image had changed
-							ITexMgr * tman = WED_GetTexMgr(resolver);
-							string relImgPath;
-							orth->GetResource(relImgPath);
-							tman->DropTexture(relImgPath.c_str());
-						}
+						DoUserAlert((msg + "Unable to convert the image file '" + absPathIMG + "'to a DDS file, aborting DSF Export.").c_str());
+						return -1;
+					}
+					else if(img_loaded)
+					{
+						// force reload of texture from disk - for visual confirmation that WED realized the image had changed
+						ITexMgr * tman = WED_GetTexMgr(resolver);
+						string relImgPath;
+						orth->GetResource(relImgPath);
+						tman->DropTexture(relImgPath.c_str());
 					}
-					ImageInfo imgInfo(export_info->orthoImg);
+					const ImageInfo& imgInfo(*img);
 					ImageInfo DDSInfo;
 
 					int UVMleft   = intround(imgInfo.width * UVbounds.xmin());
@@ -2302,7 +2357,11 @@ int DSF_ExportTile(WED_Thing * base, IResolver * resolver, const string& pkg, in
 	if(entities)	// empty DSF?  Don't write a empty file, makes a mess!
 	{
 		snprintf(buffer, 255, "%sEarth nav data" DIR_STR "%+03d%+04d",	pkg.c_str(), latlon_bucket(y), latlon_bucket(x)	);
-		FILE_make_dir_exist(buffer);
+		{
+			static mutex dir_lock;			// neighboring tiles share the 10x10 folder
+			lock_guard<mutex> lock(dir_lock);
+			FILE_make_dir_exist(buffer);
+		}
 
 		snprintf(buffer, 255, "%sEarth nav data" DIR_STR "%+03d%+04d" DIR_STR "%+03d%+04d.dsf", pkg.c_str(), latlon_bucket(y), latlon_bucket(x), y, x);
 		DSFWriteToFile(buffer, writer);
@@ -2324,12 +2383,39 @@ int DSF_ExportTile(WED_Thing * base, IResolver * resolver, const string& pkg, in
 	return entities;
 }
 
+// Not yet converted orthophotos get written out as image files and temporarily modify the document during export.
+// The tiles they touch can't be exported in parallel with anything else.
+
+static void DSF_CollectNewOrthophotos(WED_Thing * what, vector<Bbox2>& out_serial_boxes)
+{
+#if WED
+	WED_Entity * ent = dynamic_cast<WED_Entity *>(what);
+	if (ent && ent->GetHidden())
+		return;
+
+	if(what->GetClass() == WED_DrapedOrthophoto::sClass)
+	{
+		auto orth = static_cast<WED_DrapedOrthophoto *>(what);
+		if(orth->IsNew())
+		{
+			Bbox2	bounds;
+			orth->GetBounds(gis_Geo, bounds);
+			out_serial_boxes.push_back(bounds);
+		}
+		return;
+	}
+
+	int nn = what->CountChildren();
+	for(int n = 0; n < nn; ++n)
+		DSF_CollectNewOrthophotos(what->GetNthChild(n), out_serial_boxes);
+#endif
+}
+
 int DSF_Export(WED_Thing * base, IResolver * resolver, const string& package, set<WED_Thing *>& problem_children)
 {
 #if DEV
 	StElapsedTime	etime("Export time");
 #endif
-	g_dropped_pts = false;
 	Bbox2	wrl_bounds;
 
 	IGISEntity * ent = dynamic_cast<IGISEntity *>(base);
@@ -2343,24 +2429,69 @@ int DSF_Export(WED_Thing * base, IResolver * resolver, const string& package, se
 	int tile_south = floor(wrl_bounds.p1.y());
 	int tile_north = ceil (wrl_bounds.p2.y());
 
-	int DSF_export_tile_res = 0;
+	vector<Bbox2>	serial_boxes;
+	DSF_CollectNewOrthophotos(base, serial_boxes);
 
-	DSF_export_info_t DSF_export_info;   // Keeping the last loaded orthoimage open, so it does not have to be loaded repeatedly.
-	                                     // This gates parallel DSF exports, though.
+	// Tiles with orthophotos still to be converted are done one by one up front, on this thread. All other tiles only
+	// read the document and get farmed out to worker threads. Each tile is written to its own file, so the output does
+	// not depend on the order the tiles are processed in.
+
+	vector<pair<int,int> >	serial_tiles, parallel_tiles;
 	for (int y = tile_south; y < tile_north; ++y)
-	{
 		for (int x = tile_west; x < tile_east; ++x)
 		{
-			DSF_export_tile_res = DSF_ExportTile(base, resolver, package, x, y, problem_children, &DSF_export_info);
-			if (DSF_export_tile_res == -1) break;
+			Bbox2 tile(x,y,x+1,y+1);
+			bool is_serial = false;
+			for(auto& b : serial_boxes)
+				if(b.overlap(tile))
+				{
+					is_serial = true;
+					break;
+				}
+			(is_serial ? serial_tiles : parallel_tiles).push_back(make_pair(x,y));
 		}
-		if (DSF_export_tile_res == -1) break;
-	}
-	if (DSF_export_info.orthoImg.data)
+
+	DSF_export_info_t DSF_export_info;
+	bool dropped_pts = false;
+
+	g_dropped_pts = false;
+	for(auto& t : serial_tiles)
+		if (DSF_ExportTile(base, resolver, package, t.first, t.second, problem_children, &DSF_export_info) == -1)
+		{
+			parallel_tiles.clear();
+			break;
+		}
+	dropped_pts = g_dropped_pts;
+
+	WED_BuildCachesRecursive(base);		// after the orthophotos, as undoing their UV rescaling invalidates some caches
+
+	int num_threads = min((int) parallel_tiles.size(), max((int) thread::hardware_concurrency(), 1));
+	vector<set<WED_Thing *> >	tile_problems(parallel_tiles.size());
+	vector<thread>				threads;
+	atomic<int>					next_tile(0);
+	atomic<bool>				any_dropped_pts(false);
+
+	auto export_worker = [&]()
 	{
-		free(DSF_export_info.orthoImg.data);
-	}
-	if (g_dropped_pts)
+		g_dropped_pts = false;
+		int t;
+		while((t = next_tile++) < parallel_tiles.size())
+			DSF_ExportTile(base, resolver, package, parallel_tiles[t].first, parallel_tiles[t].second, tile_problems[t], &DSF_export_info);
+		if(g_dropped_pts)
+			any_dropped_pts = true;
+	};
+
+	for(int i = 1; i < num_threads; ++i)
+		threads.push_back(thread(export_worker));
+	if(num_threads > 0)
+		export_worker();
+	for(auto& t : threads)
+		t.join();
+
+	for(auto& p : tile_problems)
+		problem_children.insert(p.begin(), p.end());
+
+	if (dropped_pts || any_dropped_pts)
 	{
 #if WED
 		DoUserAlert(
@@ -2412,7 +2543,7 @@ int DSF_ExportAirportOverlay(IResolver * resolver, WED_Airport  * apt, const str
 		for(int show_level = 6; show_level >= 1; --show_level)
 			entities += DSF_ExportTileRecursive(apt, resolver, package, cull_bounds, safe_bounds, rsrc, &cbs, writer, problem_children, show_level, &DSF_export_info);
 
-		Assert(DSF_export_info.orthoImg.data == NULL); //  In this type of export - orthoimages are not allowed. So this should never happen.
+		Assert(DSF_export_info.empty()); //  In this type of export - orthoimages are not allowed. So this should never happen.
 
 		rsrc.write_tables(cbs,writer);
 
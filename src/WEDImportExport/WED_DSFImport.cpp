@@ -61,6 +61,10 @@
 #endif
 
 #include <sstream>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
 
 #define NO_FOR 0
 #define NO_FAC 0
@@ -121,6 +125,250 @@ static const char * k_dsf_cat_names[dsf_cat_DIM] = {
 	"Terrain"
 };
 
+// Binary DSFs are decoded on a worker thread while the main thread turns what has been read so far into WED objects.
+// The worker records the callbacks the importer cares about onto a tape and hands it over in chunks.  Terrain
+// patches and raster data are dropped right on the worker - the importer ignores them anyway, and for a base mesh
+// DSF (road import) they are most of the file.
+class	DSF_Tape {
+public:
+
+	struct	op_t {
+		unsigned char	kind;
+		unsigned char	flag;			// curved, object mode
+		unsigned int	a;				// type / def or property string index
+		unsigned int	b;				// subtype / param
+		int				c;				// index of the first coordinate, or polygon depth
+	};
+
+	struct	chunk_t {
+		vector<op_t>	ops;
+		vector<double>	nums;
+		vector<string>	strs;
+	};
+
+	DSF_Tape(const char * path) : mChunk(new chunk_t), mPolyDepth(0), mDone(false), mQuit(false), mResult(dsf_ErrOK)
+	{
+		mThread = thread(&DSF_Tape::ReaderThread, this, string(path));
+	}
+
+	~DSF_Tape()
+	{
+		{
+			lock_guard<mutex> lock(mLock);
+			mQuit = true;				// If we stopped reading early, the worker must not wait for room.
+		}
+		mWake.notify_one();
+		if(mThread.joinable())
+			mThread.join();
+		for(list<chunk_t *>::iterator c = mReady.begin(); c != mReady.end(); ++c)
+			delete *c;
+		delete mChunk;
+	}
+
+	// Blocks until the worker has more - NULL once the file is done.  Caller deletes the chunk.
+	chunk_t *	NextChunk(void)
+	{
+		unique_lock<mutex> lock(mLock);
+		mWake.wait(lock, [this] { return mDone || !mReady.empty(); });
+		if(mReady.empty())
+			return NULL;
+		chunk_t * c = mReady.front();
+		mReady.pop_front();
+		mWake.notify_one();				// The worker may be waiting for room.
+		return c;
+	}
+
+	int			Result(void) const { return mResult; }		// Valid once NextChunk returned NULL
+
+	static void	Replay(const chunk_t& c, DSFCallbacks_t * cb, void * ref)
+	{
+		for(vector<op_t>::const_iterator o = c.ops.begin(); o != c.ops.end(); ++o)
+		{
+			double * coords = const_cast<double *>(c.nums.data()) + o->c;
+			switch(o->kind) {
+			case tape_ObjectDef:		cb->AcceptObjectDef_f(c.strs[o->a].c_str(), ref);											break;
+			case tape_PolygonDef:		cb->AcceptPolygonDef_f(c.strs[o->a].c_str(), ref);											break;
+			case tape_NetworkDef:		cb->AcceptNetworkDef_f(c.strs[o->a].c_str(), ref);											break;
+			case tape_Property:			cb->AcceptProperty_f(c.strs[o->a].c_str(), c.strs[o->a+1].c_str(), ref);					break;
+			case tape_SetFilter:		cb->SetFilter_f((int) o->a, ref);															break;
+			case tape_Object:			cb->AddObjectWithMode_f(o->a, coords, (obj_elev_mode) o->flag, ref);						break;
+			case tape_BeginSegment:		cb->BeginSegment_f(o->a, o->b, coords, o->flag != 0, ref);									break;
+			case tape_SegmentShape:		cb->AddSegmentShapePoint_f(coords, o->flag != 0, ref);										break;
+			case tape_EndSegment:		cb->EndSegment_f(coords, o->flag != 0, ref);												break;
+			case tape_BeginPolygon:		cb->BeginPolygon_f(o->a, (unsigned short) o->b, o->c, ref);								break;
+			case tape_BeginWinding:		cb->BeginPolygonWinding_f(ref);																break;
+			case tape_PolygonPoint:		cb->AddPolygonPoint_f(coords, ref);															break;
+			case tape_EndWinding:		cb->EndPolygonWinding_f(ref);																break;
+			case tape_EndPolygon:		cb->EndPolygon_f(ref);																		break;
+			}
+		}
+	}
+
+private:
+
+	enum {
+		tape_ObjectDef,
+		tape_PolygonDef,
+		tape_NetworkDef,
+		tape_Property,
+		tape_SetFilter,
+		tape_Object,
+		tape_BeginSegment,
+		tape_SegmentShape,
+		tape_EndSegment,
+		tape_BeginPolygon,
+		tape_BeginWinding,
+		tape_PolygonPoint,
+		tape_EndWinding,
+		tape_EndPolygon,
+		tape_DIM,						// Defs we don't keep
+
+		tape_ChunkOps = 16384,
+		tape_MaxReady = 4				// Chunks the worker may run ahead before it waits
+	};
+
+	void	ReaderThread(string path)
+	{
+		DSFCallbacks_t cb = {	NextPass, AcceptDef<tape_DIM>, AcceptDef<tape_ObjectDef>, AcceptDef<tape_PolygonDef>, AcceptDef<tape_NetworkDef>, AcceptDef<tape_DIM>,
+								AcceptProperty,
+								BeginPatch, BeginPrimitive, AddPatchVertex, EndPrimitive, EndPatch,
+								AddObjectWithMode,
+								BeginSegment, AddSegmentShapePoint, EndSegment,
+								BeginPolygon, BeginPolygonWinding, AddPolygonPoint, EndPolygonWinding, EndPolygon, AddRasterData, SetFilter };
+
+		int res = DSFReadFile(path.c_str(), malloc, free, &cb, NULL, this);
+
+		lock_guard<mutex> lock(mLock);
+		if(!mChunk->ops.empty())
+			mReady.push_back(mChunk);
+		else
+			delete mChunk;
+		mChunk = NULL;
+		mResult = res;
+		mDone = true;
+		mWake.notify_one();
+	}
+
+	void	Record(int kind, unsigned int a, unsigned int b, int c, int flag, const double * coords = NULL, int n = 0)
+	{
+		op_t o;
+		o.kind = kind;
+		o.flag = flag;
+		o.a = a;
+		o.b = b;
+		o.c = c;
+		if(coords)
+		{
+			o.c = mChunk->nums.size();
+			mChunk->nums.insert(mChunk->nums.end(), coords, coords + n);
+		}
+		mChunk->ops.push_back(o);
+
+		// Hand over at feature boundaries, so the main thread never waits on the worker half way through a polygon.
+		if(mChunk->ops.size() >= tape_ChunkOps && (kind == tape_EndPolygon || kind == tape_EndSegment || kind == tape_Object))
+		{
+			{
+				unique_lock<mutex> lock(mLock);
+				mWake.wait(lock, [this] { return mQuit || mReady.size() < tape_MaxReady; });
+				if(mQuit)
+					delete mChunk;			// Nobody is reading any more - just run out the file.
+				else
+					mReady.push_back(mChunk);
+			}
+			mWake.notify_one();
+			mChunk = new chunk_t;
+		}
+	}
+
+	unsigned int	Str(const char * s)
+	{
+		mChunk->strs.push_back(s);
+		return mChunk->strs.size() - 1;
+	}
+
+	static bool NextPass(int finished_pass_index, void * inRef) { return true; }
+
+	template <int kind>
+	static int	AcceptDef(const char * inPartialPath, void * inRef)
+	{
+		DSF_Tape * me = (DSF_Tape *) inRef;
+		if(kind != tape_DIM)
+			me->Record(kind, me->Str(inPartialPath), 0, 0, 0);
+		return 1;
+	}
+
+	static void	AcceptProperty(const char * inProp, const char * inValue, void * inRef)
+	{
+		DSF_Tape * me = (DSF_Tape *) inRef;
+		unsigned int p = me->Str(inProp);
+		me->Str(inValue);
+		me->Record(tape_Property, p, 0, 0, 0);
+	}
+
+	static void	BeginPatch(unsigned int, double, double, unsigned char, int, void *) { }
+	static void	BeginPrimitive(int, void *) { }
+	static void	AddPatchVertex(double [], void *) { }
+	static void	EndPrimitive(void *) { }
+	static void	EndPatch(void *) { }
+	static void	AddRasterData(DSFRasterHeader_t *, void *, void *) { }
+
+	static void	AddObjectWithMode(unsigned int inObjectType, double inCoordinates[4], obj_elev_mode inMode, void * inRef)
+	{
+		// Draped objects come from a 3 plane pool - there is no 4th coordinate to copy.
+		double c[4] = { inCoordinates[0], inCoordinates[1], inCoordinates[2], inMode == obj_ModeDraped ? 0.0 : inCoordinates[3] };
+		((DSF_Tape *) inRef)->Record(tape_Object, inObjectType, 0, 0, inMode, c, 4);
+	}
+
+	// Road coordinates are lon lat el node-id, plus the shape point for curved pools.
+	static void	BeginSegment(unsigned int inNetworkType, unsigned int inNetworkSubtype, double inCoordinates[], bool inCurved, void * inRef)
+	{
+		((DSF_Tape *) inRef)->Record(tape_BeginSegment, inNetworkType, inNetworkSubtype, 0, inCurved, inCoordinates, inCurved ? 7 : 4);
+	}
+
+	static void	AddSegmentShapePoint(double inCoordinates[], bool inCurved, void * inRef)
+	{
+		((DSF_Tape *) inRef)->Record(tape_SegmentShape, 0, 0, 0, inCurved, inCoordinates, inCurved ? 7 : 4);
+	}
+
+	static void	EndSegment(double inCoordinates[], bool inCurved, void * inRef)
+	{
+		((DSF_Tape *) inRef)->Record(tape_EndSegment, 0, 0, 0, inCurved, inCoordinates, inCurved ? 7 : 4);
+	}
+
+	static void	BeginPolygon(unsigned int inPolygonType, unsigned short inParam, int inCoordDepth, void * inRef)
+	{
+		DSF_Tape * me = (DSF_Tape *) inRef;
+		me->mPolyDepth = inCoordDepth;
+		me->Record(tape_BeginPolygon, inPolygonType, inParam, inCoordDepth, 0);
+	}
+
+	static void	BeginPolygonWinding(void * inRef) { ((DSF_Tape *) inRef)->Record(tape_BeginWinding, 0, 0, 0, 0); }
+	static void	EndPolygonWinding(void * inRef) { ((DSF_Tape *) inRef)->Record(tape_EndWinding, 0, 0, 0, 0); }
+	static void	EndPolygon(void * inRef) { ((DSF_Tape *) inRef)->Record(tape_EndPolygon, 0, 0, 0, 0); }
+
+	static void	AddPolygonPoint(double * inCoordinates, void * inRef)
+	{
+		DSF_Tape * me = (DSF_Tape *) inRef;
+		me->Record(tape_PolygonPoint, 0, 0, 0, 0, inCoordinates, me->mPolyDepth);
+	}
+
+	static void	SetFilter(int filterId, void * inRef)
+	{
+		((DSF_Tape *) inRef)->Record(tape_SetFilter, filterId, 0, 0, 0);
+	}
+
+	chunk_t *			mChunk;			// Being filled - worker only
+	int					mPolyDepth;		// worker only
+
+	thread				mThread;
+	mutex				mLock;
+	condition_variable	mWake;
+	list<chunk_t *>		mReady;
+	bool				mDone;
+	bool				mQuit;			// The reader is gone
+	int					mResult;
+};
+
 //ToDo:mroe: partial DSF import implemented . By bound and category , checking the bounds for roadnets only yet
 class	DSF_Importer {
 public:
@@ -1086,7 +1334,16 @@ public:
 								BeginPolygon, BeginPolygonWinding, AddPolygonPoint,EndPolygonWinding, EndPolygon, AddRasterData, SetFilter };
 
 		LOG_MSG("I/DSF Importing binary DSF from %s\n",file_name);
-		int res = DSFReadFile(file_name, malloc, free, &cb, NULL, this);
+		WED_BulkLoadGuard bulk(archive);
+
+		DSF_Tape tape(file_name);
+		while(DSF_Tape::chunk_t * chunk = tape.NextChunk())
+		{
+			archive->ReserveObjects(chunk->ops.size());		// Most ops make one object - a point, node or placement.
+			DSF_Tape::Replay(*chunk, &cb, this);
+			delete chunk;
+		}
+		int res = tape.Result();
 
 		for(int i = 0; i < dsf_cat_DIM; ++i)
 		if(bucket_parents[i])
@@ -1107,6 +1364,7 @@ public:
 								BeginPolygon, BeginPolygonWinding, AddPolygonPoint,EndPolygonWinding, EndPolygon, AddRasterData, SetFilter };
 
 		LOG_MSG("I/DSF Importing text DSF from %s\n",file_name);
+		WED_BulkLoadGuard bulk(archive);
 		int ok = Text2DSFWithWriter(file_name, &cb, this);
 
 		for(int i = 0; i < dsf_cat_DIM; ++i)
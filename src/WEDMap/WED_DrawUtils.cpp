@@ -27,6 +27,7 @@
 #include "WED_UIDefs.h"
 #include "MathUtils.h"
 #include "WED_EnumSystem.h"
+#include "XESConstants.h"
 
 #if LIBTESS
 	#include "tesselator.h"
@@ -141,17 +142,39 @@ static void CALLBACK TessVertexUVh(const Point2 * p, float * h)
 	glTexCoord2f(uv->x(), uv->y());
 	glVertex3d(p->x(), *h, p->y());
 }
-#endif
 
-void glPolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, float height)
+struct tess_collect_t {
+	vector<Point2> *	tris;
+	bool				has_uv;
+	bool				ok;
+};
+static void CALLBACK TessEdgeFlag(GLboolean flag)	{ }		// just having one makes GLU hand out plain triangles
+static void CALLBACK TessCollectVertex(const Point2 * p, tess_collect_t * c)
+{
+	c->tris->push_back(p[0]);
+	if(c->has_uv) c->tris->push_back(p[1]);
+}
+static void CALLBACK TessCollectError(GLenum err, tess_collect_t * c)
 {
+	c->ok = false;
+}
+#endif
+
 #if LIBTESS
+bool TessellatePolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, vector<Point2>& tris)
+{
+	tris.clear();
+	if(n < 3) return false;
+
+	// libtess works in floats - tesselate relative to the first point, so lat/lon input keeps its precision.
+	Point2 origin(pts[0]);
+
 	TESStesselator * tess = tessNewTess(NULL);
 	const Point2 * pts_p(pts);
 	vector<GLfloat>	raw_pts;
 	raw_pts.reserve(n * 2);
 	int n_holes = 0;
-	
+
 	for(int i = 0; i < n; ++i)
 	{
 		if(contours && contours[i])
@@ -163,14 +186,15 @@ void glPolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, fl
 				raw_pts.clear();
 			}
 		}
-		raw_pts.push_back(pts_p->x());
-		raw_pts.push_back(pts_p->y());
+		raw_pts.push_back(pts_p->x() - origin.x());
+		raw_pts.push_back(pts_p->y() - origin.y());
 		pts_p++;
 		if(has_uv)	pts_p++;
 	}
 	if(!raw_pts.empty())
 		tessAddContour(tess, 2, &raw_pts[0], 2 * sizeof(GLfloat), raw_pts.size() / 2);
 
+	bool ok = false;
 	if(tessTesselate(tess, TESS_WINDING_POSITIVE, TESS_POLYGONS, 3, 2, 0))
 	{
 		int vert_count = tessGetVertexCount(tess);
@@ -181,57 +205,177 @@ void glPolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, fl
 		{
 			const TESSindex* vert_idx = tessGetElements(tess);
 			const TESSreal * verts = tessGetVertices(tess);
+			const TESSindex * vidx = tessGetVertexIndices(tess);
 
-			if(has_uv)
+			ok = true;
+			tris.reserve(3 * tri_count * (has_uv ? 2 : 1));
+			for(int i = 0; i < 3 * tri_count; ++i, ++vert_idx)
 			{
-				const TESSindex * vidx = tessGetVertexIndices(tess);
-				glBegin(GL_TRIANGLES);
-				if (height == -1.0f)
-					while (tri_count--)
-						for (int i = 0; i < 3; i++)
-						{
-							glTexCoord2(pts[1 + 2 * vidx[*vert_idx]]); glVertex2fv(&verts[2 * (*vert_idx)]);
-							vert_idx++;
-						}
-				else
-					while(tri_count--)
-						for (int i = 0 ; i < 3; i++)
+				tris.push_back(Point2(origin.x() + verts[2 * (*vert_idx)], origin.y() + verts[2 * (*vert_idx) + 1]));
+				if(has_uv)
+				{
+					int src = vidx[*vert_idx];
+					if(src == TESS_UNDEF)		// made up by the tesselator where edges touch - borrow the UV of the closest input point
+					{
+						double best = 9.9e99;
+						for(int k = 0; k < n; ++k)
 						{
-							glTexCoord2(pts[1 + 2 * vidx[*vert_idx]]); glVertex3f(verts[2 * (*vert_idx)], height, verts[2 * (*vert_idx) + 1]);
-							vert_idx++;
+							double d = Vector2(tris.back(), pts[2 * k]).squared_length();
+							if(d < best) { best = d; src = k; }
 						}
-				glEnd();
+					}
+					tris.push_back(pts[1 + 2 * src]);
+				}
+			}
+		}
+	}
+	tessDeleteTess(tess);
+	if(!ok) tris.clear();
+	return ok;
+}
+#else // not LIBTESS
+bool TessellatePolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, vector<Point2>& tris)
+{
+	tris.clear();
+	tess_collect_t c = { &tris, has_uv, true };
+	GLUtesselator * tess = gluNewTess();
+
+	gluTessCallback(tess, GLU_TESS_EDGE_FLAG,	(void (CALLBACK *)(void))TessEdgeFlag);
+	gluTessCallback(tess, GLU_TESS_VERTEX_DATA,	(void (CALLBACK *)(void))TessCollectVertex);
+	gluTessCallback(tess, GLU_TESS_ERROR_DATA,	(void (CALLBACK *)(void))TessCollectError);
+
+	gluTessBeginPolygon(tess,(void *) &c);
+	while(n--)
+	{
+		if (contours && *contours++)	gluNextContour(tess, GLU_INTERIOR);
+
+		double	xyz[3] = { pts->x(), pts->y(), 0 };
+		gluTessVertex(tess, xyz, (void*) pts++);
+		if(has_uv) pts++;
+	}
+	gluEndPolygon (tess);
+	gluDeleteTess(tess);
+	if(!c.ok) tris.clear();
+	return c.ok;
+}
+#endif
+
+void glTriangles2(const Point2 * tris, bool has_uv, int n, float height, WED_MapZoomerNew * z)
+{
+	glBegin(GL_TRIANGLES);
+	while(n--)
+	{
+		Point2 p = z ? z->LLToPixel(*tris) : *tris;
+		++tris;
+		if(has_uv)
+			glTexCoord2(*tris++);
+		if (height == -1.0f)
+			glVertex2d(p.x(), p.y());
+		else
+			glVertex3d(p.x(), height, p.y());
+	}
+	glEnd();
+}
+
+void PointSequenceToVectorLL(
+			IGISPointSequence *		ps,
+			double					ppd,
+			vector<Point2>&			pts,
+			bool					get_uv,
+			vector<int>&			contours,
+			int						is_hole)
+{
+	int n = ps->GetNumSides();
+
+	for (int i = 0; i < n; ++i)
+	{
+		Bezier2		b, buv;
+		if(get_uv) ps->GetSide(gis_UV,i,buv);
+		if (ps->GetSide(gis_Geo,i,b))
+		{
+			// Only the lengths matter for the point count, so scale relative to p1.
+			double ppd_lon = ppd * cos(b.p1.y() * DEG_TO_RAD);
+			Bezier2 bp(Point2(0.0, 0.0),
+					   Point2((b.c1.x() - b.p1.x()) * ppd_lon, (b.c1.y() - b.p1.y()) * ppd),
+					   Point2((b.c2.x() - b.p1.x()) * ppd_lon, (b.c2.y() - b.p1.y()) * ppd),
+					   Point2((b.p2.x() - b.p1.x()) * ppd_lon, (b.p2.y() - b.p1.y()) * ppd));
+
+			int point_count = BezierPtsCount(bp, NULL);
+
+			pts.reserve(pts.size() + point_count * (get_uv ? 2 : 1));
+			contours.reserve(contours.size() + point_count);
+			for (int k = 0; k < point_count; ++k)
+			{
+							pts.push_back(b.midpoint((float) k / (float) point_count));
+				if(get_uv)	pts.push_back(buv.midpoint((float) k / (float) point_count));
+				contours.push_back((k == 0 && i == 0) ? is_hole : 0);
 			}
-			else
+
+			if (i == n-1 && !ps->IsClosed())
 			{
-		#if 1
-				glBegin(GL_TRIANGLES);
-				if (height == -1.0f)
-					while (tri_count--)
-						for (int i = 0; i < 3; i++)
-							glVertex2fv(&verts[2 * (*vert_idx++)]);
-				else
-					while(tri_count--)
-						for (int i = 0 ; i < 3; i++)
-						{
-							glVertex3f(verts[2 * (*vert_idx)], height, verts[2 * (*vert_idx) + 1]);
-							vert_idx++;
-						}
-				glEnd();
-		#else  // not any faster, cuz of too many state changes -> cache those ?
-				glVertexPointer(2, GL_FLOAT, 2 * sizeof(TESSreal), verts);
-				glEnableClientState(GL_VERTEX_ARRAY);
-				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-				glDisableClientState(GL_NORMAL_ARRAY);
-				glDrawElements(GL_TRIANGLES, 3 * tri_count, GL_INT, vert_idx);
-				glDisableClientState(GL_VERTEX_ARRAY);
-		#endif
+							pts.push_back(b.p2);
+				if(get_uv)	pts.push_back(buv.p2);
+				contours.push_back(0);
+			}
+		}
+		else
+		{
+							pts.push_back(b.p1);
+			if(get_uv)		pts.push_back(buv.p1);
+			contours.push_back(i == 0 ? is_hole : 0);
+			if (i == n-1 && !ps->IsClosed())
+			{
+							pts.push_back(b.p2);
+				if(get_uv)	pts.push_back(buv.p2);
+				contours.push_back(0);
 			}
 		}
 	}
-	tessDeleteTess(tess);
+}
+
+void	WED_PolygonTessCache::Validate(long long archive_key, double ppd)
+{
+	// Subdivision is sized for the next power of two up, so zooming within a bucket never draws coarser curves than before.
+	double bucket = ppd > 0.0 ? pow(2.0, ceil(log2(ppd))) : 0.0;
+	if(archive_key != mArchiveKey || bucket != mPPD)
+	{
+		mArchiveKey = archive_key;
+		mPPD = bucket;
+		mPolys.clear();
+	}
+}
+
+const vector<Point2> *	WED_PolygonTessCache::Get(IGISPolygon * poly, bool has_uv)
+{
+	auto it = mPolys.find(poly);
+	if(it == mPolys.end())
+	{
+		it = mPolys.insert(make_pair(poly, tess_t())).first;
 
+		vector<Point2>	pts;
+		vector<int>		is_hole_start;
+
+		PointSequenceToVectorLL(poly->GetOuterRing(), mPPD, pts, has_uv, is_hole_start, 0);
+		int n = poly->GetNumHoles();
+		for (int i = 0; i < n; ++i)
+			PointSequenceToVectorLL(poly->GetNthHole(i), mPPD, pts, has_uv, is_hole_start, 1);
+
+		if(!pts.empty())
+			it->second.ok = TessellatePolygon2(pts.data(), has_uv, is_hole_start.data(), pts.size() / (has_uv ? 2 : 1), it->second.tris);
+	}
+	return it->second.ok ? &it->second.tris : NULL;
+}
+
+#if LIBTESS
+void glPolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, float height)
+{
+	vector<Point2> tris;
+	if(TessellatePolygon2(pts, has_uv, contours, n, tris))
+		glTriangles2(tris.data(), has_uv, tris.size() / (has_uv ? 2 : 1), height);
+}
 #else // not LIBTESS
+void glPolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, float height)
+{
 	GLUtesselator * tess = gluNewTess();
 
 	gluTessCallback(tess, GLU_TESS_BEGIN,	(void (CALLBACK *)(void))TessBegin);
@@ -257,8 +401,8 @@ void glPolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, fl
 	}
 	gluEndPolygon (tess);
 	gluDeleteTess(tess);
-#endif
 }
+#endif
 
 #define 	line_TaxiWayHatch  line_BoundaryEdge+1
 #define 	line_BChequered    line_BoundaryEdge+2
@@ -71,5 +71,31 @@ void PointSequenceToVector(IGISPointSequence * ps, WED_MapZoomerNew * z, vector<
 	int is_hole, bool dupFirst = false);  // dupFirst == duplicate first/last node even on closed rings. Not desired to build polygons, but desired to draw lines
 void SideToPoints(IGISPointSequence * ps, int n, WED_MapZoomerNew * z,  vector<Point2>& out_pts);
 
+// The GL-free half of glPolygon2: tesselates the interleaved contours into a flat list of triangle vertices, UVs interleaved
+// the same way. Returns false (and no triangles) if the contours self-intersect and should not be drawn.
+bool TessellatePolygon2(const Point2 * pts, bool has_uv, const int * contours, int n, vector<Point2>& tris);
+// Draws n triangle vertices from TessellatePolygon2. With a zoomer, the vertices are lat/lon and get projected first.
+void glTriangles2(const Point2 * tris, bool has_uv, int n, float height = -1, WED_MapZoomerNew * z = NULL);
+// Like PointSequenceToVector, but the points stay lat/lon and beziers are subdivided for ppd pixels per degree latitude
+// instead of for the current view.
+void PointSequenceToVectorLL(IGISPointSequence * ps, double ppd, vector<Point2>& pts, bool get_uv, vector<int>& contours, int is_hole);
+
+// Tesselated polygons in lat/lon, so panning only has to project them. Everything is rebuilt when the archive changes or
+// the zoom leaves the current power-of-two subdivision bucket. Nothing in here touches GL.
+class WED_PolygonTessCache {
+public:
+	void					Validate(long long archive_key, double ppd);
+	const vector<Point2> *	Get(IGISPolygon * poly, bool has_uv);		// NULL if the polygon can't be drawn
+
+private:
+	struct tess_t {
+		bool			ok = false;
+		vector<Point2>	tris;
+	};
+	hash_map<IGISPolygon *, tess_t>	mPolys;
+	long long						mArchiveKey = -1;
+	double							mPPD = 0.0;
+};
+
 
 #endif /* WED_DrawUtils_H */
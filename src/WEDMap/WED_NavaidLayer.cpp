@@ -34,6 +34,8 @@
 #include "WED_PackageMgr.h"
 #include "MemFileUtils.h"
 #include "PlatformUtils.h"
+#include "FileUtils.h"
+#include "MathUtils.h"
 #include "GISUtils.h"
 
 #if 0
@@ -62,6 +64,15 @@ printf("1 to 2 time: %lf\n", elapsed.count());
 
 #define NAVAID_EXTRA_RANGE  GLOBAL_WED_ART_ASSET_FUDGE_FACTOR  // degree's lon/lat, allows ILS beams to show even if the ILS is outside of the map window
 
+#define NAVAID_CELLS_X 360  // 1x1 degree cells for the draw index
+#define NAVAID_CELLS_Y 180
+
+#define NAVAID_CACHE_MAGIC   0x4E415643  // NAVC
+#define NAVAID_CACHE_VERSION 1
+
+static inline int navaid_cell_x(double lon) { return intlim((int) floor(lon + 180.0), 0, NAVAID_CELLS_X - 1); }
+static inline int navaid_cell_y(double lat) { return intlim((int) floor(lat +  90.0), 0, NAVAID_CELLS_Y - 1); }
+
 #if COMPARE_GW_TO_APTDAT
 
 #include <json/json.h>
@@ -396,8 +407,147 @@ static void parse_atc_dat(MFMemFile * str, vector<navaid_t>& mNavaids)
 }
 
 
+/*
+	Parsed navaid cache
+
+	Parsing nav.dat, atc.dat and both apt.dat takes seconds, so the parsed table is kept in the OS cache folder.
+	It is only used if every source file still has the size and modification time it had when the cache was
+	written - a file that was missing then must still be missing.
+*/
+
+struct navaid_source_t {
+	string		path;
+	long long	size;
+	long long	mtime;
+};
+
+static navaid_source_t navaid_source(const string& path)
+{
+	navaid_source_t src;
+	struct stat meta;
+	src.path = path;
+	if(FILE_get_file_meta_data(path, meta) == 0)
+	{
+		src.size = meta.st_size;
+		src.mtime = meta.st_mtime;
+	}
+	else
+		src.size = src.mtime = -1;
+	return src;
+}
+
+template <class T>
+static void cache_put(string& buf, const T& v) { buf.append((const char *) &v, sizeof(v)); }
+static void cache_put(string& buf, const string& v) { cache_put(buf, (int) v.size()); buf.append(v); }
+
+template <class T>
+static bool cache_get(const char *& p, const char * e, T& v)
+{
+	if(e - p < (ptrdiff_t) sizeof(v)) return false;
+	memcpy(&v, p, sizeof(v));
+	p += sizeof(v);
+	return true;
+}
+
+static bool cache_get(const char *& p, const char * e, string& v)
+{
+	int len;
+	if(!cache_get(p, e, len) || len < 0 || len > e - p) return false;
+	v.assign(p, len);
+	p += len;
+	return true;
+}
+
+static void write_navaid_cache(const string& path, const vector<navaid_source_t>& sources, const vector<navaid_t>& navaids)
+{
+	string buf;
+	cache_put(buf, (int) NAVAID_CACHE_MAGIC);
+	cache_put(buf, (int) NAVAID_CACHE_VERSION);
+	cache_put(buf, (int) sources.size());
+	for(vector<navaid_source_t>::const_iterator s = sources.begin(); s != sources.end(); ++s)
+	{
+		cache_put(buf, s->path);
+		cache_put(buf, s->size);
+		cache_put(buf, s->mtime);
+	}
+	cache_put(buf, (int) navaids.size());
+	for(vector<navaid_t>::const_iterator n = navaids.begin(); n != navaids.end(); ++n)
+	{
+		cache_put(buf, n->type);
+		cache_put(buf, n->lonlat.x());
+		cache_put(buf, n->lonlat.y());
+		cache_put(buf, n->heading);
+		cache_put(buf, n->name);
+		cache_put(buf, n->icao);
+		cache_put(buf, n->freq);
+		cache_put(buf, n->rwy);
+		cache_put(buf, (int) n->shape.size());
+		for(vector<Point2>::const_iterator p = n->shape.begin(); p != n->shape.end(); ++p)
+		{
+			cache_put(buf, p->x());
+			cache_put(buf, p->y());
+		}
+	}
+
+	// Renamed into place, as another copy of WED may be reading the old cache right now.
+	FILE_write_file_atomic(path, buf.data(), buf.size());       // no cache next time, no big deal
+}
+
+static bool read_navaid_cache(const string& path, const vector<navaid_source_t>& sources, vector<navaid_t>& navaids)
+{
+	MFMemFile * str = MemFile_Open(path.c_str());
+	if(!str) return false;
+
+	const char * p = MemFile_GetBegin(str);
+	const char * e = MemFile_GetEnd(str);
+	bool ok = false;
+	int magic, version, count;
+
+	if(cache_get(p, e, magic) && magic == NAVAID_CACHE_MAGIC &&
+	   cache_get(p, e, version) && version == NAVAID_CACHE_VERSION &&
+	   cache_get(p, e, count) && count == sources.size())
+	{
+		ok = true;
+		for(vector<navaid_source_t>::const_iterator s = sources.begin(); ok && s != sources.end(); ++s)
+		{
+			navaid_source_t c;
+			ok = cache_get(p, e, c.path) && cache_get(p, e, c.size) && cache_get(p, e, c.mtime) &&
+				c.path == s->path && c.size == s->size && c.mtime == s->mtime;
+		}
+		ok = ok && cache_get(p, e, count) && count >= 0;
+		if(ok)
+		{
+			navaids.resize(count);
+			for(vector<navaid_t>::iterator n = navaids.begin(); ok && n != navaids.end(); ++n)
+			{
+				double x, y;
+				int pts;
+				ok = cache_get(p, e, n->type) && cache_get(p, e, x) && cache_get(p, e, y) && cache_get(p, e, n->heading) &&
+					cache_get(p, e, n->name) && cache_get(p, e, n->icao) && cache_get(p, e, n->freq) && cache_get(p, e, n->rwy) &&
+					cache_get(p, e, pts) && pts >= 0 && pts <= (e - p) / (ptrdiff_t) (2 * sizeof(double));
+				n->lonlat = Point2(x, y);
+				if(ok)
+				{
+					n->shape.resize(pts);
+					for(vector<Point2>::iterator sp = n->shape.begin(); sp != n->shape.end(); ++sp)
+					{
+						cache_get(p, e, x);
+						cache_get(p, e, y);
+						*sp = Point2(x, y);
+					}
+				}
+			}
+			ok = ok && p == e;
+		}
+	}
+	MemFile_Close(str);
+	if(!ok) navaids.clear();
+	return ok;
+}
+
+
 WED_NavaidLayer::WED_NavaidLayer(GUI_Pane * host, WED_MapZoomerNew * zoomer, IResolver * resolver) :
-	WED_MapLayer(host,zoomer,resolver)
+	WED_MapLayer(host,zoomer,resolver), mLoaded(false)
 {
     SetVisible(false);
 	// ToDo: when using the gateway JSON data, initiate asynchronous load/update here.
@@ -405,78 +555,143 @@ WED_NavaidLayer::WED_NavaidLayer(GUI_Pane * host, WED_MapZoomerNew * zoomer, IRe
 
 WED_NavaidLayer::~WED_NavaidLayer()
 {
+	Stop();
+	if(mLoader.joinable())
+		mLoader.join();
 }
 
-void WED_NavaidLayer::LoadNavaids()
+void WED_NavaidLayer::LoadNavaids(string resourcePath)
 {
 // ToDo: move this into PackageMgr, so its updated when XPlaneFolder changes and re-used when another scenery is opened
-	string resourcePath;
-	gPackageMgr->GetXPlaneFolder(resourcePath);
-
-	mNavaids.reserve(25000);    // about 3 MBytes, as of 2018 its some 20,200 navaids
 
 	// deliberately ignoring any Custom Data/earth_424.dat or Custom Data/earth_nav.dat files that a user may have ... to avoid confusion
 	string defaultNavaids  = resourcePath + DIR_STR "Resources" DIR_STR "default data" DIR_STR "earth_nav.dat";
 	string globalNavaids = resourcePath + DIR_STR "Custom Scenery" DIR_STR "Global Airports" DIR_STR "Earth nav data" DIR_STR "earth_nav.dat";
-	
-	MFMemFile * str = MemFile_Open(defaultNavaids.c_str());
-	if(str) parse_nav_dat(str, mNavaids, false);
-	str = MemFile_Open(globalNavaids.c_str());
-	if(str)	parse_nav_dat(str, mNavaids, true);
-	
 	string defaultATC = resourcePath + DIR_STR "Resources" DIR_STR "default scenery" DIR_STR "default atc dat" DIR_STR "Earth nav data" DIR_STR "atc.dat";
+	// on the linux and OSX platforms this path was different before XP11.30 for some unknown reasons. So try that.
+	string oldDefaultATC = resourcePath + DIR_STR "Resources" DIR_STR "default scenery" DIR_STR "default atc" DIR_STR "Earth nav data" DIR_STR "atc.dat";
 	string seattleATC  = resourcePath + DIR_STR "Custom Scenery" DIR_STR "KSEA Demo Area" DIR_STR "Earth nav data" DIR_STR "atc.dat";
+#if SHOW_APTS_FROM_APTDAT
+	string defaultApts = resourcePath + DIR_STR "Resources" DIR_STR "default scenery" DIR_STR "default apt dat" DIR_STR "Earth nav data" DIR_STR "apt.dat";
+	string globalApts  = resourcePath + DIR_STR "Custom Scenery" DIR_STR "Global Airports" DIR_STR "Earth nav data" DIR_STR "apt.dat";
+#endif
 
-	str = MemFile_Open(defaultATC.c_str());
+	vector<navaid_source_t> sources;
+	sources.push_back(navaid_source(defaultNavaids));
+	sources.push_back(navaid_source(globalNavaids));
+	sources.push_back(navaid_source(defaultATC));
+	sources.push_back(navaid_source(oldDefaultATC));
+	sources.push_back(navaid_source(seattleATC));
+#if SHOW_APTS_FROM_APTDAT
+	sources.push_back(navaid_source(defaultApts));
+	sources.push_back(navaid_source(globalApts));
+#endif
 
-	// on the linux and OSX platforms this path was different before XP11.30 for some unknown reasons. So try that.
-	if(!str)
+	string cachePath = GetCacheFolder();
+	if(!cachePath.empty())
+		cachePath += DIR_STR "wed_navaids.bin";
+
+	if(cachePath.empty() || !read_navaid_cache(cachePath, sources, mNavaids))
 	{
-		defaultATC = resourcePath + DIR_STR "Resources" DIR_STR "default scenery" DIR_STR "default atc" DIR_STR "Earth nav data" DIR_STR "atc.dat";
+		mNavaids.reserve(25000);    // about 3 MBytes, as of 2018 its some 20,200 navaids
+
+		MFMemFile * str = MemFile_Open(defaultNavaids.c_str());
+		if(str) parse_nav_dat(str, mNavaids, false);
+		str = MemFile_Open(globalNavaids.c_str());
+		if(str)	parse_nav_dat(str, mNavaids, true);
+
 		str = MemFile_Open(defaultATC.c_str());
-	}
-	if(str)	parse_atc_dat(str, mNavaids);
-	str = MemFile_Open(seattleATC.c_str());
-	if(str)	parse_atc_dat(str, mNavaids);
-	
+		if(!str)
+			str = MemFile_Open(oldDefaultATC.c_str());
+		if(str)	parse_atc_dat(str, mNavaids);
+		str = MemFile_Open(seattleATC.c_str());
+		if(str)	parse_atc_dat(str, mNavaids);
+		
 #if SHOW_APTS_FROM_APTDAT
-	map<string,navaid_t> tAirports;
-	string defaultApts = resourcePath + DIR_STR "Resources" DIR_STR "default scenery" DIR_STR "default apt dat" DIR_STR "Earth nav data" DIR_STR "apt.dat";
-	string globalApts  = resourcePath + DIR_STR "Custom Scenery" DIR_STR "Global Airports" DIR_STR "Earth nav data" DIR_STR "apt.dat";
+		map<string,navaid_t> tAirports;
 
-	str = MemFile_Open(defaultApts.c_str());
-	if(str) parse_apt_dat(str, tAirports, "");
-	str = MemFile_Open(globalApts.c_str());
-	if(str) parse_apt_dat(str, tAirports, " (GW)");
+		str = MemFile_Open(defaultApts.c_str());
+		if(str) parse_apt_dat(str, tAirports, "");
+		str = MemFile_Open(globalApts.c_str());
+		if(str) parse_apt_dat(str, tAirports, " (GW)");
 
 #if COMPARE_GW_TO_APTDAT
-	map<string,navaid_t> tAirp;
-	get_airports(tAirp);
-	
-	for(auto a : tAirp)
-	{
-		auto b = tAirports.find(a.first);
-		if (b != tAirports.end())
+		map<string,navaid_t> tAirp;
+		get_airports(tAirp);
+		
+		for(auto a : tAirp)
 		{
-			double dist = LonLatDistMeters(a.second.lonlat, b->second.lonlat);
-			if (dist < 150000)
-				printf("  matched %7s ll=%8.3lf %7.3lf d=%5.1lf km %s\n", a.first.c_str(), a.second.lonlat.x(), a.second.lonlat.y(), dist/1000.0, dist < 1000.0 ? "Good !" : "");
+			auto b = tAirports.find(a.first);
+			if (b != tAirports.end())
+			{
+				double dist = LonLatDistMeters(a.second.lonlat, b->second.lonlat);
+				if (dist < 150000)
+					printf("  matched %7s ll=%8.3lf %7.3lf d=%5.1lf km %s\n", a.first.c_str(), a.second.lonlat.x(), a.second.lonlat.y(), dist/1000.0, dist < 1000.0 ? "Good !" : "");
+				else
+					printf("  matched %7s ll=%8.3lf %7.3lf d=%5.0lf km Wow ! apt.dat ll=%8.3lf %7.3lf\n", a.first.c_str(), a.second.lonlat.x(), a.second.lonlat.y(), dist/1000.0, b->second.lonlat.x(), b->second.lonlat.y());
+				if(dist > 1000.0)
+					printf("UPDATE airports SET Latitude=%.3lf, Longitude=%.3lf WHERE AirportCode=\"%s\";\n", b->second.lonlat.y(), b->second.lonlat.x(), a.first.c_str());
+			}
 			else
-				printf("  matched %7s ll=%8.3lf %7.3lf d=%5.0lf km Wow ! apt.dat ll=%8.3lf %7.3lf\n", a.first.c_str(), a.second.lonlat.x(), a.second.lonlat.y(), dist/1000.0, b->second.lonlat.x(), b->second.lonlat.y());
-			if(dist > 1000.0)
-				printf("UPDATE airports SET Latitude=%.3lf, Longitude=%.3lf WHERE AirportCode=\"%s\";\n", b->second.lonlat.y(), b->second.lonlat.x(), a.first.c_str());
+				printf("unmatched %7s ll=%8.3lf %7.3lf\n", a.first.c_str(), a.second.lonlat.x(), a.second.lonlat.y());
 		}
-		else
-			printf("unmatched %7s ll=%8.3lf %7.3lf\n", a.first.c_str(), a.second.lonlat.x(), a.second.lonlat.y());
-	}
 #endif
 
-	for(map<string, navaid_t>::iterator i = tAirports.begin(); i != tAirports.end(); ++i)
-		mNavaids.push_back(i->second);
+		for(map<string, navaid_t>::iterator i = tAirports.begin(); i != tAirports.end(); ++i)
+			mNavaids.push_back(i->second);
 #endif
 
-// Todo: speedup drawing by sorting mNavaids into longitude buckets, so the preview function only have to go through a smalller part of the overall list.
-//       although for now Navaid map drawing is under 1 msec on a 3.6 GHz CPU at all times == good enough
+		if(!cachePath.empty() && !mNavaids.empty())
+			write_navaid_cache(cachePath, sources, mNavaids);
+	}
+
+	BuildIndex();
+	mLoaded = true;
+}
+
+void WED_NavaidLayer::BuildIndex()
+{
+	// Counting sort of the navaid indices by cell - each cell keeps its navaids in mNavaids order.
+	mCellStart.assign(NAVAID_CELLS_X * NAVAID_CELLS_Y + 1, 0);
+	mCellNavaids.resize(mNavaids.size());
+
+	vector<int> cells(mNavaids.size());
+	for(int i = 0; i < mNavaids.size(); ++i)
+	{
+		cells[i] = navaid_cell_x(mNavaids[i].lonlat.x()) + NAVAID_CELLS_X * navaid_cell_y(mNavaids[i].lonlat.y());
+		mCellStart[cells[i] + 1]++;
+	}
+	for(int c = 0; c < NAVAID_CELLS_X * NAVAID_CELLS_Y; ++c)
+		mCellStart[c + 1] += mCellStart[c];
+
+	vector<int> fill(mCellStart.begin(), mCellStart.end() - 1);
+	for(int i = 0; i < mNavaids.size(); ++i)
+		mCellNavaids[fill[cells[i]]++] = i;
+}
+
+// Indices of the navaids in the cells overlapping the given lon/lat box, in mNavaids order - so things still overlap the way they always did.
+void WED_NavaidLayer::GetVisibleNavaids(double west, double south, double east, double north, vector<int>& visible) const
+{
+	int x0 = navaid_cell_x(west), x1 = navaid_cell_x(east);
+	int y0 = navaid_cell_y(south), y1 = navaid_cell_y(north);
+	for(int y = y0; y <= y1; ++y)
+	for(int x = x0; x <= x1; ++x)
+	{
+		int c = x + NAVAID_CELLS_X * y;
+		visible.insert(visible.end(), mCellNavaids.begin() + mCellStart[c], mCellNavaids.begin() + mCellStart[c + 1]);
+	}
+	sort(visible.begin(), visible.end());
+}
+
+void		WED_NavaidLayer::TimerFired(void)
+{
+	if(!mLoaded) return;
+	Stop();
+	mLoader.join();
+	if(mNavaids.empty())
+		mLoaded = false;    // no X-Plane folder (yet?) - try again next time we draw
+	else
+		GetHost()->Refresh();
 }
 
 void		WED_NavaidLayer::DrawVisualization		(bool inCurrent, GUI_GraphState * g)
@@ -484,7 +699,19 @@ void		WED_NavaidLayer::DrawVisualization		(bool inCurrent, GUI_GraphState * g)
 	double ll,lb,lr,lt;	// logical boundary
 	double vl,vb,vr,vt;	// visible boundry
 
-	if(mNavaids.empty()) LoadNavaids();
+	// The navaids are loaded on a worker thread the first time we are drawn, and we draw nothing until they are in.
+	if(!mLoaded)
+	{
+		if(!mLoader.joinable())
+		{
+			string resourcePath;
+			gPackageMgr->GetXPlaneFolder(resourcePath);
+			mNavaids.clear();
+			mLoader = thread(&WED_NavaidLayer::LoadNavaids, this, resourcePath);
+			Start(0.1);
+		}
+		return;
+	}
 
 	GetZoomer()->GetMapLogicalBounds(ll,lb,lr,lt);
 	GetZoomer()->GetMapVisibleBounds(vl,vb,vr,vt);
@@ -508,8 +735,12 @@ void		WED_NavaidLayer::DrawVisualization		(bool inCurrent, GUI_GraphState * g)
 	glDisable(GL_LINE_STIPPLE);
 	
 	if (PPM > 0.0005)          // stop displaying navaids when zoomed out - gets too crowded
-		for(vector<navaid_t>::iterator i = mNavaids.begin(); i != mNavaids.end(); ++i)  // this is brain dead - use list sorted by longitude
+	{
+		vector<int> visible;
+		GetVisibleNavaids(vl, vb, vr, vt, visible);
+		for(vector<int>::iterator v = visible.begin(); v != visible.end(); ++v)
 		{
+			vector<navaid_t>::iterator i = mNavaids.begin() + *v;
 			if(i->lonlat.x() > vl && i->lonlat.x() < vr &&
 			   i->lonlat.y() > vb && i->lonlat.y() < vt)
 			{
@@ -610,6 +841,7 @@ void		WED_NavaidLayer::DrawVisualization		(bool inCurrent, GUI_GraphState * g)
 				}
 			}
 		}
+	}
 
 }
 
@@ -25,7 +25,10 @@
 #define WED_NavaidLayer_H
 
 #include "WED_MapLayer.h"
+#include "GUI_Timer.h"
 #include "CompGeomDefs2.h"
+#include <atomic>
+#include <thread>
 
 struct navaid_t {
 	int		type;
@@ -38,7 +41,7 @@ struct navaid_t {
 	vector<Point2> shape;
 };
 
-class WED_NavaidLayer : public WED_MapLayer {
+class WED_NavaidLayer : public WED_MapLayer, public GUI_Timer {
 public:
 
 						 WED_NavaidLayer(GUI_Pane * host, WED_MapZoomerNew * zoomer, IResolver * resolver);
@@ -46,11 +49,22 @@ public:
 
 	virtual	void		DrawVisualization		(bool inCurrent, GUI_GraphState * g);
 	virtual	void		GetCaps(bool& draw_ent_v, bool& draw_ent_s, bool& cares_about_sel, bool& wants_clicks);
+	virtual	void		TimerFired(void);
 
 private:
 
-	void				LoadNavaids();
+	void				LoadNavaids(string resourcePath);		// runs on mLoader
+	void				BuildIndex();
+	void				GetVisibleNavaids(double west, double south, double east, double north, vector<int>& visible) const;
+
 	vector<navaid_t>	mNavaids;
+
+	// Navaids bucketed by the 1x1 degree cell of their location - cell c holds mCellNavaids[mCellStart[c] .. mCellStart[c+1]-1]
+	vector<int>			mCellStart;
+	vector<int>			mCellNavaids;
+
+	thread				mLoader;
+	atomic<bool>		mLoaded;		// mNavaids and the index are complete and only read from here on
 };
 
 #endif /* WED_NavaidLayer_H */
@@ -615,9 +615,21 @@ struct	preview_sealane : public WED_PreviewItem {
 struct	preview_polygon : public WED_PreviewItem {
 	WED_GISPolygon * pol;
  	bool has_uv;
-	preview_polygon(WED_GISPolygon * p, int l, bool uv) : WED_PreviewItem(l), pol(p), has_uv(uv) { }
+	WED_PolygonTessCache * tess;
+	preview_polygon(WED_GISPolygon * p, int l, bool uv, WED_PolygonTessCache * t) : WED_PreviewItem(l), pol(p), has_uv(uv), tess(t) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
+		if(tess)
+		{
+			if(const vector<Point2> * tris = tess->Get(pol, has_uv))
+			{
+				glFrontFace(GL_CCW);
+				glTriangles2(tris->data(), has_uv, tris->size() / (has_uv ? 2 : 1), -1, zoomer);
+				glFrontFace(GL_CW);
+			}
+			return;
+		}
+
 		vector<Point2>	pts;
 		vector<int>		is_hole_start;
 
@@ -637,7 +649,7 @@ struct	preview_polygon : public WED_PreviewItem {
 
 struct	preview_taxiway : public preview_polygon {
 	WED_Taxiway * taxi;
-	preview_taxiway(WED_Taxiway * t, int l) : preview_polygon(t, l, false), taxi(t) { }
+	preview_taxiway(WED_Taxiway * t, int l, WED_PolygonTessCache * tc) : preview_polygon(t, l, false, tc), taxi(t) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
 		// I tried "LODing" out the solid pavement, but the margin between when the pavement can disappear and when the whole
@@ -655,7 +667,7 @@ struct	preview_taxiway : public preview_polygon {
 
 struct	preview_forest : public preview_polygon {
 	WED_ForestPlacement * fst;
-	preview_forest(WED_ForestPlacement * f, int l) : preview_polygon(f,l,false), fst(f) { }
+	preview_forest(WED_ForestPlacement * f, int l, WED_PolygonTessCache * tc) : preview_polygon(f,l,false,tc), fst(f) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
 		g->SetState(false,0,false,false,false,false,false);
@@ -1108,7 +1120,7 @@ struct	preview_airportlights : WED_PreviewItem {
 struct	preview_facade : public preview_polygon {
 	WED_FacadePlacement * fac;
 	IResolver * resolver;
-	preview_facade(WED_FacadePlacement * f, int l, IResolver * r) : preview_polygon(f,l,false), fac(f), resolver(r) { }
+	preview_facade(WED_FacadePlacement * f, int l, IResolver * r) : preview_polygon(f,l,false,NULL), fac(f), resolver(r) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
 		IGISPointSequence * ps = fac->GetOuterRing();
@@ -1186,7 +1198,7 @@ struct	preview_facade : public preview_polygon {
 struct	preview_pol : public preview_polygon {
 	WED_PolygonPlacement * pol;
 	IResolver * resolver;
-	preview_pol(WED_PolygonPlacement * p, int l, IResolver * r) : preview_polygon(p,l,false), pol(p), resolver(r) { }
+	preview_pol(WED_PolygonPlacement * p, int l, IResolver * r, WED_PolygonTessCache * tc) : preview_polygon(p,l,false,tc), pol(p), resolver(r) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
 		WED_ResourceMgr * rmgr = WED_GetResourceMgr(resolver);
@@ -1208,7 +1220,7 @@ struct	preview_pol : public preview_polygon {
 struct	preview_autogen: public preview_polygon {
 	WED_AutogenPlacement * ags;
 	IResolver * resolver;
-	preview_autogen(WED_AutogenPlacement * a, int l, IResolver * r) : preview_polygon(a,l,false), ags(a), resolver(r) { }
+	preview_autogen(WED_AutogenPlacement * a, int l, IResolver * r, WED_PolygonTessCache * tc) : preview_polygon(a,l,false,tc), ags(a), resolver(r) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
 		IGISPointSequence * ps = ags->GetOuterRing();
@@ -1262,7 +1274,7 @@ struct	preview_autogen: public preview_polygon {
 struct	preview_ortho : public preview_polygon {
 	WED_DrapedOrthophoto * orth;
 	IResolver * resolver;
-	preview_ortho(WED_DrapedOrthophoto * o, int l, IResolver * r) : preview_polygon(o,l,true), orth(o), resolver(r) { }
+	preview_ortho(WED_DrapedOrthophoto * o, int l, IResolver * r, WED_PolygonTessCache * tc) : preview_polygon(o,l,true,tc), orth(o), resolver(r) { }
 	virtual void draw_it(WED_MapZoomerNew * zoomer, GUI_GraphState * g, float mPavementAlpha)
 	{
 		WED_ResourceMgr * rmgr = WED_GetResourceMgr(resolver);
@@ -1771,7 +1783,7 @@ bool		WED_PreviewLayer::DrawEntityVisualization		(bool inCurrent, IGISEntity * e
 		WED_Taxiway * taxi = SAFE_CAST(WED_Taxiway,entity);
 		if(taxi)
 		{
-			mPreviewItems.push_back(new preview_taxiway(taxi,mTaxiLayer++));
+			mPreviewItems.push_back(new preview_taxiway(taxi,mTaxiLayer++, &mTessCache));
 
 // f'd up - its culling by taxiway polygon size and not by gis chain line width. And thats after all the dynamic casting, boundig box pulling and all ...oh my.
 
@@ -1808,7 +1820,7 @@ bool		WED_PreviewLayer::DrawEntityVisualization		(bool inCurrent, IGISEntity * e
 			pol->GetResource(vpath);
 			if(!vpath.empty() && rmgr->GetPol(vpath,pol_info) && !pol_info->group.empty())
 				lg = layer_group_for_string(pol_info->group.c_str(),pol_info->group_offset, lg);
-			mPreviewItems.push_back(new preview_pol(pol,lg, GetResolver()));
+			mPreviewItems.push_back(new preview_pol(pol,lg, GetResolver(), &mTessCache));
 		}
 	}
 	else if (sub_class == WED_DrapedOrthophoto::sClass)
@@ -1824,7 +1836,7 @@ bool		WED_PreviewLayer::DrawEntityVisualization		(bool inCurrent, IGISEntity * e
 			orth->GetResource(vpath);
 			if(!vpath.empty() && rmgr->GetPol(vpath,pol_info) && !pol_info->group.empty())
 				lg = layer_group_for_string(pol_info->group.c_str(),pol_info->group_offset, lg);
-			mPreviewItems.push_back(new preview_ortho(orth,lg, GetResolver()));
+			mPreviewItems.push_back(new preview_ortho(orth,lg, GetResolver(), &mTessCache));
 		}
 	}
 	else if (sub_class == WED_FacadePlacement::sClass)
@@ -1836,7 +1848,7 @@ bool		WED_PreviewLayer::DrawEntityVisualization		(bool inCurrent, IGISEntity * e
 	else if (sub_class == WED_ForestPlacement::sClass)
 	{
 		WED_ForestPlacement * forst = SAFE_CAST(WED_ForestPlacement, entity);
-		if(forst) mPreviewItems.push_back(new preview_forest(forst, group_Footprints));
+		if(forst) mPreviewItems.push_back(new preview_forest(forst, group_Footprints, &mTessCache));
 	}
 	else if(sub_class == WED_LinePlacement::sClass)
 	{
@@ -1871,7 +1883,7 @@ bool		WED_PreviewLayer::DrawEntityVisualization		(bool inCurrent, IGISEntity * e
 	{
 		WED_AutogenPlacement * ags = SAFE_CAST(WED_AutogenPlacement, entity);
 		if(ags)
-			mPreviewItems.push_back(new preview_autogen(ags, group_Objects, GetResolver()));
+			mPreviewItems.push_back(new preview_autogen(ags, group_Objects, GetResolver(), &mTessCache));
 	}
 
 	/******************************************************************************************************************************
@@ -1940,6 +1952,7 @@ void		WED_PreviewLayer::DrawVisualization			(bool inCurent, GUI_GraphState * g)
 	// This is called after per-entity visualization; we have one preview item for everything we need.
 	// sort, draw, nuke 'em.
 
+	mTessCache.Validate(WED_GetWorld(GetResolver())->GetArchive()->CacheKey(), GetZoomer()->GetPPM() * DEG_TO_MTR_LAT);
 	sort(mPreviewItems.begin(),mPreviewItems.end(),sort_item_by_layer());
 	for(vector<WED_PreviewItem *>::iterator i = mPreviewItems.begin(); i != mPreviewItems.end(); ++i)
 	{
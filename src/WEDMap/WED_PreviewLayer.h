@@ -25,6 +25,7 @@
 #define WED_PreviewLayer_H
 
 #include "WED_MapLayer.h"
+#include "WED_DrawUtils.h"
 
 struct	XObj8;
 struct	agp_t;
@@ -96,6 +97,8 @@ private:
 	int							mShoulderLayer;
 	Options						mOptions;
 
+	WED_PolygonTessCache		mTessCache;			// survives between draws, unlike the items that use it
+
 };
 
 void draw_obj_at_xyz(ITexMgr * tman, const XObj8 * o, double x, double y, double z, float heading, GUI_GraphState * g);
@@ -792,6 +792,30 @@ bool IsGraphEdge(WED_Thing * what)
 	return dynamic_cast<IGISEdge*>(what) != NULL;
 }
 
+static void build_caches_recursive(WED_Thing * root)
+{
+	if(auto ent = dynamic_cast<IGISEntity *>(root))
+	{
+		Bbox2 b;
+		ent->GetBounds(gis_Geo, b);
+	}
+	if(auto seq = dynamic_cast<IGISPointSequence *>(root))
+		seq->GetNumPoints();
+	if(auto comp = dynamic_cast<IGISComposite *>(root))
+		comp->GetNumEntities();
+
+	int nn = root->CountChildren();
+	for(int n = 0; n < nn; ++n)
+		build_caches_recursive(root->GetNthChild(n));
+}
+
+void WED_BuildCachesRecursive(WED_Thing * root)
+{
+	// Fetching an object of a binary project for the first time instantiates it - don't let workers do that.
+	root->GetArchive()->MaterializeAll();
+	build_caches_recursive(root);
+}
+
 /*
 void CollectRecursive(WED_Thing * root, bool(* filter)(WED_Thing *), vector<WED_Thing *>& items)
 {
@@ -138,6 +138,10 @@ int Iterate_CollectEntitiesUV(ISelectable * what, void * ref);			// ref is a ptr
 
 bool IsGraphNode(WED_Thing * what);
 bool IsGraphEdge(WED_Thing * what);
+
+// Entities compute bounds and point lists lazily on first access. Call this before handing a (sub)tree to multiple
+// threads that only read it, so they don't race to build those caches (or to materialize lazily loaded objects).
+void WED_BuildCachesRecursive(WED_Thing * root);
 //void CollectRecursive(WED_Thing * root, bool(* filter)(WED_Thing *			  ),			 vector<WED_Thing *>& items);
 //void CollectRecursive(WED_Thing * root, bool(* filter)(WED_Thing *, void * ref), void * ref, vector<WED_Thing *>& items);
 
@@ -91,6 +91,31 @@
 
 #define DEBUG_EDGE_CROSSING 0
 
+// Grid cell of a coordinate for WED_select_doubles - cells are DOUBLE_PT_DIST on a side.
+static inline int double_pt_coord(double c)
+{
+	return (int) floor(c / DOUBLE_PT_DIST);
+}
+
+static inline long long double_pt_cell(int cx, int cy)
+{
+	return ((long long) cx << 32) | (unsigned int) cy;
+}
+
+// One edge in WED_do_select_crossing, with its sides pulled out once up front.
+struct crossing_edge {
+	int					idx;
+	const char *		subtype;
+	Bbox2				bounds;
+	vector<Bezier2>		sides;
+	vector<bool>		curved;
+};
+
+static bool crossing_edge_left_of(const crossing_edge& lhs, const crossing_edge& rhs)
+{
+	return lhs.bounds.xmin() < rhs.bounds.xmin();
+}
+
 namespace std
 {
 	template <> struct less<Point2>
@@ -1131,34 +1156,40 @@ set<WED_Thing *> WED_select_doubles(WED_Thing * t)
 
 	set<WED_Thing *> doubles;
 
-	// Ben says: yes this totally sucks - replace it someday?
+	// Bucket the nodes on a grid of DOUBLE_PT_DIST cells - any two nodes closer than that are in the same or neighboring cells.
+	vector<Point2> locs(pts.size());
+	hash_map<long long, vector<int> > grid;
 	for(int i = 0; i < pts.size(); ++i)
 	{
-		Point2 p1, p2;
 		IGISPoint * ii = dynamic_cast<IGISPoint *>(pts[i]);
-		ii->GetLocation(gis_Geo, p1);
+		DebugAssert(ii);
+		ii->GetLocation(gis_Geo, locs[i]);
+		grid[double_pt_cell(double_pt_coord(locs[i].x()), double_pt_coord(locs[i].y()))].push_back(i);
+	}
 
-		for(int j = i + 1; j < pts.size(); ++j)
+	// Each node is paired with the first later node that doubles it, same as walking every j > i in order.
+	for(int i = 0; i < pts.size(); ++i)
+	{
+		int cx = double_pt_coord(locs[i].x());
+		int cy = double_pt_coord(locs[i].y());
+		int first = pts.size();
+		for(int dy = -1; dy <= 1; ++dy)
+		for(int dx = -1; dx <= 1; ++dx)
 		{
-			IGISPoint * jj = dynamic_cast<IGISPoint *>(pts[j]);
-			jj->GetLocation(gis_Geo, p2);
-			DebugAssert(ii != jj);
-			DebugAssert(ii);
-			DebugAssert(jj);
-
-//			if(!(ii->GetGISSubtype() == jj->GetGISSubtype())) continue;
-
-//			Point2 p1, p2;
-//			ii->GetLocation(gis_Geo, p1);
-//			jj->GetLocation(gis_Geo, p2);
-
-			if(p1.squared_distance(p2) < (DOUBLE_PT_DIST*DOUBLE_PT_DIST))
+			hash_map<long long, vector<int> >::const_iterator c = grid.find(double_pt_cell(cx + dx, cy + dy));
+			if(c == grid.end()) continue;
+			for(vector<int>::const_iterator j = c->second.begin(); j != c->second.end() && *j < first; ++j)
+			if(*j > i && locs[i].squared_distance(locs[*j]) < (DOUBLE_PT_DIST*DOUBLE_PT_DIST))
 			{
-				doubles.insert(pts[i]);
-				doubles.insert(pts[j]);
+				first = *j;
 				break;
 			}
 		}
+		if(first < pts.size())
+		{
+			doubles.insert(pts[i]);
+			doubles.insert(pts[first]);
+		}
 	}
 	return doubles;
 }
@@ -1200,13 +1231,16 @@ set<WED_GISEdge *> WED_do_select_crossing(const vector<WED_GISEdge *>& edges , B
 	printf("select crossing on %ld edges\n",edges.size());
 	#endif
 	set<WED_GISEdge*> crossed_edges;
-	Bbox2 edge_bounds;
-	// Ben says: yes this totally sucks - replace it someday?
+
+	// Broad phase: box each edge by its sides' end and control points (a bezier never leaves those), sort by
+	// left edge and sweep - only edges of the same subtype whose boxes touch get the exact side-by-side test.
+	vector<crossing_edge> cands;
+	cands.reserve(edges.size());
 	for (int i = 0; i < edges.size(); ++i)
 	{
-		Bezier2 b1, b2;
 		IGISEdge * ii = edges[i];
 		DebugAssert(ii);
+		Bbox2 edge_bounds;
 		ii->GetBounds(gis_Geo,edge_bounds);
 		if(!cull_bounds.is_empty() && !cull_bounds.overlap(edge_bounds))
 		{
@@ -1216,60 +1250,65 @@ set<WED_GISEdge *> WED_do_select_crossing(const vector<WED_GISEdge *>& edges , B
 			continue;
 		}
 
-		bool isb1 = ii->GetSide(gis_Geo, 0, b1);
-
-		for (int j = i + 1; j < edges.size(); ++j)
+		cands.push_back(crossing_edge());
+		crossing_edge& c = cands.back();
+		c.idx = i;
+		c.subtype = ii->GetGISSubtype();
+		c.sides.resize(ii->GetNumSides());
+		c.curved.resize(c.sides.size());
+		for(int si = 0; si < c.sides.size(); si++)
 		{
-			IGISEdge * jj = edges[j];
-			DebugAssert(jj);
-			DebugAssert(ii != jj);
+			c.curved[si] = ii->GetSide(gis_Geo, si, c.sides[si]);
+			c.bounds += c.sides[si].p1;
+			c.bounds += c.sides[si].p2;
+			c.bounds += c.sides[si].c1;
+			c.bounds += c.sides[si].c2;
+		}
+	}
+	sort(cands.begin(), cands.end(), crossing_edge_left_of);
+
+	for (int a = 0; a < cands.size(); ++a)
+	for (int b = a + 1; b < cands.size() && cands[b].bounds.xmin() <= cands[a].bounds.xmax(); ++b)
+	{
+		if(!cands[a].bounds.overlap(cands[b].bounds)) continue;
+		if(cands[a].subtype != cands[b].subtype) continue;
 
-			jj->GetBounds(gis_Geo,edge_bounds);
-			if(!cull_bounds.is_empty() && !cull_bounds.overlap(edge_bounds))
+		// Always test in the caller's edge order, so the (not quite symmetric) bezier test sees the same pair it always did.
+		const crossing_edge& ci = cands[a].idx < cands[b].idx ? cands[a] : cands[b];
+		const crossing_edge& cj = cands[a].idx < cands[b].idx ? cands[b] : cands[a];
+		#if DEV && DEBUG_EDGE_CROSSING
+		printf("edges %d %d bounds do overlap !!\n",ci.idx,cj.idx);
+		#endif
+		for(int si = 0; si < ci.sides.size(); si++)
+			for(int sj = 0; sj < cj.sides.size(); sj++)
 			{
-				#if DEV && DEBUG_EDGE_CROSSING
-				printf("edges %d %d bounds dont overlap\n",i,j);
-				#endif
-				continue;
-			}
+				const Bezier2& b1 = ci.sides[si];
+				const Bezier2& b2 = cj.sides[sj];
 
-			if(ii->GetGISSubtype() != jj->GetGISSubtype()) continue;
-			#if DEV && DEBUG_EDGE_CROSSING
-			printf("edges %d %d bounds do overlap !!\n",i,j);
-			#endif
-			for(int si = 0; si < ii->GetNumSides(); si++)
-				for(int sj = 0; sj < jj->GetNumSides(); sj++)
+				if (ci.curved[si] || cj.curved[sj])
 				{
-					Bezier2 b1, b2;
-
-					bool isb1 = ii->GetSide(gis_Geo, si, b1);
-					bool isb2 = jj->GetSide(gis_Geo, sj, b2);
-
-					if (isb1 || isb2)
+					if (b1.intersect(b2, 10))
 					{
-						if (b1.intersect(b2, 10))
-						{
-							crossed_edges.insert(edges[i]);
-							crossed_edges.insert(edges[j]);
-						}
+						crossed_edges.insert(edges[ci.idx]);
+						crossed_edges.insert(edges[cj.idx]);
 					}
-					else
+				}
+				else
+				{
+					Point2 x;
+					if (b1.p1 != b2.p1 &&
+						b1.p2 != b2.p2 &&
+						b1.p1 != b2.p2 &&
+						b1.p2 != b2.p1)
 					{
-						Point2 x;
-						if (b1.p1 != b2.p1 &&
-							b1.p2 != b2.p2 &&
-							b1.p1 != b2.p2 &&
-							b1.p2 != b2.p1)
+						if (b1.as_segment().intersect(b2.as_segment(), x))
 						{
-							if (b1.as_segment().intersect(b2.as_segment(), x))
-							{
-								crossed_edges.insert(edges[i]);
-								crossed_edges.insert(edges[j]);
-							}
+							crossed_edges.insert(edges[ci.idx]);
+							crossed_edges.insert(edges[cj.idx]);
 						}
 					}
 				}
-		}
+			}
 	}
 
 	return crossed_edges;
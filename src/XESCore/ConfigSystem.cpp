@@ -22,9 +22,11 @@
  */
 #include "ConfigSystem.h"
 #include "MemFileUtils.h"
+#include "FileUtils.h"
 #include "CompGeomDefs2.h"
 #include "EnumSystem.h"
 #include <stdarg.h>
+#include <string.h>
 #include <list>
 #include "AssertUtils.h"
 using std::list;
@@ -112,6 +114,152 @@ bool	LoadConfigFile(const char * inFilename)
 }
 
 
+/************************************************************************************************
+ * COMPILED CONFIG CACHE
+ ************************************************************************************************
+ *
+ * Every GISTool and MeshTool run re-scans the same config text.  Once a file parses cleanly we
+ * write its tokenized lines to <file>.cache, tagged with a hash of the source text.  The next
+ * load maps the cache and feeds the lines straight to the handlers, so the handlers (and thus
+ * the token dictionary and every table built from them) see exactly what the text would have
+ * given them.  Any edit to the source changes the hash and we go back to the text.
+ *
+ * Layout (native byte order - the magic doesn't match on a foreign machine):
+ *
+ *	int		magic, version
+ *	uint64	hash of the source text
+ *	int		payload length
+ *	uint64	hash of the payload
+ *	payload: int line count, then per line an int token count and per token an int length + chars
+ *
+ * The payload hash means a cache half-written by another process is simply ignored.
+ */
+
+#define CONFIG_CACHE_MAGIC		0x58434647		// XCFG
+#define CONFIG_CACHE_VERSION	1
+#define CONFIG_CACHE_HEADER		(4 + 4 + 8 + 4 + 8)
+
+typedef vector<vector<string> >		ConfigLineVector;
+
+static unsigned long long	config_hash(const char * b, const char * e)
+{
+	unsigned long long h = 14695981039346656037ULL;		// FNV-1a
+	for (; b < e; ++b)
+	{
+		h ^= (unsigned char) *b;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+template <class T>
+static void	config_put(string& buf, const T& v)
+{
+	buf.append((const char *) &v, sizeof(v));
+}
+
+template <class T>
+static bool	config_get(const char *& p, const char * e, T& v)
+{
+	if (e - p < (ptrdiff_t) sizeof(v)) return false;
+	memcpy(&v, p, sizeof(v));
+	p += sizeof(v);
+	return true;
+}
+
+static void	WriteConfigCache(const string& inPath, unsigned long long inSourceHash, const ConfigLineVector& inLines)
+{
+	string	payload;
+	config_put(payload, (int) inLines.size());
+	for (ConfigLineVector::const_iterator l = inLines.begin(); l != inLines.end(); ++l)
+	{
+		config_put(payload, (int) l->size());
+		for (vector<string>::const_iterator t = l->begin(); t != l->end(); ++t)
+		{
+			config_put(payload, (int) t->size());
+			payload.append(*t);
+		}
+	}
+
+	string	header;
+	config_put(header, (int) CONFIG_CACHE_MAGIC);
+	config_put(header, (int) CONFIG_CACHE_VERSION);
+	config_put(header, inSourceHash);
+	config_put(header, (int) payload.size());
+	config_put(header, config_hash(payload.data(), payload.data() + payload.size()));
+
+	// Never rewrite the cache in place - another copy of the tool may have it mapped right now.
+	// If the config dir isn't writable we just don't get a cache - not an error.
+	header.append(payload);
+	FILE_write_file_atomic(inPath, header.data(), header.size());
+}
+
+// Open the cache for a source file; returns NULL unless it is intact and was made from this exact source text.
+// On success, outBegin/outEnd bracket the payload.
+static MFMemFile *	OpenConfigCache(const string& inPath, unsigned long long inSourceHash, const char *& outBegin, const char *& outEnd)
+{
+	MFMemFile * f = MemFile_Open(inPath.c_str());
+	if (f == NULL) return NULL;
+
+	const char * p = MemFile_GetBegin(f);
+	const char * e = MemFile_GetEnd(f);
+	int magic, version, len;
+	unsigned long long src_hash, payload_hash;
+	if (config_get(p, e, magic) && magic == CONFIG_CACHE_MAGIC &&
+		config_get(p, e, version) && version == CONFIG_CACHE_VERSION &&
+		config_get(p, e, src_hash) && src_hash == inSourceHash &&
+		config_get(p, e, len) &&
+		config_get(p, e, payload_hash) && e - p == len && payload_hash == config_hash(p, e))
+	{
+		outBegin = p;
+		outEnd = e;
+		return f;
+	}
+	MemFile_Close(f);
+	return NULL;
+}
+
+// Hand one tokenized line to its handler.  Returns 0 if it went through, 1 for an unknown token, 2 if the handler failed.
+static int	DispatchConfigLine(const vector<string>& tokens)
+{
+	HandlerMap::iterator h = sHandlerTable.find(tokens[0]);
+	if (h == sHandlerTable.end())
+		return 1;
+	if (!h->second.first(tokens,h->second.second))
+		return 2;
+	return 0;
+}
+
+// Replay a cache payload.  Returns -1 if the payload is malformed and the text should be parsed instead.
+static int	ReplayConfigCache(const char * p, const char * e, const char * inFilename)
+{
+	int				line_count, token_count, len;
+	vector<string>	tokens;
+	if (!config_get(p, e, line_count)) return -1;
+	while (line_count--)
+	{
+		if (!config_get(p, e, token_count) || token_count < 1) return -1;
+		tokens.resize(token_count);
+		for (int n = 0; n < token_count; ++n)
+		{
+			if (!config_get(p, e, len) || len < 0 || len > e - p) return -1;
+			tokens[n].assign(p, len);
+			p += len;
+		}
+		int err = DispatchConfigLine(tokens);
+		if (err)
+		{
+			if (err == 1)
+				printf("Unable to parse line: ");
+			else
+				printf("Parse error in file %s line: ", inFilename);
+			DebugPrintTokens(tokens);
+			return 0;
+		}
+	}
+	return 1;
+}
+
 bool	LoadConfigFileFullPath(const char * inFilename)
 {
 	MFMemFile *	f;
@@ -126,32 +274,51 @@ bool	LoadConfigFileFullPath(const char * inFilename)
 	dir.erase(dir.find_last_of("\\/:")+1);
 	sPathStack.push_back(dir);
 
+	string				cache_path = string(inFilename) + ".cache";
+	unsigned long long	source_hash = config_hash(MemFile_GetBegin(f), MemFile_GetEnd(f));
+	const char *		cache_begin, * cache_end;
+	MFMemFile *			cache = OpenConfigCache(cache_path, source_hash, cache_begin, cache_end);
+	if (cache)
+	{
+		int replayed = ReplayConfigCache(cache_begin, cache_end, inFilename);
+		MemFile_Close(cache);
+		if (replayed != -1)
+		{
+			MemFile_Close(f);
+			sPathStack.pop_back();
+			return replayed == 1;
+		}
+	}
+
 	MFTextScanner * scanner = TextScanner_Open(f);
 	if (scanner)
 	{
+		ConfigLineVector	compiled;
 		while (!TextScanner_IsDone(scanner))
 		{
 			vector<string>	tokens;
 			TextScanner_TokenizeLine(scanner, " \t", "\r\n#\"", -1, TokenizeFunc, &tokens);
 			if (!tokens.empty())
 			{
-				HandlerMap::iterator h = sHandlerTable.find(tokens[0]);
-				if (h == sHandlerTable.end())
+				int err = DispatchConfigLine(tokens);
+				if (err == 1)
 				{
 					string	line(TextScanner_GetBegin(scanner), TextScanner_GetEnd(scanner));
 					printf("Unable to parse line: %s\n", line.c_str());
 					goto bail;
 				}
-				if (!h->second.first(tokens,h->second.second))
+				if (err == 2)
 				{
 					string	line(TextScanner_GetBegin(scanner), TextScanner_GetEnd(scanner));
 					printf("Parse error in file %s line: %s\n", inFilename, line.c_str());
 					goto bail;
 				}
+				compiled.push_back(tokens);
 			}
 			TextScanner_Next(scanner);
 		}
 		ok = true;
+		WriteConfigCache(cache_path, source_hash, compiled);
 bail:
 		TextScanner_Close(scanner);
 	}
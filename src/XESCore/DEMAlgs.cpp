@@ -34,6 +34,7 @@
 #include "DEMAlgs.h"
 #include "WED_Globals.h"
 #include <math.h>
+#include <string.h>
 #include "AptAlgs.h"
 #include "MemFileUtils.h"
 #include "XESIO.h"
@@ -426,6 +427,15 @@ void	ReduceToBorder(const DEMGeo& inDEM, DEMGeo& outDEM)
 	}
 }
 
+// Neighboring blocks share their edge pixels.  Going block by block, the later block (higher y, then higher x)
+// wrote them last, so these pick that block for every derived pixel.  Each pixel is then computed once, from
+// the block whose value the block-by-block loop left behind.
+static inline void blob_block_for(int d, int mult, int blocks, int& iz, int& dd)
+{
+	iz = min(d / mult, blocks - 1);
+	dd = d - iz * mult;
+}
+
 // This routine takes a low res datasource and upsamples it.  It varies within a linear interpolation block
 // from the min to max seen in the corners based on another DEM used for 'noise' (usually relative elevation).
 // We blend to make sure we have linear interp at the edge of the linear interp block, so we get good tiling.
@@ -434,15 +444,17 @@ void BlobifyEnvironment(const DEMGeo& variant_source, const DEMGeo& base, DEMGeo
 {
 	derived.resize((base.mWidth-1)*xmult+1,(base.mHeight-1)*ymult+1);
 	derived.copy_geo_from(base);
+	if (base.mWidth < 2 || base.mHeight < 2)
+		return;
 
-	// for every 'block' to be usampled
-	for (int yiz = 0; yiz < base.mHeight-1; ++yiz)
-	for (int xiz = 0; xiz < base.mWidth-1; ++xiz)
-	{
-		// fer each point
-		for (int dy = 0; dy <= ymult; ++dy)
-		for (int dx = 0; dx <= xmult; ++dx)
+	dem_parallel_rows(derived.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < derived.mWidth; ++x)
 		{
+			int xiz, yiz, dx, dy;
+			blob_block_for(x, xmult, base.mWidth -1, xiz, dx);
+			blob_block_for(y, ymult, base.mHeight-1, yiz, dy);
+
 			float dx_fac = (float) dx / (float) xmult;
 			float dy_fac = (float) dy / (float) ymult;
 
@@ -470,8 +482,7 @@ void BlobifyEnvironment(const DEMGeo& variant_source, const DEMGeo& base, DEMGeo
 			float weird_mix = min(x_weird, y_weird) * gDemPrefs.rain_disturb;
 
 			// This is the 'noise' ratio from the variant source
-			float weird_ratio = variant_source.value_linear(derived.x_to_lon(xiz * xmult + dx),
-															derived.y_to_lat(yiz * ymult + dy));
+			float weird_ratio = variant_source.value_linear(derived.x_to_lon(x), derived.y_to_lat(y));
 			// How much to mix in this noise
 			weird_ratio = min(max(weird_ratio, 0.0f), 1.0f);
 			float max_ever = max(max(v1,v2),max(v3,v4));
@@ -481,11 +492,11 @@ void BlobifyEnvironment(const DEMGeo& variant_source, const DEMGeo& base, DEMGeo
 			float v_weird = min_ever + weird_ratio * (max_ever - min_ever);
 
 			// mix werid and linear
-			derived(xiz * xmult + dx, yiz * ymult + dy) =
+			derived(x, y) =
 				v_linear * (1.0 - weird_mix) +
 				v_weird  *        weird_mix;
 		}
-	}
+	});
 }
 
 // Same idea as above, but...try to "snap" enums.
@@ -493,23 +504,16 @@ void BlobifyEnvironmentEnum(const DEMGeo& variant_source, const DEMGeo& base, DE
 {
 	derived.resize((base.mWidth-1)*xmult+1,(base.mHeight-1)*ymult+1);
 	derived.copy_geo_from(base);
+	if (base.mWidth < 2 || base.mHeight < 2)
+		return;
 
-	// for every 'block' to be usampled
-	for (int yiz = 0; yiz < base.mHeight-1; ++yiz)
-	for (int xiz = 0; xiz < base.mWidth-1; ++xiz)
-	{
-		// fer each point
-		for (int dy = 0; dy <= ymult; ++dy)
-		for (int dx = 0; dx <= xmult; ++dx)
+	dem_parallel_rows(derived.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < derived.mWidth; ++x)
 		{
-			float dx_fac = (float) dx / (float) xmult;
-			float dy_fac = (float) dy / (float) ymult;
-
-			// This is the weights for a linear blend
-			double q1 = 	 dx_fac  * 		dy_fac;
-			double q2 = (1.0-dx_fac) * 		dy_fac;
-			double q3 = 	 dx_fac  * (1.0-dy_fac);
-			double q4 = (1.0-dx_fac) * (1.0-dy_fac);
+			int xiz, yiz, dx, dy;
+			blob_block_for(x, xmult, base.mWidth -1, xiz, dx);
+			blob_block_for(y, ymult, base.mHeight-1, yiz, dy);
 
 			// Four corner values
 			float v1 = base.get(xiz+1, yiz+1);
@@ -522,7 +526,7 @@ void BlobifyEnvironmentEnum(const DEMGeo& variant_source, const DEMGeo& base, DE
 			float w3 = variant_source.value_linear(base.x_to_lon(xiz+1), base.y_to_lat(yiz  ));
 			float w4 = variant_source.value_linear(base.x_to_lon(xiz  ), base.y_to_lat(yiz  ));
 
-			float w = variant_source.value_linear(derived.x_to_lon(xiz * xmult + dx), derived.y_to_lat(yiz * ymult + dy));
+			float w = variant_source.value_linear(derived.x_to_lon(x), derived.y_to_lat(y));
 		
 			float d1 = fabsf(w1-w);
 			float d2 = fabsf(w2-w);
@@ -530,15 +534,15 @@ void BlobifyEnvironmentEnum(const DEMGeo& variant_source, const DEMGeo& base, DE
 			float d4 = fabsf(w4-w);
 			
 			if(d1 > d2 && d1 > d3 && d1 > d4)
-				derived(xiz * xmult + dx, yiz * ymult + dy) = v1;
+				derived(x, y) = v1;
 			else if(d2 > d3 && d2 > d4)
-				derived(xiz * xmult + dx, yiz * ymult + dy) = v2;
+				derived(x, y) = v2;
 			else if (d3 > d4)
-				derived(xiz * xmult + dx, yiz * ymult + dy) = v3;
+				derived(x, y) = v3;
 			else
-				derived(xiz * xmult + dx, yiz * ymult + dy) = v4;
+				derived(x, y) = v4;
 		}
-	}
+	});
 }
 
 
@@ -1090,13 +1094,16 @@ void	DeriveDEMs(
 //		ioDEMs[dem_OrigLandUse] = ioDEMs[dem_LandUse];
 		DEMGeo& lu_t = ioDEMs[dem_LandUse];
 		if(do_translate)
-		for (int y = 0; y < lu_t.mHeight; ++y)
-		for (int x = 0; x < lu_t.mWidth; ++x)
-		{
-			int luv = lu_t.get(x,y);
-			if (gLandUseTransTable.count(luv))
-				lu_t(x,y) = gLandUseTransTable[luv];
-		}
+		dem_parallel_rows(lu_t.mHeight, [&](int y1, int y2) {
+			for (int y = y1; y < y2; ++y)
+			for (int x = 0; x < lu_t.mWidth; ++x)
+			{
+				int luv = lu_t.get(x,y);
+				LandUseTransTable::const_iterator t = gLandUseTransTable.find(luv);
+				if (t != gLandUseTransTable.end())
+					lu_t(x,y) = t->second;
+			}
+		});
 
 	}
 
@@ -1147,8 +1154,9 @@ void	DeriveDEMs(
 
 	{
 		DEMGeo	urbanTemp(landuse.mWidth, landuse.mHeight);
-		for (y = 0; y < landuse.mHeight;++y)
-		for (x = 0; x < landuse.mWidth; ++x)
+		dem_parallel_rows(landuse.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < landuse.mWidth; ++x)
 		{
 			float e = landuse.get(x,y);
 			
@@ -1175,6 +1183,7 @@ void	DeriveDEMs(
 			else														e = 0.0;		
 				urbanTemp(x,y) = e;
 		}
+		});
 		
 		urbanTemp.derez(8);
 		
@@ -1182,25 +1191,33 @@ void	DeriveDEMs(
 		urbanRadial.resize(urbanTemp.mWidth,urbanTemp.mHeight);
 		urbanTrans.resize(urbanTemp.mWidth,urbanTemp.mHeight);
 
-		for (y = 0; y < urbanTemp.mHeight;++y)
-		for (x = 0; x < urbanTemp.mWidth; ++x)
-		{
-			urban(x,y) 		= urbanTemp.kernelN(x,y, URBAN_DENSE_KERN_SIZE , sUrbanDenseSpreaderKernel);
-//			urban(x,y) 		= urbanTemp(x,y);
-			double local 	= urbanTemp.kernelN(x,y, URBAN_RADIAL_KERN_SIZE, sUrbanRadialSpreaderKernel);
-			urbanRadial(x,y) = local;
-			radial_max = max(local, radial_max);
-		}
+		// Max is order-independent, so per-band maxima combine to exactly the serial result.
+		vector<double>	band_max(urbanTemp.mHeight, 0.0);
+		dem_parallel_rows(urbanTemp.mHeight, [&](int y1, int y2) {
+			for (int y = y1; y < y2; ++y)
+			for (int x = 0; x < urbanTemp.mWidth; ++x)
+			{
+				urban(x,y) 		= urbanTemp.kernelN(x,y, URBAN_DENSE_KERN_SIZE , sUrbanDenseSpreaderKernel);
+//				urban(x,y) 		= urbanTemp(x,y);
+				double local 	= urbanTemp.kernelN(x,y, URBAN_RADIAL_KERN_SIZE, sUrbanRadialSpreaderKernel);
+				urbanRadial(x,y) = local;
+				band_max[y1] = max(local, band_max[y1]);
+			}
+		});
+		for (vector<double>::iterator m = band_max.begin(); m != band_max.end(); ++m)
+			radial_max = max(*m, radial_max);
 	}
 
 	if (radial_max > 0.0) urbanRadial *= (1.0 / radial_max);
 
-	for (y = 0; y < urban.mHeight;++y)
-	for (x = 0; x < urban.mWidth; ++x)
-	{
-		urban(x,y) = max(0.0f, min(1.0f, urban(x,y)));
-		urbanRadial(x,y) = max(0.0f, min(1.0f, urbanRadial(x,y)));
-	}
+	dem_parallel_rows(urban.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < urban.mWidth; ++x)
+		{
+			urban(x,y) = max(0.0f, min(1.0f, urban(x,y)));
+			urbanRadial(x,y) = max(0.0f, min(1.0f, urbanRadial(x,y)));
+		}
+	});
 
 	if (inMap.number_of_halfedges() > 0)
 		BuildRoadDensityDEM(inMap, urbanTrans);
@@ -1224,12 +1241,15 @@ void	DeriveDEMs(
 
 	urbanTrans.filter_self(URBAN_TRANS_KERN_SIZE, sUrbanTransSpreaderKernel);
 
-	for (y = 0; y < urbanTrans.mHeight; ++y)
-	for (x = 0; x < urbanTrans.mWidth; ++x)
-		urbanTrans(x,y) = max(0.0f, min(urbanTrans(x,y), 1.0f));
+	dem_parallel_rows(urbanTrans.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < urbanTrans.mWidth; ++x)
+			urbanTrans(x,y) = max(0.0f, min(urbanTrans(x,y), 1.0f));
+	});
 
-	for (y = 0; y < urbanSquare.mHeight; ++y)
-	for (x = 0; x < urbanSquare.mWidth; ++x)
+	dem_parallel_rows(urbanSquare.mHeight, [&](int y1, int y2) {
+	for (int y = y1; y < y2; ++y)
+	for (int x = 0; x < urbanSquare.mWidth; ++x)
 	{
 		float e = urbanSquare.get(x,y);
 		
@@ -1250,6 +1270,7 @@ else if(e == lu_globcover_INDUSTRY)							e = 2.0;
 else														e = DEM_NO_DATA;		
 		urbanSquare(x,y)=e;
 	}
+	});
 
 	SpreadDEMValues(urbanSquare);
 	if(urbanSquare.get(0,0) == DEM_NO_DATA)
@@ -1551,20 +1572,22 @@ else														e = DEM_NO_DATA;
 
 	if (inProg) inProg(0, 1, "Calculating Derived Raster Data", 1.0);
 
-	for (y = 0; y < landuse.mHeight;++y)
-	for (x = 0; x < landuse.mWidth; ++x)
-	{
-		int l = landuse.get(x,y);
-		float t = temp.get(temp.map_x_from(landuse,x),
-						 temp.map_y_from(landuse,y));
-		float r = rainfall.get(rainfall.map_x_from(landuse,x),
-						 rainfall.map_y_from(landuse,y));
+	dem_parallel_rows(landuse.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < landuse.mWidth; ++x)
+		{
+			int l = landuse.get(x,y);
+			float t = temp.get(temp.map_x_from(landuse,x),
+							 temp.map_y_from(landuse,y));
+			float r = rainfall.get(rainfall.map_x_from(landuse,x),
+							 rainfall.map_y_from(landuse,y));
 
-		int f = FindForest(l,t,r);
-		
-		if(f == NO_VALUE) f = DEM_NO_DATA;
-		forests(x,y) = f;				
-	}
+			int f = FindForest(l,t,r);
+			
+			if(f == NO_VALUE) f = DEM_NO_DATA;
+			forests(x,y) = f;				
+		}
+	});
 
 	forests.fill_nearest();
 
@@ -1661,11 +1684,13 @@ else														e = DEM_NO_DATA;
 	DEMGeo& bath_old(ioDEMs[dem_Bathymetry]);
 	
 	DEMGeo	bath_new(water_surface);
-	for(y = 0; y < bath_new.mHeight; ++y)
-	for(x = 0; x < bath_new.mWidth ; ++x)
-	{
-		bath_new(x,y) = min(bath_new(x,y) - MIN_DEPTH, bath_old.value_linear(bath_new.x_to_lon(x),bath_new.y_to_lat(y)));		
-	}
+	dem_parallel_rows(bath_new.mHeight, [&](int y1, int y2) {
+		for(int y = y1; y < y2; ++y)
+		for(int x = 0; x < bath_new.mWidth ; ++x)
+		{
+			bath_new(x,y) = min(bath_new(x,y) - MIN_DEPTH, bath_old.value_linear(bath_new.x_to_lon(x),bath_new.y_to_lat(y)));		
+		}
+	});
 	
 	bath_old.swap(bath_new);
 	
@@ -1683,47 +1708,48 @@ void	CalcSlopeParams(DEMGeoMap& ioDEMs, bool force, ProgressFunc inProg)
 	DEMGeo&	relativeElev = ioDEMs[dem_RelativeElevation];
 	DEMGeo& elevationRange = ioDEMs[dem_ElevationRange];
 
-	int y, x, x0, x1;
-	float e0, e1;
-
 	// This fills in missing datapoints with a simple, fast, scanline fill.
 	// this is needed to clean up raw SRTM data.
-	for (y = 0; y < elev.mHeight; ++y)
-	{
-		x0 = 0;
-		while (x0 < elev.mWidth)
+	dem_parallel_rows(elev.mHeight, [&](int y1, int y2) {
+		int x, x0, x1;
+		float e0, e1;
+		for (int y = y1; y < y2; ++y)
 		{
-			while (x0 < elev.mWidth && elev(x0,y) != DEM_NO_DATA)
-				++x0;
-			x1 = x0;
-			while (x1 < elev.mWidth && elev(x1,y) == DEM_NO_DATA)
-				++x1;
-
-			if (x0 < 0 && x1 >= elev.mWidth)
-				printf("ERROR: MISSING SCANLINED %d from dem.\n", y);
-			else if (x0 == 0)
+			x0 = 0;
+			while (x0 < elev.mWidth)
 			{
-				e1 = elev(x1, y);
-				for (x = x0; x < x1; ++x)
-					elev(x,y) = e1;
-			} else if (x1 >= elev.mWidth)
-			{
-				e0 = elev(x0-1, y);
-				for (x = x0; x < x1; ++x)
-					elev(x,y) = e0;
-			} else {
-				e0 = elev(x0-1, y);
-				e1 = elev(x1, y);
-				for (x = x0; x < x1; ++x)
+				while (x0 < elev.mWidth && elev(x0,y) != DEM_NO_DATA)
+					++x0;
+				x1 = x0;
+				while (x1 < elev.mWidth && elev(x1,y) == DEM_NO_DATA)
+					++x1;
+
+				if (x0 < 0 && x1 >= elev.mWidth)
+					printf("ERROR: MISSING SCANLINED %d from dem.\n", y);
+				else if (x0 == 0)
+				{
+					e1 = elev(x1, y);
+					for (x = x0; x < x1; ++x)
+						elev(x,y) = e1;
+				} else if (x1 >= elev.mWidth)
 				{
-					float rat = ((float) x - x0 + 1) / ((float) (x1 - x0 + 1));
-					elev(x,y) = e0 + rat * (e1 - e0);
+					e0 = elev(x0-1, y);
+					for (x = x0; x < x1; ++x)
+						elev(x,y) = e0;
+				} else {
+					e0 = elev(x0-1, y);
+					e1 = elev(x1, y);
+					for (x = x0; x < x1; ++x)
+					{
+						float rat = ((float) x - x0 + 1) / ((float) (x1 - x0 + 1));
+						elev(x,y) = e0 + rat * (e1 - e0);
+					}
 				}
-			}
 
-			x0 = x1;
+				x0 = x1;
+			}
 		}
-	}
+	});
 
 	DEMGeo	elev_not_insane(elev);
 	while(elev_not_insane.mWidth > 1201 || elev_not_insane.mHeight > 1201)
@@ -1750,18 +1776,20 @@ void	CalcSlopeParams(DEMGeoMap& ioDEMs, bool force, ProgressFunc inProg)
 		DEMGeo	mins, maxs;
 		DEMGeo_ReduceMinMaxN(elev2, mins, maxs, 8);
 
-		for (y = 0; y < elev2.mHeight; ++y)
-		for (x = 0; x < elev2.mWidth ; ++x)
-		{
-			e0 = mins.value_linear(elev2.x_to_lon(x), elev2.y_to_lat(y));
-			e1 = maxs.value_linear(elev2.x_to_lon(x), elev2.y_to_lat(y));
-			elevationRange(x,y) = e1 - e0;
+		dem_parallel_rows(elev2.mHeight, [&](int y1, int y2) {
+			for (int y = y1; y < y2; ++y)
+			for (int x = 0; x < elev2.mWidth ; ++x)
+			{
+				float e0 = mins.value_linear(elev2.x_to_lon(x), elev2.y_to_lat(y));
+				float e1 = maxs.value_linear(elev2.x_to_lon(x), elev2.y_to_lat(y));
+				elevationRange(x,y) = e1 - e0;
 
-			if (e0 == e1)
-				relativeElev(x,y) = 0.0;
-			else
-				relativeElev(x,y) = min(1.0f, max(0.0f, (elev2(x,y) - e0) / (e1 - e0)));
-		}
+				if (e0 == e1)
+					relativeElev(x,y) = 0.0;
+				else
+					relativeElev(x,y) = min(1.0f, max(0.0f, (elev2(x,y) - e0) / (e1 - e0)));
+			}
+		});
 		if (inProg) inProg(1, 2, "Calculating local min/max", 1.0);
 
 	}
@@ -2085,13 +2113,66 @@ float	IntegLine(const DEMGeo& dem, double x1, double y1, double x2, double y2, i
 
 #pragma mark -
 
-struct sort_pixel_by_height {
-	sort_pixel_by_height(const DEMGeo& d) : d_(d) { }
-	const DEMGeo& d_;
-	bool operator()(const DEMGeo::address lhs, const DEMGeo::address rhs) const {
-		return d_[lhs] < d_[rhs]; 
+// Orders every pixel address by height, ties in address order.  Watershed inputs are usually small integers
+// (neighbor counts, quantized elevations) so we bucket them directly; anything else gets a 4-pass radix sort
+// on the float bits, flipped so that unsigned order is float order.  Either way this is linear in the pixel count.
+static void	sort_pixels_by_height(const DEMGeo& d, vector<DEMGeo::address>& out_pixels)
+{
+	DEMGeo::address n = d.address_end();
+	out_pixels.resize(n);
+	if(n == 0)
+		return;
+
+	float lo = d[0], hi = d[0];
+	bool integral = true;
+	for(DEMGeo::address a = 0; a < n; ++a)
+	{
+		float v = d[a];
+		lo = min(lo, v);
+		hi = max(hi, v);
+		if(v != floorf(v))
+			integral = false;
+	}
+
+	if(integral && hi - lo < 4.0f * n + 256.0f)
+	{
+		vector<int>	start((int) (hi - lo) + 2, 0);
+		for(DEMGeo::address a = 0; a < n; ++a)
+			++start[(int) (d[a] - lo) + 1];
+		for(int b = 1; b < start.size(); ++b)
+			start[b] += start[b-1];
+		for(DEMGeo::address a = 0; a < n; ++a)
+			out_pixels[start[(int) (d[a] - lo)]++] = a;
+		return;
+	}
+
+	vector<unsigned int>		keys(n), keys_tmp(n);
+	vector<DEMGeo::address>		pix_tmp(n);
+	for(DEMGeo::address a = 0; a < n; ++a)
+	{
+		float v = d[a];
+		unsigned int k;
+		memcpy(&k, &v, sizeof(k));
+		keys[a] = (k & 0x80000000u) ? ~k : (k | 0x80000000u);
+		out_pixels[a] = a;
+	}
+	for(int shift = 0; shift < 32; shift += 8)
+	{
+		int	start[257] = { 0 };
+		for(DEMGeo::address i = 0; i < n; ++i)
+			++start[((keys[i] >> shift) & 0xFF) + 1];
+		for(int b = 1; b < 257; ++b)
+			start[b] += start[b-1];
+		for(DEMGeo::address i = 0; i < n; ++i)
+		{
+			int dst = start[(keys[i] >> shift) & 0xFF]++;
+			keys_tmp[dst] = keys[i];
+			pix_tmp[dst] = out_pixels[i];
+		}
+		keys.swap(keys_tmp);
+		out_pixels.swap(pix_tmp);
 	}
-};
+}
 
 // This code is directly based on "Watersheds in Digital Spaces: An Efficient Algorithm Based on Immersion Simulations"
 // by Luc Vincent and Pierre Soille from their 1991 paper.
@@ -2113,11 +2194,7 @@ void	Watershed(DEMGeo& input, DEMGeo& output,vector<DEMGeo::address> * out_water
 	address_fifo	fifo(input.mWidth * input.mHeight + 2);
 	
 	vector<DEMGeo::address>	all_pixels;
-	all_pixels.reserve(input.mWidth * input.mHeight);
-	for(DEMGeo::address i = input.address_begin(); i != input.address_end(); ++i)
-		all_pixels.push_back(i);
-		
-	sort(all_pixels.begin(), all_pixels.end(), sort_pixel_by_height(input));	
+	sort_pixels_by_height(input, all_pixels);
 
 	DEMGeo::neighbor_iterator<4> n;
 	vector<DEMGeo::address>::iterator hi = all_pixels.begin(), p;
@@ -2299,94 +2376,41 @@ void	FindWatersheds(DEMGeo& ws, vector<DEMGeo::address>& out_sheds)
 	}
 }
 
-static void flood_fill_shed(DEMGeo& ws, DEMGeo::address seed, float old_id, float new_id, int shed_size)
+// MMU merging works on a region adjacency graph: for each shed, the number of pixel edges it shares with each
+// neighboring shed.  Swallowing a small shed into its best neighbor just folds its row of the graph into the
+// neighbor's, which gives the same edge counts a re-flood of the merged shed would find.  The raster is relabeled
+// once at the end.
+void	MergeMMU(DEMGeo& ws, vector<DEMGeo::address>& io_sheds, int min_mmu_size)
 {
-	DebugAssert(old_id != new_id);
-	DebugAssert(ws.valid(seed));
-	address_fifo fifo(shed_size);
-	fifo.push(seed);
-	#if DEV
-		int changed = 0;
-	#endif
-	while(!fifo.empty())
+	int shed_count = io_sheds.size();
+	vector<int>	ws_size_table;
+	ws_size_table.resize(shed_count, 0);
+	DEMGeo::address a;
+	for(a = ws.address_begin(); a != ws.address_end(); ++a)
+		ws_size_table[ws[a]]++;
+
+	vector<map<int, int> >	adjacency(shed_count);
+	for(int y = 0; y < ws.mHeight; ++y)
+	for(int x = 0; x < ws.mWidth; ++x)
 	{
-		DEMGeo::address p = fifo.pop();
-		DebugAssert(ws[p] == old_id || ws[p] == new_id);
-		if(ws[p] == old_id)
+		int me = ws(x,y);
+		if(x+1 < ws.mWidth)
 		{
-			#if DEV
-			++changed;
-			DebugAssert(changed <= shed_size);
-			#endif
-			ws[p] = new_id;
-			for(DEMGeo::neighbor_iterator<4> n = ws.neighbor_begin<4>(p); n != ws.neighbor_end<4>(p); ++n)
-			if(ws[*n] == old_id)
-				fifo.push(*n);
+			int r = ws(x+1,y);
+			if(r != me) { adjacency[me][r]++; adjacency[r][me]++; }
 		}
-	}
-	DebugAssert(shed_size == changed);
-}
-
-static float find_best_neighbor(DEMGeo& ws, DEMGeo::address seed, int old_id, int new_id, int max_size)
-{
-	DebugAssert(old_id != new_id);
-
-	DebugAssert(max_size > 0);
-	DebugAssert(ws.valid(seed));
-	DebugAssert(ws[seed] == old_id);
-	map<float, int>	neighbor_count;
-	address_fifo fifo(max_size);
-	fifo.push(seed);
-	#if DEV	
-	int filled = 0;
-	#endif
-	while(!fifo.empty())
-	{
-		DEMGeo::address p = fifo.pop();
-		DebugAssert(ws[p] == old_id || ws[p] == new_id);
-		if(ws[p] == old_id)
+		if(y+1 < ws.mHeight)
 		{
-			ws[p] = new_id;
-			#if DEV
-			++filled;			
-			DebugAssert(filled <= max_size);
-			#endif
-			for(DEMGeo::neighbor_iterator<4> n = ws.neighbor_begin<4>(p); n != ws.neighbor_end<4>(p); ++n)
-			if(ws[*n] == old_id)
-			{
-				fifo.push(*n);
-			} 
-			else if(ws[*n] != new_id)
-			{
-				float nid = ws[*n];
-				neighbor_count[nid]++;
-			}
+			int u = ws(x,y+1);
+			if(u != me) { adjacency[me][u]++; adjacency[u][me]++; }
 		}
 	}
-	DebugAssert(filled == max_size);
-	if(neighbor_count.empty()) 
-		return -1.0;
-	map<float,int>::iterator n, best;
-	n = best = neighbor_count.begin();
-	++n;
-	while(n != neighbor_count.end())
-	{
-		if(n->second > best->second)
-			best = n;
-		++n;
-	}
-	return best->first;
-}
 
+	// Each dead shed points to the shed that swallowed it.
+	vector<int>	merged_into(shed_count);
+	for(int ws_id = 0; ws_id < shed_count; ++ws_id)
+		merged_into[ws_id] = ws_id;
 
-void	MergeMMU(DEMGeo& ws, vector<DEMGeo::address>& io_sheds, int min_mmu_size)
-{
-	vector<int>	ws_size_table;
-	ws_size_table.resize(io_sheds.size(), 0);
-	DEMGeo::address a;
-	for(a = ws.address_begin(); a != ws.address_end(); ++a)
-		ws_size_table[ws[a]]++;
-	
 	multimap<int, int>	ws_size_q;
 	
 	int ws_id;
@@ -2410,78 +2434,111 @@ void	MergeMMU(DEMGeo& ws, vector<DEMGeo::address>& io_sheds, int min_mmu_size)
 		} 
 		else
 		{
-			int n_id = find_best_neighbor(ws, io_sheds[ws_id], ws_id, -1.0, ws_size_table[ws_id]);
-			DebugAssert(n_id >= 0);
-			int old_shed_size = ws_size_table[ws_id];
-			ws_size_table[n_id] += old_shed_size;
+			// Most shared edges wins; ties go to the lowest shed ID.
+			map<int,int>& mine(adjacency[ws_id]);
+			DebugAssert(!mine.empty());
+			if(mine.empty())
+				continue;
+			map<int,int>::iterator n, best;
+			for(n = best = mine.begin(); n != mine.end(); ++n)
+			if(n->second > best->second)
+				best = n;
+			int n_id = best->first;
+
+			map<int,int>& theirs(adjacency[n_id]);
+			theirs.erase(ws_id);
+			for(n = mine.begin(); n != mine.end(); ++n)
+			if(n->first != n_id)
+			{
+				theirs[n->first] += n->second;
+				map<int,int>& other(adjacency[n->first]);
+				other[n_id] += n->second;
+				other.erase(ws_id);
+			}
+			mine.clear();
+
+			ws_size_table[n_id] += ws_size_table[ws_id];
 			ws_size_table[ws_id] = 0;
-			flood_fill_shed(ws,io_sheds[ws_id],-1.0, n_id, old_shed_size);
+			merged_into[ws_id] = n_id;
 			io_sheds[ws_id] = -1;
 		}			
 	}
 
-}
-
-static void	SetWatershedToDominant(DEMGeo& underlying, DEMGeo& ws, DEMGeo::address seed, address_fifo& fifo)
-{
-	DebugAssert(seed != -1);
-	DebugAssert(fifo.empty());
-	DEMGeo::address p;
-	DEMGeo::neighbor_iterator<4>	n;
-	map<float,int>	histo;
-
-	fifo.push(seed);
-	float my_id = ws[seed];
-	DebugAssert(my_id != -1);
-	
-	while(!fifo.empty())
+	for(ws_id = 0; ws_id < shed_count; ++ws_id)
 	{
-		p = fifo.pop();
-		if(ws[p] == my_id)
+		int root = ws_id;
+		while(merged_into[root] != root)
+			root = merged_into[root];
+		for(int i = ws_id; merged_into[i] != root; )
 		{
-			ws[p] = -1;
-			histo[underlying[p]]++;
-			for(n = ws.neighbor_begin<4>(p); n != ws.neighbor_end<4>(p); ++n)
-			if(ws[*n] == my_id)
-				fifo.push(*n);				
-			
+			int next = merged_into[i];
+			merged_into[i] = root;
+			i = next;
 		}
 	}
-	
-	DebugAssert(!histo.empty());
-	map<float,int>::iterator best, i;
-	best = i = histo.begin();
-	++n;
-	while(i != histo.end())
+
+	dem_parallel_rows(ws.mHeight, [&](int y1, int y2) {
+		for(int y = y1; y < y2; ++y)
+		for(int x = 0; x < ws.mWidth; ++x)
+			ws(x,y) = merged_into[(int) ws(x,y)];
+	});
+}
+
+// Each live shed takes the most common underlying value, ties going to the lowest value.  Sheds are disjoint,
+// so we bucket the pixels by shed once and then run the sheds on all cores.
+void	SetWatershedsToDominant(DEMGeo& underlying, DEMGeo& ws, const vector<DEMGeo::address>& io_sheds)
+{
+	int shed_count = io_sheds.size();
+	vector<int>	start(shed_count + 1, 0);
+	DEMGeo::address a;
+	for(a = ws.address_begin(); a != ws.address_end(); ++a)
 	{
-		if(i->second > best->second)
-			best = i;
-		++i;
+		float id = ws[a];
+		if(id >= 0 && id < shed_count && io_sheds[(int) id] != -1)
+			++start[(int) id + 1];
 	}
-	
-	float best_lu = best->first;
-	
-	fifo.push(seed);
-	while(!fifo.empty())
+	for(int s = 1; s <= shed_count; ++s)
+		start[s] += start[s-1];
+
+	vector<DEMGeo::address>	pixels(start[shed_count]);
 	{
-		p = fifo.pop();
-		if(ws[p] == -1)
+		vector<int>	fill(start.begin(), start.end() - 1);
+		for(a = ws.address_begin(); a != ws.address_end(); ++a)
 		{
-			ws[p] = my_id;
-			underlying[p] = best_lu;
-			for(n = ws.neighbor_begin<4>(p); n != ws.neighbor_end<4>(p); ++n)
-			if(ws[*n] == -1)
-				fifo.push(*n);				
-			
+			float id = ws[a];
+			if(id >= 0 && id < shed_count && io_sheds[(int) id] != -1)
+				pixels[fill[(int) id]++] = a;
 		}
 	}
-	DebugAssert(fifo.empty());
-}
 
-void	SetWatershedsToDominant(DEMGeo& underlying, DEMGeo& ws, const vector<DEMGeo::address>& io_sheds)
-{
-	address_fifo fifo(underlying.mWidth * underlying.mHeight);
-	for(vector<DEMGeo::address>::const_iterator a = io_sheds.begin(); a != io_sheds.end(); ++a)
-	if(*a != -1)
-		SetWatershedToDominant(underlying, ws, *a, fifo);
+	// dem_parallel_rows just hands out index ranges - here they are ranges of sheds.
+	dem_parallel_rows(shed_count, [&](int s1, int s2) {
+		vector<float>	values;
+		for(int s = s1; s < s2; ++s)
+		if(start[s] < start[s+1])
+		{
+			values.clear();
+			for(int i = start[s]; i < start[s+1]; ++i)
+				values.push_back(underlying[pixels[i]]);
+			sort(values.begin(), values.end());
+
+			float	best_lu = values[0];
+			int		best_count = 0;
+			for(int i = 0; i < values.size(); )
+			{
+				int j = i + 1;
+				while(j < values.size() && values[j] == values[i])
+					++j;
+				if(j - i > best_count)
+				{
+					best_count = j - i;
+					best_lu = values[i];
+				}
+				i = j;
+			}
+
+			for(int i = start[s]; i < start[s+1]; ++i)
+				underlying[pixels[i]] = best_lu;
+		}
+	});
 }
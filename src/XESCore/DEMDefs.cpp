@@ -24,6 +24,8 @@
 #include "CompGeomDefs3.h"
 #include "MathUtils.h"
 #include <list>
+#include <atomic>
+#include <thread>
 
 #define HIST_MAX	10
 
@@ -575,6 +577,55 @@ void	DEMGeo::calc_normal(DEMGeo& outX, DEMGeo& outY, DEMGeo& outZ, ProgressFunc
 }
 
 
+int		gDemThreads = 0;
+
+void		dem_parallel_rows(int rows, const function<void(int, int)>& func)
+{
+	int num_threads = gDemThreads > 0 ? gDemThreads : (int) thread::hardware_concurrency();
+	num_threads = min(max(num_threads, 1), rows);
+	if (num_threads <= 1)
+	{
+		if (rows > 0)
+			func(0, rows);
+		return;
+	}
+
+	// A few bands per thread, so one slow band doesn't leave the others idle.
+	int			band = max(1, rows / (num_threads * 4));
+	atomic<int>	next(0);
+	auto worker = [&]()
+	{
+		int y;
+		while ((y = next.fetch_add(band)) < rows)
+			func(y, min(y + band, rows));
+	};
+
+	vector<thread>	threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(thread(worker));
+	worker();
+	for (vector<thread>::iterator t = threads.begin(); t != threads.end(); ++t)
+		t->join();
+}
+
+// Slope and heading from the center point and the chosen horizontal and vertical neighbors.
+static inline void	slope_from_neighbors(const Point3& me, const Point3& ph, const Point3& pv, float& outSlope, float& outHeading)
+{
+	Vector3	v1(me,ph);
+	Vector3	v2(me,pv);
+	Vector3	normal(v1.cross(v2));
+	if (normal.dz < 0.0)
+		normal *= -1.0;
+	normal.normalize();
+//	double	xy = sqrt(normal.dx * normal.dx + normal.dy * normal.dy);
+//	outHeading = atan2(normal.dx, normal.dy) * RAD_TO_DEG;
+	outSlope = 1.0 - normal.dz;
+	normal.dz = 0;
+	normal.normalize();
+	outHeading = normal.dy;
+//	outSlope = atan2(xy, normal.dz) * RAD_TO_DEG;
+}
+
 void	DEMGeo::calc_slope(DEMGeo& outSlope, DEMGeo& outHeading, ProgressFunc inProg) const
 {
 	outSlope.resize(mWidth, mHeight);
@@ -584,78 +635,83 @@ void	DEMGeo::calc_slope(DEMGeo& outSlope, DEMGeo& outHeading, ProgressFunc inPro
 
 	double	x_res = x_dist_to_m(1);
 	double	y_res = y_dist_to_m(1);
-	float	h, hl, ht, hb, hr;
-	float	ld, rd, bd, td;
 
 	if (inProg) inProg(0, 1, "Calculating Slope", 0.0);
-	for (int x = 0; x < mWidth; ++x)
-	for (int y = 0; y < mHeight;++y)
-	{
-		if (y == 0 && (x % 50) == 0)
-			if (inProg) inProg(0, 1, "Calculating Slope", (double) x / (double) mWidth);
 
-		h = get(x,y);
-		if (h == DEM_NO_DATA)
+	dem_parallel_rows(mHeight, [&](int y1, int y2) {
+		float	h, hl, ht, hb, hr;
+		float	ld, rd, bd, td;
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < mWidth; ++x)
 		{
-			outSlope(x,y) = DEM_NO_DATA;
-			outHeading(x,y) = DEM_NO_DATA;
-		} else {
-			Point3 me(0,0,h);
-			hl = get_dir(x,y,-1,0,        x,DEM_NO_DATA,ld);	Point3 pl(-ld*x_res,0,hl);
-			hr = get_dir(x,y, 1,0, mWidth-x,DEM_NO_DATA,rd);	Point3 pr( rd*x_res,0,hr);
-			hb = get_dir(x,y,0,-1,        y,DEM_NO_DATA,bd);	Point3 pb(0,-bd*y_res,hb);
-			ht = get_dir(x,y,0, 1,mHeight-y,DEM_NO_DATA,td);	Point3 pt(0, td*y_res,ht);
-
-			Point3 * ph = NULL, * pv = NULL;
-
-			if (hl != DEM_NO_DATA)
-			{
-				if (hr != DEM_NO_DATA)
-					ph = (ld < rd) ? &pl : &pr;
-				else
-					ph = &pl;
-			} else {
-				if (hr != DEM_NO_DATA)
-					ph = &pr;
-				else
-					fprintf(stderr, "NO H ELEVATION\n");
-			}
+			h = mData[x + y * mWidth];
 
-			if (hb != DEM_NO_DATA)
+			// Interior fast path: with all four direct neighbors present, the search below always picks the right
+			// and top ones at distance 1.  The borders and holes take the general path.
+			if (x > 0 && x < mWidth - 1 && y > 0 && y < mHeight - 1 && h != DEM_NO_DATA)
 			{
-				if (ht != DEM_NO_DATA)
-					pv = (bd < td) ? &pb : &pt;
-				else
-					pv = &pb;
-			} else {
-				if (ht != DEM_NO_DATA)
-					pv = &pt;
-				else
-					fprintf(stderr, "NO V ELEVATION\n");
+				const float * p = mData + x + y * mWidth;
+				hl = p[-1];
+				hr = p[ 1];
+				hb = p[-mWidth];
+				ht = p[ mWidth];
+				if (hl != DEM_NO_DATA && hr != DEM_NO_DATA && hb != DEM_NO_DATA && ht != DEM_NO_DATA)
+				{
+					rd = td = 1;
+					slope_from_neighbors(Point3(0,0,h), Point3(rd*x_res,0,hr), Point3(0,td*y_res,ht), outSlope(x,y), outHeading(x,y));
+					continue;
+				}
 			}
 
-			if (!ph || !pv)
+			if (h == DEM_NO_DATA)
 			{
 				outSlope(x,y) = DEM_NO_DATA;
 				outHeading(x,y) = DEM_NO_DATA;
-				continue;
-			}
-			Vector3	v1(me,*ph);
-			Vector3	v2(me,*pv);
-			Vector3	normal(v1.cross(v2));
-			if (normal.dz < 0.0)
-				normal *= -1.0;
-			normal.normalize();
-//			double	xy = sqrt(normal.dx * normal.dx + normal.dy * normal.dy);
-//			outHeading(x,y) = atan2(normal.dx, normal.dy) * RAD_TO_DEG;
-			outSlope(x,y) = 1.0 - normal.dz;
-			normal.dz = 0;
-			normal.normalize();
-			outHeading(x,y) = normal.dy;
-//			outSlope(x,y) = atan2(xy, normal.dz) * RAD_TO_DEG;
+			} else {
+				Point3 me(0,0,h);
+				hl = get_dir(x,y,-1,0,        x,DEM_NO_DATA,ld);	Point3 pl(-ld*x_res,0,hl);
+				hr = get_dir(x,y, 1,0, mWidth-x,DEM_NO_DATA,rd);	Point3 pr( rd*x_res,0,hr);
+				hb = get_dir(x,y,0,-1,        y,DEM_NO_DATA,bd);	Point3 pb(0,-bd*y_res,hb);
+				ht = get_dir(x,y,0, 1,mHeight-y,DEM_NO_DATA,td);	Point3 pt(0, td*y_res,ht);
+
+				Point3 * ph = NULL, * pv = NULL;
+
+				if (hl != DEM_NO_DATA)
+				{
+					if (hr != DEM_NO_DATA)
+						ph = (ld < rd) ? &pl : &pr;
+					else
+						ph = &pl;
+				} else {
+					if (hr != DEM_NO_DATA)
+						ph = &pr;
+					else
+						fprintf(stderr, "NO H ELEVATION\n");
+				}
 
+				if (hb != DEM_NO_DATA)
+				{
+					if (ht != DEM_NO_DATA)
+						pv = (bd < td) ? &pb : &pt;
+					else
+						pv = &pb;
+				} else {
+					if (ht != DEM_NO_DATA)
+						pv = &pt;
+					else
+						fprintf(stderr, "NO V ELEVATION\n");
+				}
+
+				if (!ph || !pv)
+				{
+					outSlope(x,y) = DEM_NO_DATA;
+					outHeading(x,y) = DEM_NO_DATA;
+					continue;
+				}
+				slope_from_neighbors(me, *ph, *pv, outSlope(x,y), outHeading(x,y));
+			}
 		}
-	}
+	});
 	if (inProg) inProg(0, 1, "Calculating Slope", 1.0);
 }
 
@@ -878,21 +934,21 @@ float	DEMGeo::local_minmax(int x1, int y1, int x2, int y2,
 void	DEMGeo::filter_self(int dim, float * k)
 {
 	DEMGeo	temp(*this);
-	for (int x = 0; x < temp.mWidth; ++x)
-	for (int y = 0; y < temp.mHeight;++y)
-	{
-		(*this)(x,y) = temp.kernelN(x,y,dim,k);
-	}
+	dem_parallel_rows(temp.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < temp.mWidth; ++x)
+			(*this)(x,y) = temp.kernelN(x,y,dim,k);
+	});
 }
 
 void	DEMGeo::filter_self_normalize(int dim, float * k)
 {
 	DEMGeo	temp(*this);
-	for (int x = 0; x < temp.mWidth; ++x)
-	for (int y = 0; y < temp.mHeight;++y)
-	{
-		(*this)(x,y) = temp.kernelN_Normalize(x,y,dim,k);
-	}
+	dem_parallel_rows(temp.mHeight, [&](int y1, int y2) {
+		for (int y = y1; y < y2; ++y)
+		for (int x = 0; x < temp.mWidth; ++x)
+			(*this)(x,y) = temp.kernelN_Normalize(x,y,dim,k);
+	});
 }
 
 
@@ -963,25 +1019,27 @@ void	DEMGeo_ReduceMinMaxN(
 	outMin.resize((inDEM.mWidth-inDEM.mPost) / N + inDEM.mPost, (inDEM.mHeight-1) / N + inDEM.mPost);
 	outMax.resize((inDEM.mWidth-inDEM.mPost) / N + inDEM.mPost, (inDEM.mHeight-1) / N + inDEM.mPost);
 
-	int x, y, dx, dy;
-	float e1, e2, e3;
+	dem_parallel_rows(outMin.mHeight, [&](int y1, int y2) {
+		int x, y, dx, dy;
+		float e1, e2, e3;
 
-	for (y = 0; y < outMin.mHeight; y++)
-	for (x = 0; x < outMin.mWidth; x++)
-	{
-		int rx = x * N;
-		int ry = y * N;
-		e1 = e2 = DEM_NO_DATA;
-		for (dy = 0; dy < N; ++dy)
-		for (dx = 0; dx < N; ++dx)
+		for (y = y1; y < y2; y++)
+		for (x = 0; x < outMin.mWidth; x++)
 		{
-			e3 = inDEM.get(rx + dx, ry + dy);
-			e1 = MIN_NODATA(e1, e3);
-			e2 = MAX_NODATA(e2, e3);
+			int rx = x * N;
+			int ry = y * N;
+			e1 = e2 = DEM_NO_DATA;
+			for (dy = 0; dy < N; ++dy)
+			for (dx = 0; dx < N; ++dx)
+			{
+				e3 = inDEM.get(rx + dx, ry + dy);
+				e1 = MIN_NODATA(e1, e3);
+				e2 = MAX_NODATA(e2, e3);
+			}
+			outMin(x,y) = e1;
+			outMax(x,y) = e2;
 		}
-		outMin(x,y) = e1;
-		outMax(x,y) = e2;
-	}
+	});
 }
 
 
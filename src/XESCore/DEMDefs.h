@@ -25,6 +25,7 @@
 
 #include <math.h>
 #include <algorithm>
+#include <functional>
 
 #include "XESConstants.h"
 #include "ProgressUtils.h"
@@ -380,6 +381,12 @@ void		dem_coverage_nearest(const DEMGeo& d, double lon1, double lat1, double lon
 void		dem_copy_buffer_one(const DEMGeo& orig_src, DEMGeo& io_dst, float null_value);
 void		dem_erode(DEMGeo& io_dem, int steps, float null_value);
 
+// Runs a raster pass as bands of rows: func(y1, y2) is called for bands that together cover [0, rows), from up
+// to gDemThreads threads (0 means one per core).  A pass that writes only its own rows and reads only rasters
+// nobody is writing produces exactly what the serial loop would.
+extern int	gDemThreads;
+void		dem_parallel_rows(int rows, const function<void(int, int)>& func);
+
 // Given two DEMs that represent the minimum and maximum possible values for various
 // points, this routine produces two DEMs of half dimension.  Each point has the min
 // or max of the four points in the original DEMs that correspond spatially.
@@ -651,6 +658,28 @@ inline float	DEMGeo::kernelN(int x, int y, int dim, float * kernel) const
 	sum = DEM_NO_DATA;
 	int i = 0;
 	int hdim = dim / 2;
+	if (x >= hdim && x < mWidth - hdim && y >= hdim && y < mHeight - hdim)
+	{
+		// Interior - no clamping needed, same samples in the same order.
+		for (int dx = -hdim; dx <= hdim; ++dx)
+		{
+			const float * col = mData + (x + dx) + (y - hdim) * mWidth;
+			for (int dy = -hdim; dy <= hdim; ++dy, col += mWidth)
+			{
+				e = *col;
+				if (e != DEM_NO_DATA)
+				{
+					e *= kernel[i];
+					if (sum == DEM_NO_DATA)
+						sum = e;
+					else
+						sum += e;
+				}
+				++i;
+			}
+		}
+		return sum;
+	}
 	for (int dx = -hdim; dx <= hdim; ++dx)
 	for (int dy = -hdim; dy <= hdim; ++dy)
 	{
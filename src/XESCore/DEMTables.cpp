@@ -25,7 +25,10 @@
 #include "EnumSystem.h"
 #include "DEMDefs.h"
 #include "Zoning.h"
+#include "AssertUtils.h"
 #include <ctype.h>
+#include <atomic>
+#include <mutex>
 //#include "CoverageFinder.h"
 
 // Sergio's rule spreadsheets from v8/v9 used an older syntax.  Andras has since normalized the syntax 
@@ -57,6 +60,8 @@ TexProjTable					gTexProj;
 
 static set<int>			sAirports;
 
+bool					gNaturalTerrainSelfCheck = false;
+
 string	gNaturalTerrainFile;
 string	gLanduseTransFile;
 string	gReplacementClimate;
@@ -897,6 +902,7 @@ bool	ReadManTerrainInfo(const vector<string>& tokens, void * ref)
 
 void	LoadDEMTables(void)
 {
+	InvalidateNaturalTerrainIndex();
 	gEnumColors.clear();
 	gColorBands.clear();
 	gEnumDEMs.clear();
@@ -953,7 +959,7 @@ void	LoadDEMTables(void)
 
 #pragma mark -
 
-int	FindNaturalTerrain(
+static int	FindNaturalTerrainLinear(
 				int		terrain,
 				int		zoning,
 				int 	landuse,
@@ -979,23 +985,6 @@ int	FindNaturalTerrain(
 //				int		variant_blob,
 //				int		variant_head)
 {
-	// Check for no data in the continuous floating point inputs!
-//	DebugAssert(DEM_NO_DATA !=  	elevation);
-	DebugAssert(DEM_NO_DATA !=  	slope);
-	DebugAssert(DEM_NO_DATA !=  	slope_tri);
-	DebugAssert(DEM_NO_DATA != 	temp);
-	DebugAssert(DEM_NO_DATA != 	temp_rng);
-	DebugAssert(DEM_NO_DATA != 	rain);
-	DebugAssert(DEM_NO_DATA != 	slopeheading);
-	DebugAssert(DEM_NO_DATA != 	relelevation);
-	DebugAssert(DEM_NO_DATA != 	elevrange);
-	DebugAssert(DEM_NO_DATA != 	urban_density);
-	DebugAssert(DEM_NO_DATA != 	urban_radial);
-	DebugAssert(DEM_NO_DATA != 	urban_trans);
-	DebugAssert(DEM_NO_DATA != 	lat);
-
-	// OPTIMIZE - figure out what the major keys should be.
-
 	for (int rec_num = 0; rec_num < gNaturalTerrainRules.size(); ++rec_num)
 	{
 		NaturalTerrainRule_t& rec = gNaturalTerrainRules[rec_num];
@@ -1034,6 +1023,320 @@ int	FindNaturalTerrain(
 	return -1;
 }
 
+/************************************************************************
+ * NATURAL TERRAIN RULE INDEX
+ ************************************************************************
+ * The rules are matched first-hit in table order.  Instead of walking the table per triangle, each input is
+ * cut into a few "rows" so that every rule matches either all or none of the values in a row: enums by value
+ * (everything not named by a rule shares row 0, which only the wild-cards match) and ranges by the elementary
+ * intervals between the rule bounds - each bound is its own row, as are the open gaps between bounds.
+ * Each row is a bit-set over the rules, so the first match is the lowest bit in the AND of one row from every
+ * column, which is exactly the rule the linear scan would return.  The row tuple is also an exact key for
+ * memoizing the answer, so repeated inputs cost only the row lookups.
+ */
+
+typedef	unsigned long long		nt_word;
+
+enum {
+	// Most selective columns first, so the AND goes to zero early.
+	ntc_terrain, ntc_landuse, ntc_zoning, ntc_soil_style, ntc_agri_style, ntc_clim_style,
+	ntc_urban_square, ntc_water,
+	ntc_temp, ntc_slope, ntc_rain, ntc_temp_rng, ntc_slope_heading, ntc_rel_elev, ntc_elev_range,
+	ntc_urban_density, ntc_urban_trans, ntc_lat, ntc_urban_radial,
+	ntc_count
+};
+
+struct	nt_column {
+	vector<float>		breaks;		// range columns: sorted distinct rule bounds
+	hash_map<int, int>	values;		// enum columns: value -> row, unlisted values use row 0
+	vector<nt_word>		bits;		// rows x words, one bit per rule
+};
+
+struct	nt_index {
+	nt_index() : rule_count(-1), words(0) { }
+	atomic<int>			rule_count;	// number of rules indexed, -1 if stale
+	int					words;
+	nt_column			cols[ntc_count];
+};
+
+struct	nt_key {
+	int					rows[ntc_count];
+	bool operator==(const nt_key& rhs) const { return memcmp(rows, rhs.rows, sizeof(rows)) == 0; }
+};
+
+struct	nt_key_hash {
+	size_t operator()(const nt_key& k) const {
+		size_t h = 2166136261u;
+		for(int c = 0; c < ntc_count; ++c)
+			h = (h ^ k.rows[c]) * 16777619u;
+		return h;
+	}
+};
+
+struct	nt_memo {
+	nt_memo() : generation(-1) { }
+	int									generation;
+	hash_map<nt_key, int, nt_key_hash>	results;
+};
+
+static nt_index			sNTIndex;
+static mutex			sNTIndexLock;
+static atomic<int>		sNTGeneration(0);
+
+#define	NT_MEMO_MAX	(1 << 20)
+
+static inline void nt_set(nt_column& c, int row, int words, int rule)
+{
+	c.bits[row * words + rule / 64] |= ((nt_word) 1) << (rule % 64);
+}
+
+static void nt_build_enum(nt_column& c, int NaturalTerrainRule_t::* field, int wild, bool all_row, int words)
+{
+	const NaturalTerrainRuleVector& rules(gNaturalTerrainRules);
+	c.breaks.clear();
+	c.values.clear();
+	for(int r = 0; r < rules.size(); ++r)
+	if(rules[r].*field != wild && c.values.count(rules[r].*field) == 0)
+	{
+		int row = c.values.size() + 1;
+		c.values[rules[r].*field] = row;
+	}
+
+	int rows = c.values.size() + 1 + (all_row ? 1 : 0);		// the optional last row matches every rule
+	c.bits.assign(rows * words, 0);
+	for(int r = 0; r < rules.size(); ++r)
+	{
+		int v = rules[r].*field;
+		if(v == wild)
+		{
+			for(int row = 0; row < rows; ++row)
+				nt_set(c, row, words, r);
+		}
+		else
+		{
+			nt_set(c, c.values[v], words, r);
+			if(all_row)
+				nt_set(c, rows - 1, words, r);
+		}
+	}
+}
+
+static void nt_build_range(nt_column& c, float NaturalTerrainRule_t::* vmin, float NaturalTerrainRule_t::* vmax, int words)
+{
+	const NaturalTerrainRuleVector& rules(gNaturalTerrainRules);
+	c.breaks.clear();
+	c.values.clear();
+	for(int r = 0; r < rules.size(); ++r)
+	if(rules[r].*vmin != rules[r].*vmax)
+	{
+		// A NaN bound never matches anything, so it does not need a row.
+		if(rules[r].*vmin == rules[r].*vmin)	c.breaks.push_back(rules[r].*vmin);
+		if(rules[r].*vmax == rules[r].*vmax)	c.breaks.push_back(rules[r].*vmax);
+	}
+	sort(c.breaks.begin(), c.breaks.end());
+	c.breaks.erase(unique(c.breaks.begin(), c.breaks.end()), c.breaks.end());
+
+	// Row 2n+1 is the value breaks[n]; row 2n is the open gap below it and the last row is above all bounds.
+	int k = c.breaks.size();
+	int rows = 2 * k + 1;
+	c.bits.assign(rows * words, 0);
+	for(int r = 0; r < rules.size(); ++r)
+	{
+		float lo = rules[r].*vmin, hi = rules[r].*vmax;
+		for(int row = 0; row < rows; ++row)
+		{
+			bool match;
+			if(lo == hi)
+				match = true;
+			else if(row % 2)
+				match = lo <= c.breaks[row / 2] && c.breaks[row / 2] <= hi;
+			else if(row == 0 || row == rows - 1)
+				match = false;
+			else
+				match = lo <= c.breaks[row / 2 - 1] && c.breaks[row / 2] <= hi;
+			if(match)
+				nt_set(c, row, words, r);
+		}
+	}
+}
+
+static inline int nt_enum_row(const nt_column& c, int v)
+{
+	hash_map<int, int>::const_iterator i = c.values.find(v);
+	return i == c.values.end() ? 0 : i->second;
+}
+
+static inline int nt_range_row(const nt_column& c, float x)
+{
+	// A NaN lands in row 0, which only the wild-cards match - as in the linear scan.
+	vector<float>::const_iterator i = lower_bound(c.breaks.begin(), c.breaks.end(), x);
+	int n = i - c.breaks.begin();
+	return (i != c.breaks.end() && *i == x) ? 2 * n + 1 : 2 * n;
+}
+
+static void	nt_build_index(void)
+{
+	nt_index& idx(sNTIndex);
+	int words = (gNaturalTerrainRules.size() + 63) / 64;
+	idx.words = words;
+
+	nt_build_enum(idx.cols[ntc_terrain],		&NaturalTerrainRule_t::terrain,		NO_VALUE, false, words);
+	nt_build_enum(idx.cols[ntc_landuse],		&NaturalTerrainRule_t::landuse,		NO_VALUE, false, words);
+	nt_build_enum(idx.cols[ntc_zoning],			&NaturalTerrainRule_t::zoning,		NO_VALUE, false, words);
+	nt_build_enum(idx.cols[ntc_soil_style],		&NaturalTerrainRule_t::soil_style,	NO_VALUE, false, words);
+	nt_build_enum(idx.cols[ntc_agri_style],		&NaturalTerrainRule_t::agri_style,	NO_VALUE, false, words);
+	nt_build_enum(idx.cols[ntc_clim_style],		&NaturalTerrainRule_t::clim_style,	NO_VALUE, false, words);
+	nt_build_enum(idx.cols[ntc_urban_square],	&NaturalTerrainRule_t::urban_square,0,		  true,  words);
+
+	// Near-water rules only match wet triangles: row 0 is dry, row 1 is wet.
+	nt_column& w(idx.cols[ntc_water]);
+	w.breaks.clear();
+	w.values.clear();
+	w.bits.assign(2 * words, 0);
+	for(int r = 0; r < gNaturalTerrainRules.size(); ++r)
+	{
+		if(!gNaturalTerrainRules[r].near_water)
+			nt_set(w, 0, words, r);
+		nt_set(w, 1, words, r);
+	}
+
+	nt_build_range(idx.cols[ntc_temp],			&NaturalTerrainRule_t::temp_min,			&NaturalTerrainRule_t::temp_max,			words);
+	nt_build_range(idx.cols[ntc_slope],			&NaturalTerrainRule_t::slope_min,			&NaturalTerrainRule_t::slope_max,			words);
+	nt_build_range(idx.cols[ntc_rain],			&NaturalTerrainRule_t::rain_min,			&NaturalTerrainRule_t::rain_max,			words);
+	nt_build_range(idx.cols[ntc_temp_rng],		&NaturalTerrainRule_t::temp_rng_min,		&NaturalTerrainRule_t::temp_rng_max,		words);
+	nt_build_range(idx.cols[ntc_slope_heading],	&NaturalTerrainRule_t::slope_heading_min,	&NaturalTerrainRule_t::slope_heading_max,	words);
+	nt_build_range(idx.cols[ntc_rel_elev],		&NaturalTerrainRule_t::rel_elev_min,		&NaturalTerrainRule_t::rel_elev_max,		words);
+	nt_build_range(idx.cols[ntc_elev_range],	&NaturalTerrainRule_t::elev_range_min,		&NaturalTerrainRule_t::elev_range_max,		words);
+	nt_build_range(idx.cols[ntc_urban_density],	&NaturalTerrainRule_t::urban_density_min,	&NaturalTerrainRule_t::urban_density_max,	words);
+	nt_build_range(idx.cols[ntc_urban_trans],	&NaturalTerrainRule_t::urban_trans_min,		&NaturalTerrainRule_t::urban_trans_max,		words);
+	nt_build_range(idx.cols[ntc_lat],			&NaturalTerrainRule_t::lat_min,				&NaturalTerrainRule_t::lat_max,				words);
+	nt_build_range(idx.cols[ntc_urban_radial],	&NaturalTerrainRule_t::urban_radial_min,	&NaturalTerrainRule_t::urban_radial_max,	words);
+
+	++sNTGeneration;
+	idx.rule_count.store(gNaturalTerrainRules.size(), memory_order_release);
+}
+
+void	InvalidateNaturalTerrainIndex(void)
+{
+	lock_guard<mutex> lock(sNTIndexLock);
+	sNTIndex.rule_count.store(-1, memory_order_release);
+}
+
+int	FindNaturalTerrain(
+				int		terrain,
+				int		zoning,
+				int 	landuse,
+				int		soil_style,
+				int		agri_style,
+				int		clim_style,
+//				int 	climate,
+//				float 	elevation,
+				float 	slope,
+				float 	slope_tri,
+				float	temp,
+				float	temp_rng,
+				float	rain,
+				int		water,
+				float	slopeheading,
+				float	relelevation,
+				float	elevrange,
+				float	urban_density,
+				float	urban_radial,
+				float	urban_trans,
+				int		urban_square,
+				float	lat)
+//				int		variant_blob,
+//				int		variant_head)
+{
+	// Check for no data in the continuous floating point inputs!
+//	DebugAssert(DEM_NO_DATA !=  	elevation);
+	DebugAssert(DEM_NO_DATA !=  	slope);
+	DebugAssert(DEM_NO_DATA !=  	slope_tri);
+	DebugAssert(DEM_NO_DATA != 	temp);
+	DebugAssert(DEM_NO_DATA != 	temp_rng);
+	DebugAssert(DEM_NO_DATA != 	rain);
+	DebugAssert(DEM_NO_DATA != 	slopeheading);
+	DebugAssert(DEM_NO_DATA != 	relelevation);
+	DebugAssert(DEM_NO_DATA != 	elevrange);
+	DebugAssert(DEM_NO_DATA != 	urban_density);
+	DebugAssert(DEM_NO_DATA != 	urban_radial);
+	DebugAssert(DEM_NO_DATA != 	urban_trans);
+	DebugAssert(DEM_NO_DATA != 	lat);
+
+	// Rules get appended after loading (direct rules, MeshTool custom terrain), so a size change means re-index.
+	if(sNTIndex.rule_count.load(memory_order_acquire) != gNaturalTerrainRules.size())
+	{
+		lock_guard<mutex> lock(sNTIndexLock);
+		if(sNTIndex.rule_count.load(memory_order_acquire) != gNaturalTerrainRules.size())
+			nt_build_index();
+	}
+
+	const nt_index& idx(sNTIndex);
+	nt_key key;
+	key.rows[ntc_terrain]		= nt_enum_row(idx.cols[ntc_terrain],	terrain);
+	key.rows[ntc_landuse]		= nt_enum_row(idx.cols[ntc_landuse],	landuse);
+	key.rows[ntc_zoning]		= nt_enum_row(idx.cols[ntc_zoning],		zoning);
+	key.rows[ntc_soil_style]	= nt_enum_row(idx.cols[ntc_soil_style],	soil_style);
+	key.rows[ntc_agri_style]	= nt_enum_row(idx.cols[ntc_agri_style],	agri_style);
+	key.rows[ntc_clim_style]	= nt_enum_row(idx.cols[ntc_clim_style],	clim_style);
+	key.rows[ntc_urban_square]	= (urban_square == DEM_NO_DATA) ? idx.cols[ntc_urban_square].values.size() + 1 : nt_enum_row(idx.cols[ntc_urban_square], urban_square);
+	key.rows[ntc_water]			= water ? 1 : 0;
+	key.rows[ntc_temp]			= nt_range_row(idx.cols[ntc_temp],			temp);
+	key.rows[ntc_slope]			= nt_range_row(idx.cols[ntc_slope],			slope_tri);
+	key.rows[ntc_rain]			= nt_range_row(idx.cols[ntc_rain],			rain);
+	key.rows[ntc_temp_rng]		= nt_range_row(idx.cols[ntc_temp_rng],		temp_rng);
+	key.rows[ntc_slope_heading]	= nt_range_row(idx.cols[ntc_slope_heading],	slopeheading);
+	key.rows[ntc_rel_elev]		= nt_range_row(idx.cols[ntc_rel_elev],		relelevation);
+	key.rows[ntc_elev_range]	= nt_range_row(idx.cols[ntc_elev_range],	elevrange);
+	key.rows[ntc_urban_density]	= nt_range_row(idx.cols[ntc_urban_density],	urban_density);
+	key.rows[ntc_urban_trans]	= nt_range_row(idx.cols[ntc_urban_trans],	urban_trans);
+	key.rows[ntc_lat]			= nt_range_row(idx.cols[ntc_lat],			lat);
+	key.rows[ntc_urban_radial]	= nt_range_row(idx.cols[ntc_urban_radial],	urban_radial);
+
+	// Memo is per thread so concurrent callers never share a hash table.
+	static thread_local nt_memo memo;
+	int gen = sNTGeneration.load();
+	if(memo.generation != gen || memo.results.size() > NT_MEMO_MAX)
+	{
+		memo.results.clear();
+		memo.generation = gen;
+	}
+
+	int found = -1;
+	hash_map<nt_key, int, nt_key_hash>::iterator m = memo.results.find(key);
+	if(m != memo.results.end())
+		found = m->second;
+	else
+	{
+		for(int w = 0; w < idx.words && found == -1; ++w)
+		{
+			nt_word acc = ~((nt_word) 0);
+			for(int c = 0; c < ntc_count && acc; ++c)
+				acc &= idx.cols[c].bits[key.rows[c] * idx.words + w];
+			if(acc)
+			{
+				int b = 0;
+				while(!(acc & 1)) { acc >>= 1; ++b; }
+				found = gNaturalTerrainRules[w * 64 + b].name;
+			}
+		}
+		memo.results[key] = found;
+	}
+
+	if(gNaturalTerrainSelfCheck)
+	{
+		int linear = FindNaturalTerrainLinear(terrain, zoning, landuse, soil_style, agri_style, clim_style, slope, slope_tri,
+									temp, temp_rng, rain, water, slopeheading, relelevation, elevrange,
+									urban_density, urban_radial, urban_trans, urban_square, lat);
+		if(linear != found)
+			AssertPrintf("Terrain rule index mismatch: index found %s, scan found %s.\n",
+				found  == -1 ? "none" : FetchTokenString(found),
+				linear == -1 ? "none" : FetchTokenString(linear));
+	}
+
+	return found;
+}
+
 #pragma mark -
 
 struct float_between_iterator {
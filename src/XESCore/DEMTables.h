@@ -212,6 +212,14 @@ int		FindNaturalTerrain(
 //				int		variant_blob,
 //				int		variant_head);	// use 0
 
+// FindNaturalTerrain matches against an index of gNaturalTerrainRules that is built on first use and rebuilt
+// whenever rules are added.  Call this after changing existing rules in place.
+void	InvalidateNaturalTerrainIndex(void);
+
+// When set, every FindNaturalTerrain lookup is repeated with a linear walk of the rules and any disagreement
+// with the index is reported.  Slow - for validating rule tables and the index itself.
+extern	bool	gNaturalTerrainSelfCheck;
+
 // This routine creates a rule whereby if the "terrain" input type matches a real .ter file, we simply use it, period.
 // This allows MeshTool to allow authors to direct-select final x-plane terrain types.  This is an optional init so we 
 // don't have 500 extra rules in the table when making global scenery.
@@ -927,6 +927,75 @@ static int IsAliased(int lu)
 	return 0;
 }
 
+// Builds the curve for one road chain, junction to junction, as bezier points.  This only reads the chain and
+// its rep info, so chains can be done on all cores ahead of the (serial) DSF write.
+static void build_chain_curve(Net_ChainInfo_t * chain, const NetRepInfo * info, list<Point2c>& pts, int& orig_count, int& reduced_count)
+{
+
+	pts.push_back(Point2c(chain->start_junction->location,false));
+
+	for(int n = 0; n < chain->shape.size(); ++n)
+	{
+		if(chain->shape.size() == 1)
+		{
+			generate_bezier(chain->start_junction->location,
+							chain->shape[0  ],
+							chain->end_junction->location,
+							info->min_defl_deg_mtr, info->crease_angle_cos,
+							pts);
+		}
+		else if(n == 0)
+		{
+			generate_bezier(chain->start_junction->location,
+							chain->shape[n  ],
+							chain->shape[n+1],
+							info->min_defl_deg_mtr, info->crease_angle_cos,
+							pts);
+		}
+		else if (n == chain->shape.size()-1)
+		{
+			generate_bezier(chain->shape[n-1],
+							chain->shape[n  ],
+							chain->end_junction->location,
+							info->min_defl_deg_mtr, info->crease_angle_cos,
+							pts);
+		}
+		else
+		{
+			generate_bezier(chain->shape[n-1],
+							chain->shape[n  ],
+							chain->shape[n+1],
+							info->min_defl_deg_mtr, info->crease_angle_cos,
+							pts);
+		}
+	}
+
+	pts.push_back(Point2c(chain->end_junction->location,false));
+	DebugAssert(pts.size() >= 2);
+
+	list<Point2c>::iterator last(pts.end()), start(pts.begin());
+	--last;
+	DebugAssert(last->c == 0);
+	#if CAN_OPTIMIZE_BEZIERS
+	if(info->max_err > 0.0)
+	#if ONLY_OPTIMIZE_RAMPS
+	if(info->use_mode == use_Ramp && pts.size() > 20)
+	#endif
+	{
+		#if SHOW_BEZIERS
+			visualize_bezier(pts,true,0.1f, 0.0f);
+		#endif
+		orig_count += pts.size();
+		bezier_multi_simplify_straight_ok(pts, MTR_TO_DEG_LAT * info->max_err, 0.00005);// * MTR_TO_DEG_LAT * 5.0 * 5.0);
+		reduced_count += pts.size();
+		#if SHOW_BEZIERS
+			visualize_bezier(pts,false,1.0f,1.0f);
+		#endif
+	}
+	#endif
+	DebugAssert(pts.size() >= 2);
+}
+
 void	BuildDSF(
 			const char *	inFileName1,
 			const char *	inFileName2,
@@ -1865,7 +1934,32 @@ set<int>					sLoResLU[PATCH_DIM_LO * PATCH_DIM_LO];
 			for (ji = junctions.begin(); ji != junctions.end(); ++ji)
 				(*ji)->index = cur_id++;
 
+			// Curve fitting is the expensive part and is independent per chain - do all of it up front, then
+			// write the chains out in order.
+			// (Rep info is looked up here, on one thread, since the table may grow on lookup.)
+			vector<Net_ChainInfo_t *>	chain_list(chains.begin(), chains.end());
+			vector<const NetRepInfo *>	chain_info;
+			vector<list<Point2c> >		chain_pts(chain_list.size());
+			vector<int>					chain_orig(chain_list.size(), 0), chain_reduced(chain_list.size(), 0);
 			for (ci = chains.begin(); ci != chains.end(); ++ci)
+				chain_info.push_back(&gNetReps[(*ci)->rep_type]);
+			auto curve_chains = [&](int c1, int c2) {
+				for (int c = c1; c < c2; ++c)
+					build_chain_curve(chain_list[c], chain_info[c], chain_pts[c], chain_orig[c], chain_reduced[c]);
+			};
+			#if SHOW_BEZIERS
+				curve_chains(0, chain_list.size());
+			#else
+				dem_parallel_rows(chain_list.size(), curve_chains);
+			#endif
+			for (int c = 0; c < chain_list.size(); ++c)
+			{
+				orig_shape_count += chain_orig[c];
+				reduced_shape_count += chain_reduced[c];
+			}
+
+			int chain_idx = 0;
+			for (ci = chains.begin(); ci != chains.end(); ++ci, ++chain_idx)
 			{
 				coords4[0] = (*ci)->start_junction->location.x();
 				coords4[1] = (*ci)->start_junction->location.y();
@@ -1892,71 +1986,7 @@ set<int>					sLoResLU[PATCH_DIM_LO * PATCH_DIM_LO];
 				//debug_mesh_point(Point2(coords3[0],coords3[1]),1,0,0);
 
 
-				NetRepInfo * info = &gNetReps[(*ci)->rep_type];
-
-				list<Point2c>	pts;
-
-				pts.push_back(Point2c((*ci)->start_junction->location,false));
-
-				for(int n = 0; n < (*ci)->shape.size(); ++n)
-				{
-					if((*ci)->shape.size() == 1)
-					{
-						generate_bezier((*ci)->start_junction->location,
-										(*ci)->shape[0  ],
-										(*ci)->end_junction->location,
-										info->min_defl_deg_mtr, info->crease_angle_cos,
-										pts);
-					}
-					else if(n == 0)
-					{
-						generate_bezier((*ci)->start_junction->location,
-										(*ci)->shape[n  ],
-										(*ci)->shape[n+1],
-										info->min_defl_deg_mtr, info->crease_angle_cos,
-										pts);
-					}
-					else if (n == (*ci)->shape.size()-1)
-					{
-						generate_bezier((*ci)->shape[n-1],
-										(*ci)->shape[n  ],
-										(*ci)->end_junction->location,
-										info->min_defl_deg_mtr, info->crease_angle_cos,
-										pts);
-					}
-					else
-					{
-						generate_bezier((*ci)->shape[n-1],
-										(*ci)->shape[n  ],
-										(*ci)->shape[n+1],
-										info->min_defl_deg_mtr, info->crease_angle_cos,
-										pts);
-					}
-				}
-
-				pts.push_back(Point2c((*ci)->end_junction->location,false));
-				DebugAssert(pts.size() >= 2);
-
-				list<Point2c>::iterator last(pts.end()), start(pts.begin());
-				--last;
-				DebugAssert(last->c == 0);
-				#if CAN_OPTIMIZE_BEZIERS
-				if(gNetReps[(*ci)->rep_type].max_err > 0.0)
-				#if ONLY_OPTIMIZE_RAMPS
-				if(gNetReps[(*ci)->rep_type].use_mode == use_Ramp && pts.size() > 20)
-				#endif
-				{
-					#if SHOW_BEZIERS
-						visualize_bezier(pts,true,0.1f, 0.0f);
-					#endif
-					orig_shape_count += pts.size();
-					bezier_multi_simplify_straight_ok(pts, MTR_TO_DEG_LAT * gNetReps[(*ci)->rep_type].max_err, 0.00005);// * MTR_TO_DEG_LAT * 5.0 * 5.0);
-					reduced_shape_count += pts.size();
-					#if SHOW_BEZIERS
-						visualize_bezier(pts,false,1.0f,1.0f);
-					#endif
-				}
-				#endif
+				list<Point2c>&	pts(chain_pts[chain_idx]);
 				DebugAssert(pts.size() >= 2);
 				pts.pop_back();
 				pts.pop_front();
@@ -27,6 +27,7 @@
 #include "DEMDefs.h"
 #include "DEMAlgs.h"
 #include <shapefil.h>
+#include <queue>
 #include "MapAlgs.h"
 #include "GISUtils.h"
 #include "WED_Globals.h"
@@ -131,56 +132,104 @@ struct hash<DemPt>
 HASH_MAP_NAMESPACE_END
 #endif
 
-typedef set<DemPt>				DemPtSet;
-typedef multimap<float, DemPt>	DemPtMap;
 typedef vector<DemPt>			DemPtVector;
 
+struct DemPtLater {
+	bool operator()(const DemPt& lhs, const DemPt& rhs) const { return rhs < lhs; }
+};
 
-inline void GetNeighbors(const DemPtSet& pts, DemPtSet& neighbors, DemPtMap& borderMap, int width, int height, const DEMGeo& elev)
-{
-	neighbors.clear();
-	for (DemPtSet::const_iterator p = pts.begin(); p != pts.end(); ++p)
+/******************************************************************************************************************************
+ * SINK FILL RASTER
+ ******************************************************************************************************************************/
+
+// FixSink grows a sink one pixel at a time, always taking the lowest pixel on its border.  Rather than keep
+// the sink and border as sets of points, we keep one byte of state per DEM pixel for the whole run and a flat
+// heap of border pixels.  Each call remembers which pixels it marked and clears only those when it is done,
+// so a small sink costs only what it touches.
+
+enum {
+	fill_Free = 0,
+	fill_Sink,
+	fill_Border,
+	fill_Drained
+};
+
+struct SinkBorderPt {
+	float	e;
+	int		seq;		// Order we found the pixel in - equal heights come off first-in-first-out.
+	int		x;
+	int		y;
+};
+
+struct SinkBorderLater {
+	bool operator()(const SinkBorderPt& lhs, const SinkBorderPt& rhs) const {
+		if (lhs.e > rhs.e) return true;
+		if (lhs.e < rhs.e) return false;
+		return lhs.seq > rhs.seq;
+	}
+};
+
+struct SinkFillRaster {
+
+	SinkFillRaster(int w, int h) : width(w), height(h), seq(0), state(w * h, fill_Free) { }
+
+	int						width;
+	int						height;
+	int						seq;
+	vector<unsigned char>	state;
+	vector<int>				touched;
+	vector<DemPt>			sink;
+	vector<SinkBorderPt>	border;
+
+	int		get(int x, int y) const { return (x >= 0 && y >= 0 && x < width && y < height) ? state[x + y * width] : fill_Free; }
+
+	void	set(int x, int y, int s)
+	{
+		unsigned char& c = state[x + y * width];
+		if (c == fill_Free) touched.push_back(x + y * width);
+		c = s;
+	}
+
+	void	add_sink(int x, int y)
+	{
+		set(x, y, fill_Sink);
+		sink.push_back(DemPt(x, y));
+	}
+
+	// Queue all in-range neighbors of x,y that are neither in the sink nor already on the border.
+	void	add_neighbors(int x, int y, const DEMGeo& elev)
 	{
 		for (int n = 0; n < DIRS_COUNT; ++n)
 		{
-			DemPt np;
-			np.x = p->x + dirs_x[n];
-			np.y = p->y + dirs_y[n];
-			if (np.x >= 0 && np.y >= 0 && np.x < width && np.y < height)
-			if (pts.count(np) == 0)
+			int nx = x + dirs_x[n];
+			int ny = y + dirs_y[n];
+			if (nx >= 0 && ny >= 0 && nx < width && ny < height)
+			if (state[nx + ny * width] == fill_Free)
 			{
-				neighbors.insert(np);
-				float e = elev.get(np.x, np.y);
-				borderMap.insert(DemPtMap::value_type(e, np));
-
+				set(nx, ny, fill_Border);
+				SinkBorderPt b = { elev.get(nx, ny), seq++, nx, ny };
+				border.push_back(b);
+				push_heap(border.begin(), border.end(), SinkBorderLater());
 			}
 		}
 	}
-}
 
-inline void AddPtToSet(DemPtSet& area, DemPtSet& border, DemPtMap& borderMap, const DemPtMap::iterator it, int width, int height, const DEMGeo& elev)
-{
-	DemPt	p = it->second;
-	DebugAssert(border.count(p) == 1);
+	void	pop_border(void)
+	{
+		pop_heap(border.begin(), border.end(), SinkBorderLater());
+		border.pop_back();
+	}
 
-	area.insert(p);
-	border.erase(p);
-	borderMap.erase(it);
-	for (int n = 0; n < DIRS_COUNT; ++n)
+	void	reset(void)
 	{
-		DemPt np;
-		np.x = p.x + dirs_x[n];
-		np.y = p.y + dirs_y[n];
-		if (np.x >= 0 && np.y >= 0 && np.x < width && np.y < height)
-		if (area.count(np) == 0)
-		if (border.count(np) == 0)
-		{
-			float e=  elev.get(np.x, np.y);
-			border.insert(np);
-			borderMap.insert(DemPtMap::value_type(e, np));
-		}
+		for (vector<int>::iterator t = touched.begin(); t != touched.end(); ++t)
+			state[*t] = fill_Free;
+		touched.clear();
+		sink.clear();
+		border.clear();
+		seq = 0;
 	}
-}
+};
 
 /******************************************************************************************************************************
  * RIVER DETECTION
@@ -277,48 +326,46 @@ static void BurnLowestNearDrainPt(const DEMGeo& elev, DEMGeo& hydro_dir, double
 
 }
 
-int FixSink(int x, int y, DEMGeo& elev, DEMGeo& hydro_dir)
+int FixSink(int x, int y, DEMGeo& elev, DEMGeo& hydro_dir, SinkFillRaster& fill)
 {
-	DemPt		orig; orig.x = x; orig.y = y;
-	DemPtSet	sink; sink.insert(orig);
 	float		low_elev;
 	DemPt		drainPt;
 	float		orig_elev = elev(x,y);
 	int			hosed_fill = sink_Invalid;
 	int			ctr = 0;
-	DemPtSet	last_border(sink);
-	DemPtMap	border_elev;
-	GetNeighbors(sink, last_border, border_elev, elev.mWidth, elev.mHeight, elev);
+	int			left;
+	fill.add_sink(x, y);
+	fill.add_neighbors(x, y, elev);
 	while (1)
 	{
-		if (last_border.empty())
+		if (fill.border.empty())
 			goto hosed;
-		DebugAssert(!border_elev.empty());
 
-		DemPtMap::iterator i = border_elev.begin();
-		low_elev = i->first;
+		low_elev = fill.border.front().e;
+		drainPt = DemPt(fill.border.front().x, fill.border.front().y);
 
 		++ctr;
-		if (low_elev < elev(x,y) || hydro_dir(i->second.x, i->second.y) == sink_Known)
+		if (low_elev < elev(x,y) || hydro_dir(drainPt.x, drainPt.y) == sink_Known)
 		{
-			drainPt = i->second;
 #if DEV
 			DemPt foo(drainPt);
 			if (GetNext(foo.x, foo.y, hydro_dir))
-				DebugAssert(sink.count(foo) == 0);
+				DebugAssert(fill.get(foo.x, foo.y) != fill_Sink);
 #endif
 			goto found;
 		}
 
-		hydro_dir(i->second.x, i->second.y) = sink_Unresolved;
-		AddPtToSet(sink, last_border, border_elev, i, elev.mWidth, elev.mHeight, elev);
+		hydro_dir(drainPt.x, drainPt.y) = sink_Unresolved;
+		fill.pop_border();
+		fill.add_sink(drainPt.x, drainPt.y);
+		fill.add_neighbors(drainPt.x, drainPt.y, elev);
 
 		elev(x, y) = low_elev;
 
 		DebugAssert(low_elev >= orig_elev);
 		if ((low_elev - orig_elev) > MAX_FLOOD)
 			goto hosed;
-		if (sink.size() > MAX_AREA)
+		if (fill.sink.size() > MAX_AREA)
 		{
 			// BEN SEZ:: at this point our lakes are so @#$@#ing huge we probably do NOT want to fill them in -
 			// if there was a lake there, it'd be on VMAP0.
@@ -328,42 +375,48 @@ int FixSink(int x, int y, DEMGeo& elev, DEMGeo& hydro_dir)
 	}
 hosed:
 
-	for (DemPtSet::iterator j = sink.begin(); j != sink.end(); ++j)
+	for (DemPtVector::iterator j = fill.sink.begin(); j != fill.sink.end(); ++j)
 		elev(j->x, j->y) = low_elev;
 
-	for (DemPtSet::iterator j = sink.begin(); j != sink.end(); ++j)
+	for (DemPtVector::iterator j = fill.sink.begin(); j != fill.sink.end(); ++j)
 		hydro_dir(j->x, j->y) = hosed_fill;
+	fill.reset();
 	return ctr;
 
 found:
 
-	for (DemPtSet::iterator j = sink.begin(); j != sink.end(); ++j)
+	for (DemPtVector::iterator j = fill.sink.begin(); j != fill.sink.end(); ++j)
 		elev(j->x, j->y) = low_elev;
 
-	DemPtSet	ok, working;
-	working.insert(drainPt);
-
-	while (!working.empty())
 	{
-		DemPt tr = *working.begin();
-		working.erase(working.begin());
-		ok.insert(tr);
+		// Drain the sink back from the drain point.  We always work the lowest (y,x) pixel next, the same order a
+		// set of points would give us, so each sink pixel picks up the same drain direction as it always has.
+		priority_queue<DemPt, DemPtVector, DemPtLater>	working;
+		working.push(drainPt);
+		left = fill.sink.size();
 
-		for (int n = 0; n < DIRS_COUNT; ++n)
+		while (!working.empty())
 		{
-			DemPt	tr_n(tr);
-			tr_n.x -= dirs_x[n];
-			tr_n.y -= dirs_y[n];
-			if (sink.count(tr_n) > 0)
+			DemPt tr = working.top();
+			working.pop();
+
+			for (int n = 0; n < DIRS_COUNT; ++n)
 			{
-				hydro_dir(tr_n.x, tr_n.y) = n+drain_Dir0;
-				sink.erase(tr_n);
-				if (ok.count(tr_n) == 0)
-					working.insert(tr_n);
+				DemPt	tr_n(tr);
+				tr_n.x -= dirs_x[n];
+				tr_n.y -= dirs_y[n];
+				if (fill.get(tr_n.x, tr_n.y) == fill_Sink)
+				{
+					hydro_dir(tr_n.x, tr_n.y) = n+drain_Dir0;
+					fill.set(tr_n.x, tr_n.y, fill_Drained);
+					--left;
+					working.push(tr_n);
+				}
 			}
 		}
 	}
-	DebugAssert(sink.empty());
+	DebugAssert(left == 0);
+	fill.reset();
 	return ctr;
 }
 
@@ -636,6 +689,7 @@ void	BuildRivers(const Pmwx& inMap, DEMGeoMap& ioDEMs, int borders[4], ProgressF
 
 	if (inProg) inProg(2, 4, "Removing sinks...", 0.0);
 	int total_sink_pts = 0;
+	SinkFillRaster	fill(elev.mWidth, elev.mHeight);
 //	map<int, int>	histo;
 	for (x = 0; x < hydro_dir.mWidth; ++x)
 	{
@@ -644,7 +698,7 @@ void	BuildRivers(const Pmwx& inMap, DEMGeoMap& ioDEMs, int borders[4], ProgressF
 		{
 			if (hydro_dir(x,y) == sink_Unresolved)
 			{
-				int worked = FixSink(x, y, elev, hydro_dir);
+				int worked = FixSink(x, y, elev, hydro_dir, fill);
 				total_sink_pts += worked;
 				worked -= (worked % 100);
 //				histo[worked]++;
@@ -40,6 +40,8 @@
 	#include "RF_Selection.h"
 #endif
 
+#include <CGAL/Arr_batched_point_location.h>
+
 #if CGAL_BETA_SIMPLIFIER
 #include <CGAL/Polyline_simplification_2.h>
 #include <CGAL/Polyline_simplification_2/Squared_distance_cost.h>
@@ -1659,6 +1661,44 @@ void	CalcBoundingBox(
 	ne = ben2cgal<Point_2>(box.p2);
 }
 
+void	LocateFaces(
+			Pmwx&					inMap,
+			const vector<Point_2>&	inPoints,
+			vector<Face_handle>&	outFaces)
+{
+	outFaces.assign(inPoints.size(), Face_handle());
+	if(inPoints.empty()) return;
+
+	// The sweep reports back in its own order, so sort the queries (minus duplicates) and merge the answers
+	// back to the callers' indices by point.
+	vector<int>	order(inPoints.size());
+	for(int i = 0; i < order.size(); ++i)
+		order[i] = i;
+	sort(order.begin(), order.end(), [&inPoints](int a, int b) { return CGAL::compare_xy(inPoints[a], inPoints[b]) == CGAL::SMALLER; });
+
+	vector<Point_2>	queries;
+	queries.reserve(order.size());
+	for(vector<int>::iterator i = order.begin(); i != order.end(); ++i)
+	if(queries.empty() || queries.back() != inPoints[*i])
+		queries.push_back(inPoints[*i]);
+
+	typedef pair<Point_2, CGAL::Object>	Query_result;
+	vector<Query_result>	results;
+	results.reserve(queries.size());
+	CGAL::locate(inMap, queries.begin(), queries.end(), back_inserter(results));
+	sort(results.begin(), results.end(), [](const Query_result& a, const Query_result& b) { return CGAL::compare_xy(a.first, b.first) == CGAL::SMALLER; });
+
+	int r = 0;
+	for(vector<int>::iterator i = order.begin(); i != order.end(); ++i)
+	{
+		while(r < results.size() && CGAL::compare_xy(results[r].first, inPoints[*i]) == CGAL::SMALLER)
+			++r;
+		Face_const_handle ff;
+		if(r < results.size() && results[r].first == inPoints[*i] && CGAL::assign(ff, results[r].second))
+			outFaces[*i] = inMap.non_const_handle(ff);
+	}
+}
+
 
 double	GetMapFaceAreaMeters(const Face_handle f, Bbox2 * out_bounds)
 {
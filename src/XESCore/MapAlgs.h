@@ -220,6 +220,19 @@ void	CalcBoundingBox(
 			Point_2&		sw,
 			Point_2&		ne);
 
+/*
+ * LocateFaces
+ *
+ * Given a list of points, find the face each one is in, using one sweep over the whole map instead of a
+ * walk per point.  A point that lands on an edge or vertex gets a null Face_handle - the same points the
+ * single-point locators report as not-a-face.
+ *
+ */
+void	LocateFaces(
+			Pmwx&					inMap,
+			const vector<Point_2>&	inPoints,
+			vector<Face_handle>&	outFaces);
+
 // These next routines, move elsewhere to just GIS-related as opposed to comp-geom related
 
 /*
@@ -88,8 +88,112 @@
  *
  * A param map is a mapping of enumerated properties to their values.
  * Params are applied to all areas and are used to control land class
- * instantiation. */
-typedef	map<int, double>	GISParamMap;
+ * instantiation.
+ *
+ * Most faces and edges carry only a handful of params, so rather than a
+ * std::map we keep them as a sorted array of key/value pairs that lives
+ * inline until it outgrows kInlineCount and then moves to the heap.  The
+ * interface is the subset of std::map the GIS code uses; iteration is in
+ * key order so equality and MapIO output are unchanged.  Unlike std::map,
+ * inserting a new key invalidates iterators and references into the map. */
+class GISParamMap {
+public:
+
+	typedef int						key_type;
+	typedef double					mapped_type;
+	typedef pair<int, double>		value_type;
+	typedef value_type *			iterator;
+	typedef const value_type *		const_iterator;
+	typedef int						size_type;
+
+	GISParamMap() : mData(mInline), mSize(0), mCapacity(kInlineCount) { }
+	GISParamMap(const GISParamMap& rhs) : mData(mInline), mSize(0), mCapacity(kInlineCount) { *this = rhs; }
+	~GISParamMap() { if (mData != mInline) delete [] mData; }
+
+	GISParamMap& operator=(const GISParamMap& rhs)
+	{
+		if (this != &rhs)
+		{
+			mSize = 0;
+			reserve(rhs.mSize);
+			copy(rhs.begin(), rhs.end(), mData);
+			mSize = rhs.mSize;
+		}
+		return *this;
+	}
+
+	iterator			begin(void)			{ return mData; }
+	iterator			end(void)			{ return mData + mSize; }
+	const_iterator		begin(void) const	{ return mData; }
+	const_iterator		end(void) const		{ return mData + mSize; }
+	size_type			size(void) const	{ return mSize; }
+	bool				empty(void) const	{ return mSize == 0; }
+	void				clear(void)			{ mSize = 0; }
+
+	iterator			find(int k)			{ iterator i = lower(k); return (i != end() && i->first == k) ? i : end(); }
+	const_iterator		find(int k) const	{ const_iterator i = lower(k); return (i != end() && i->first == k) ? i : end(); }
+	size_type			count(int k) const	{ return find(k) != end(); }
+
+	double&				operator[](int k)
+	{
+		iterator i = lower(k);
+		if (i == end() || i->first != k)
+			i = insert_at(i, value_type(k, 0.0));
+		return i->second;
+	}
+
+	pair<iterator, bool>	insert(const value_type& v)
+	{
+		iterator i = lower(v.first);
+		if (i != end() && i->first == v.first)
+			return pair<iterator, bool>(i, false);
+		return pair<iterator, bool>(insert_at(i, v), true);
+	}
+
+	template <class InputIterator>
+	void				insert(InputIterator b, InputIterator e) { for (; b != e; ++b) insert(value_type(b->first, b->second)); }
+
+	void				erase(iterator i)	{ copy(i + 1, end(), i); --mSize; }
+	size_type			erase(int k)		{ iterator i = find(k); if (i == end()) return 0; erase(i); return 1; }
+
+	bool				operator==(const GISParamMap& rhs) const { return mSize == rhs.mSize && equal(begin(), end(), rhs.begin()); }
+	bool				operator!=(const GISParamMap& rhs) const { return !(*this == rhs); }
+
+private:
+
+	enum { kInlineCount = 4 };
+
+	static bool			key_less(const value_type& lhs, int k) { return lhs.first < k; }
+	iterator			lower(int k)		{ return lower_bound(begin(), end(), k, key_less); }
+	const_iterator		lower(int k) const	{ return lower_bound(begin(), end(), k, key_less); }
+
+	void				reserve(int n)
+	{
+		if (n <= mCapacity) return;
+		int cap = max(n, mCapacity * 2);
+		value_type * data = new value_type[cap];
+		copy(begin(), end(), data);
+		if (mData != mInline) delete [] mData;
+		mData = data;
+		mCapacity = cap;
+	}
+
+	iterator			insert_at(iterator i, const value_type& v)
+	{
+		int idx = i - mData;
+		reserve(mSize + 1);
+		i = mData + idx;
+		copy_backward(i, end(), end() + 1);
+		*i = v;
+		++mSize;
+		return i;
+	}
+
+	value_type *		mData;
+	int					mSize;
+	int					mCapacity;
+	value_type			mInline[kInlineCount];
+};
 
 /* GISPointFeature_t
  *
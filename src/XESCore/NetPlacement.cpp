@@ -32,6 +32,7 @@
 #include "STLUtils.h"
 #include "MathUtils.h"
 #include "GISTool_Globals.h"
+#include <atomic>
 #if OPENGL_MAP
 #include "RF_Selection.h"
 #endif
@@ -71,6 +72,12 @@ void	MakeHalfedgeOneway(Pmwx::Halfedge_handle he)
  ******************************************************************************************/
 #pragma mark -
 
+int		Net_NextSerial(void)
+{
+	static atomic<int>	next_serial(0);
+	return next_serial++;
+}
+
 Net_ChainInfo_t * Net_JunctionInfo_t::get_other(Net_ChainInfo_t * me)
 {
 	DebugAssert(chains.size() == 2);
@@ -268,71 +275,149 @@ int	NukeStraightShapePoints(Net_ChainInfoSet& ioChains)
 }
 
 
+// A junction we can dissolve: exactly two chains of the same type, neither a loop, and for one-way roads,
+// one feeding into the other.  (Ignore layer?  YES!  If we only have 2 roads coming together, assume that
+// differing layer does NOT mean that they really are hanging off.)  None of this changes as chains merge,
+// because a merged chain keeps the type, ends and direction of the chains it was made from.
+static bool	net_junction_passes_through(Net_JunctionInfo_t * me, bool water_only)
+{
+	if (me->chains.size() != 2)
+		return false;
+	Net_ChainInfoSet::iterator i = me->chains.begin();
+	Net_ChainInfo_t * sc = *i++;
+	Net_ChainInfo_t * ec = *i++;
+
+	if (!sc->over_water && water_only)
+		return false;
+	if (sc->rep_type != ec->rep_type ||
+		sc->export_type != ec->export_type ||
+		sc->over_water != ec->over_water ||
+//		sc->draped != ec->draped ||
+		sc->start_junction == sc->end_junction ||
+		ec->start_junction == ec->end_junction)
+		return false;
+	if (IsOneway(sc->rep_type))
+		return (sc->end_junction == me) != (ec->end_junction == me);
+	return true;
+}
+
+struct	net_run_link {
+	Net_ChainInfo_t *	chain;
+	bool				reversed;		// Walk this chain end to start.
+	Net_JunctionInfo_t * from(void) const { return reversed ? chain->end_junction : chain->start_junction; }
+	Net_JunctionInfo_t * to  (void) const { return reversed ? chain->start_junction : chain->end_junction; }
+	int					from_layer(void) const { return reversed ? chain->end_layer : chain->start_layer; }
+	int					to_layer  (void) const { return reversed ? chain->start_layer : chain->end_layer; }
+};
+
 // This routine takes a network and combines chains that are contiguous through a junction, reducing
 // junctions and forming longer chains.
+//
+// Each run of chains through dissolvable junctions is found with one walk and rebuilt with one copy of its
+// shape points, so the cost is linear in the network size no matter how long the roads are.  A run that
+// comes back to where it started is left as two chains (the last one separate) - we don't make loop chains.
 void	OptimizeNetwork(Net_JunctionInfoSet& ioJunctions, Net_ChainInfoSet& outChains, bool water_only)
 {
 	int	total_merged = 0;
 	int total_removed = 0;
 
-	// First go through and consider every jucntion...if it has 2 items and they're the same and not a
-	// loop, we can coalesce.
-	for (Net_JunctionInfoSet::iterator junc = ioJunctions.begin(); junc != ioJunctions.end(); ++junc)
+	vector<Net_ChainInfo_t *>	all_chains(outChains.begin(), outChains.end());
+	hash_map<Net_ChainInfo_t *, bool>	visited;
+	deque<net_run_link>			run;
+	
+	for (vector<Net_ChainInfo_t *>::iterator c = all_chains.begin(); c != all_chains.end(); ++c)
 	{
-		Net_JunctionInfo_t * me = (*junc);
-		if (me->chains.size() == 2)
+		if (!visited.insert(make_pair(*c, true)).second)
+			continue;
+
+		run.clear();
+		net_run_link seed = { *c, false };
+		run.push_back(seed);
+		
+		// Walk forward off our end...
+		bool ring = false;
+		Net_JunctionInfo_t * at = seed.to();
+		while (net_junction_passes_through(at, water_only))
 		{
-			Net_ChainInfoSet::iterator i = me->chains.begin();
-			Net_ChainInfo_t * sc = *i++;
-			Net_ChainInfo_t * ec = *i++;
-
-			if (sc->over_water || !water_only)
-			if (sc != ec && sc->rep_type == ec->rep_type &&					// Ignore layer?  YES!  If we only have 2 roads coming together, assume that differing layer does 
-						    sc->export_type == ec->export_type &&			// NOT mean that they really are hanging off.
-						    sc->over_water == ec->over_water &&
-//							sc->draped == ec->draped &&
-				sc->start_junction != sc->end_junction &&
-				ec->start_junction != ec->end_junction &&
-				sc->other_junc(me) != ec->other_junc(me))
+			Net_ChainInfo_t * next = (*at->chains.begin() == run.back().chain) ? *at->chains.rbegin() : *at->chains.begin();
+			if (next == seed.chain)
 			{
-				// Organize so start chain feeds into end chain directionally, with
-				// us as the middle junction.
-				
-				if(sc->start_junction == me && ec->end_junction == me)
-					swap(sc,ec);
-
-				if(!IsOneway(sc->rep_type) && sc->end_junction != me)	sc->reverse();
-				if(!IsOneway(ec->rep_type) && ec->start_junction != me)	ec->reverse();
-
-				if(sc->end_junction == me && ec->start_junction == me)
-				{
-					// These junctions cap the new complete chain.
-					Net_JunctionInfo_t * sj = sc->start_junction;
-					Net_JunctionInfo_t * ej = ec->end_junction;
-					Assert (sj != me);
-					Assert (ej != me);
-					// Accumulate all shape points.
-					sc->shape.push_back(me->location);
-//					sc->agl.push_back(me->agl);
-//					sc->power_crossing.push_back(me->power_crossing);
-					sc->shape.insert(sc->shape.end(), ec->shape.begin(),ec->shape.end());
-//					sc->agl.insert(sc->agl.end(), ec->agl.begin(),ec->agl.end());
-//					sc->power_crossing.insert(sc->power_crossing.end(), ec->power_crossing.begin(), ec->power_crossing.end());
-					// We no longer have points.
-					me->chains.clear();
-					// End junction now has first chain instead of second.
-					ej->chains.erase(ec);
-					ej->chains.insert(sc);
-					// Start chain now ends at end junction, not us.
-					sc->end_junction = ej;
-					sc->end_layer = ec->end_layer;
-					// Nuke second chain, it's useless.
-					delete ec;
-					outChains.erase(ec);
-					++total_merged;
-				}
+				ring = true;
+				break;
+			}
+			net_run_link l = { next, next->start_junction != at };
+			run.push_back(l);
+			visited[next] = true;
+			at = l.to();
+		}
+		
+		// ...and backward off our start, unless we went all the way around.
+		if (!ring)
+		{
+			at = seed.from();
+			while (net_junction_passes_through(at, water_only))
+			{
+				Net_ChainInfo_t * prev = (*at->chains.begin() == run.front().chain) ? *at->chains.rbegin() : *at->chains.begin();
+				DebugAssert(prev != seed.chain);
+				net_run_link l = { prev, prev->end_junction != at };
+				run.push_front(l);
+				visited[prev] = true;
+				at = l.from();
+			}
+		}
+		
+		int merge_count = run.size();
+		if (run.front().from() == run.back().to())
+			--merge_count;
+		if (merge_count < 2)
+			continue;
+		
+		// The first chain of the run becomes the whole run.
+		Net_ChainInfo_t *		keep = run.front().chain;
+		Net_JunctionInfo_t *	sj = run.front().from();
+		Net_JunctionInfo_t *	ej = run[merge_count-1].to();
+		int						sl = run.front().from_layer();
+		int						el = run[merge_count-1].to_layer();
+
+		int total_pts = merge_count - 1;
+		for (int n = 0; n < merge_count; ++n)
+			total_pts += run[n].chain->shape.size();
+		vector<Point2>	shape;
+		shape.reserve(total_pts);
+		for (int n = 0; n < merge_count; ++n)
+		{
+			const vector<Point2>& s(run[n].chain->shape);
+			if (run[n].reversed)
+				shape.insert(shape.end(), s.rbegin(), s.rend());
+			else
+				shape.insert(shape.end(), s.begin(), s.end());
+			if (n < merge_count - 1)
+			{
+				// These junctions are no longer needed - we get all of their points.
+				Net_JunctionInfo_t * mid = run[n].to();
+				shape.push_back(mid->location);
+				mid->chains.clear();
 			}
 		}
+
+		Net_ChainInfo_t * last = run[merge_count-1].chain;
+		if (last != keep)
+		{
+			ej->chains.erase(last);
+			ej->chains.insert(keep);
+		}
+		for (int n = 1; n < merge_count; ++n)
+		{
+			outChains.erase(run[n].chain);
+			delete run[n].chain;
+			++total_merged;
+		}
+		
+		keep->shape.swap(shape);
+		keep->start_junction = sj;
+		keep->end_junction = ej;
+		keep->start_layer = sl;
+		keep->end_layer = el;
 	}
 
 	// Now go through and take out the trash...schedule for deletion every 0-valence
@@ -386,38 +471,104 @@ inline bool within_box(const Point2& p1, const Point2& p2, double d)
 
 typedef multiset<Net_JunctionInfo_t *, sort_by_y>	y_sorted_set;
 
+// Same order a y_sorted_set built from the junction set would give: by y, then set order for ties.
+struct sort_pair_by_y {
+	static bool junc_less(Net_JunctionInfo_t * a, Net_JunctionInfo_t * b)
+	{
+		if(a->location.y() != b->location.y()) return a->location.y() < b->location.y();
+		return a->serial < b->serial;
+	}
+	bool operator()(const JuncPair& lhs, const JuncPair& rhs) const
+	{
+		if(lhs.first != rhs.first) return junc_less(lhs.first, rhs.first);
+		return junc_less(lhs.second, rhs.second);
+	}
+};
+
+// Uniform grid of junctions for MergeNearJunctions.  Cells are 2x the merge distance, so any pair within the
+// merge box is in the same or an adjacent cell no matter how the division rounds.
+class	junc_grid {
+public:
+	junc_grid(double dist) : cell_(2.0 * dist) { }
+	
+	void	insert(Net_JunctionInfo_t * j) { cells_[key(j->location)].push_back(j); }
+	void	remove(Net_JunctionInfo_t * j, const Point2& where)
+	{
+		vector<Net_JunctionInfo_t *>& c(cells_[key(where)]);
+		vector<Net_JunctionInfo_t *>::iterator i = find(c.begin(), c.end(), j);
+		DebugAssert(i != c.end());
+		if(i != c.end())
+		{
+			*i = c.back();
+			c.pop_back();
+		}
+	}
+	
+	// Every other junction in the 3x3 cells around p.
+	template <typename F>
+	void	for_near(const Point2& p, F func)
+	{
+		int cx = floor(p.x() / cell_), cy = floor(p.y() / cell_);
+		for(int dy = -1; dy <= 1; ++dy)
+		for(int dx = -1; dx <= 1; ++dx)
+		{
+			hash_map<long long, vector<Net_JunctionInfo_t *> >::iterator c = cells_.find(key(cx+dx, cy+dy));
+			if(c != cells_.end())
+			for(vector<Net_JunctionInfo_t *>::iterator j = c->second.begin(); j != c->second.end(); ++j)
+				func(*j);
+		}
+	}
+
+private:
+	long long	key(int cx, int cy) const { return ((long long) cx << 32) ^ (unsigned int) cy; }
+	long long	key(const Point2& p) const { return key((int) floor(p.x() / cell_), (int) floor(p.y() / cell_)); }
+
+	double												cell_;
+	hash_map<long long, vector<Net_JunctionInfo_t *> >	cells_;
+};
+
+// Each pass finds every pair of junctions within the merge box, sorts the pairs by distance and merges them
+// closest first; merging moves the survivor to the midpoint, so we go again until nothing merges.  Pairs
+// between junctions that did not move were all tried in the previous pass, so after the first pass we only
+// have to look around the junctions that moved.  The candidates are put in the order the old y-sorted sweep
+// produced them before the distance sort, so ties break exactly as they always have.
 void	MergeNearJunctions(Net_JunctionInfoSet& juncs, Net_ChainInfoSet& chains, double dist)
 {
 //		ValidateNetworkTopology(juncs,chains);
 
 	printf("Before merge: %zd juncs, %zd chains.\n", juncs.size(), chains.size());
 
+	junc_grid			grid(dist);
+	Net_JunctionInfoSet	moved(juncs);
+	for(Net_JunctionInfoSet::iterator j = juncs.begin(); j != juncs.end(); ++j)
+		grid.insert(*j);
+
 	while(1)
 	{
 
 		bool did_work = false;
-		y_sorted_set	sorted_juncs;
-		
-		copy(juncs.begin(),juncs.end(),set_inserter(sorted_juncs));
 
 		vector<JuncPair> kill;
-		for(y_sorted_set::iterator i = sorted_juncs.begin(); i != sorted_juncs.end(); ++i)
+		vector<Net_JunctionInfo_t *> dead_juncs;
+		for(Net_JunctionInfoSet::iterator i = moved.begin(); i != moved.end(); ++i)
 		{
-			y_sorted_set::iterator j(i);
-			++j;
-			while(j != sorted_juncs.end() && (((*j)->location.y() - (*i)->location.y()) < (2.0*dist)))
-			{
-//				printf("Measuring: 0x%08x, 0x%08x\n", (*i), (*j));
-			
-				if(within_box((*i)->location,(*j)->location,dist))
+			Net_JunctionInfo_t * me = *i;
+			grid.for_near(me->location, [&](Net_JunctionInfo_t * other) {
+				// A pair of two moved junctions is seen from both sides; keep it once.
+				if(other != me && (!moved.count(other) || me->serial < other->serial))
+				if(within_box(me->location,other->location,dist))
 				{
-					kill.push_back(JuncPair(*i,*j));
+					if(sort_pair_by_y::junc_less(me, other))
+						kill.push_back(JuncPair(me,other));
+					else
+						kill.push_back(JuncPair(other,me));
 				}
-				++j;
-			}
+			});
 		}
+		sort(kill.begin(),kill.end(), sort_pair_by_y());
 		sort(kill.begin(),kill.end(), sort_by_sqr_dist());
 
+		moved.clear();
 		for(vector<JuncPair>::iterator jp = kill.begin(); jp != kill.end(); ++jp)
 		{
 //			printf("Considering: 0x%08x, 0x%08x\n", jp->first, jp->second);			
@@ -433,9 +584,14 @@ void	MergeNearJunctions(Net_JunctionInfoSet& juncs, Net_ChainInfoSet& chains, do
 				copy(dead.begin(),dead.end(),set_eraser(chains));
 				copy(dead.begin(),dead.end(),set_eraser(jp->first->chains));
 				
+				grid.remove(jp->first, jp->first->location);
+				grid.remove(jp->second, jp->second->location);
 				jp->first->location = Point2(
 								(jp->first->location.x() + jp->second->location.x()) * 0.5,
 								(jp->first->location.y() + jp->second->location.y()) * 0.5);
+				grid.insert(jp->first);
+				moved.insert(jp->first);
+				moved.erase(jp->second);
 				copy(jp->second->chains.begin(),jp->second->chains.end(), set_inserter(jp->first->chains));
 				
 				for(Net_ChainInfoSet::iterator c = jp->second->chains.begin(); c != jp->second->chains.end(); ++c)
@@ -444,14 +600,18 @@ void	MergeNearJunctions(Net_JunctionInfoSet& juncs, Net_ChainInfoSet& chains, do
 					if((*c)->end_junction == jp->second) (*c)->end_junction = jp->first;
 				}
 				
+				// Later pairs may still name the dead junction, and looking it up in the set reads it - keep it
+				// around until the pass is done.
 				DebugAssert(juncs.count(jp->second));
 				juncs.erase(jp->second);
-				delete jp->second;
+				dead_juncs.push_back(jp->second);
 				did_work = true;
 				// This was serious paranoia in inital implementation, but don't even have in dev, makes alg very slow.
 		//		ValidateNetworkTopology(juncs,chains);		
 			}
 		}	
+		for(vector<Net_JunctionInfo_t *>::iterator d = dead_juncs.begin(); d != dead_juncs.end(); ++d)
+			delete *d;
 	#if DEV
 		ValidateNetworkTopology(juncs,chains);
 	#endif
@@ -34,12 +34,23 @@ class	CDT;
  * FORMING NETWORK TOPOLOGY FROM GT-POLYGONS
  ******************************************************************************************/
 
+// Junctions and chains are numbered in the order they are created, and the network sets are ordered by that
+// number rather than by address - every pass over the network (and thus the DSF we write) comes out the same
+// from run to run.  Since the order looks into the object, a junction or chain must come out of every set
+// before it is deleted.
 struct Net_JunctionInfo_t ;
 struct Net_ChainInfo_t;
-typedef set<Net_JunctionInfo_t *>	Net_JunctionInfoSet;
-typedef set<Net_ChainInfo_t *>		Net_ChainInfoSet;
+struct sort_by_net_serial {
+	template <typename T>
+	bool operator()(const T * lhs, const T * rhs) const { return lhs->serial < rhs->serial; }
+};
+typedef set<Net_JunctionInfo_t *, sort_by_net_serial>	Net_JunctionInfoSet;
+typedef set<Net_ChainInfo_t *, sort_by_net_serial>		Net_ChainInfoSet;
+
+int		Net_NextSerial(void);
 
 struct	Net_JunctionInfo_t {
+	int								serial;
 	int								index;
 	Point2							location;					// Locations are in absolute MSL space -
 //	double							agl;						// agl of point over ground
@@ -53,14 +64,15 @@ public:
 	int								GetLayerForChain(Net_ChainInfo_t * me);
 	void							SetLayerForChain(Net_ChainInfo_t * me, int l);
 	
+	Net_JunctionInfo_t() : serial(Net_NextSerial()) {
 	#if DEV
-		Net_JunctionInfo_t() {
-			index = 0xDEADBEEF;
-		}
+		index = 0xDEADBEEF;
 	#endif
+	}
 };
 
 struct	Net_ChainInfo_t {
+	int								serial;
 	Net_JunctionInfo_t *			start_junction;				// Start and end junction ptrs
 	Net_JunctionInfo_t *			end_junction;
 	int								start_layer;
@@ -74,6 +86,8 @@ struct	Net_ChainInfo_t {
 //	vector<double>					agl;						// AGL height
 //	vector<int>						power_crossing;				// Does a road cross this powerline at this shape point (or vice versa)?
 
+	Net_ChainInfo_t() : serial(Net_NextSerial()) { }
+
 	Net_JunctionInfo_t *			other_junc(Net_JunctionInfo_t * junc);
 	void							reverse(void);
 
@@ -44,6 +44,8 @@
 #include "BlockFill.h"
 #include "BlockAlgs.h"
 #include "MathUtils.h"
+#include <limits.h>
+#include <atomic>
 
 // NOTE: all that this does is propegate parks, forestparks, cemetaries and golf courses to the feature type if
 // it isn't assigned.
@@ -302,6 +304,146 @@ static bool ReadLandFillRule(const vector<string>& tokens, void * ref)
 	return true;
 }
 
+/************************************************************************************************
+ * RULE INDEXES
+ ************************************************************************************************
+ * Every rule table is matched first-hit, in order.  The discrete keys (zoning, terrain, variant, road, etc.)
+ * are the cheap way to rule most of a table out, so once the tables are loaded we bucket rule indices by
+ * every tuple of key values - a rule with a wild-card key lands in every bucket along that key, and values
+ * that no rule names share slot 0.  A lookup then runs the full original test over only its bucket, which
+ * lists rules in table order, so the first hit is the same rule a scan of the whole table would find.
+ */
+
+static const int rule_key_exact = INT_MIN;		// Wild-card value for keys that have no wild-card.
+
+template <int N>
+struct rule_key_index {
+	hash_map<int, int>		slots[N];			// Per key: value -> slot.  Slot 0 is for values no rule names.
+	int						stride[N];
+	vector<vector<int> >	lists;				// Per slot tuple: the rules the keys admit, in table order.
+
+	rule_key_index() : lists(1) { for(int d = 0; d < N; ++d) stride[d] = 0; }
+
+	template <typename Table, typename Keys>
+	void	build(const Table& table, Keys keys, const int wild[N])
+	{
+		int k[N];
+		for(int d = 0; d < N; ++d)
+			slots[d].clear();
+		for(int r = 0; r < table.size(); ++r)
+		{
+			keys(table[r], k);
+			for(int d = 0; d < N; ++d)
+			if(k[d] != wild[d] && slots[d].count(k[d]) == 0)
+			{
+				int s = slots[d].size() + 1;
+				slots[d][k[d]] = s;
+			}
+		}
+
+		int total = 1;
+		for(int d = 0; d < N; ++d)
+		{
+			stride[d] = total;
+			total *= slots[d].size() + 1;
+		}
+		lists.assign(total, vector<int>());
+
+		for(int r = 0; r < table.size(); ++r)
+		{
+			// Walk every slot tuple this rule admits - all of them along a wild-card key.
+			int lo[N], hi[N], at[N];
+			keys(table[r], k);
+			for(int d = 0; d < N; ++d)
+			{
+				if(k[d] == wild[d])	{ lo[d] = 0; hi[d] = slots[d].size(); }
+				else				  lo[d] = hi[d] = slots[d][k[d]];
+				at[d] = lo[d];
+			}
+			while(1)
+			{
+				int i = 0;
+				for(int d = 0; d < N; ++d)
+					i += at[d] * stride[d];
+				lists[i].push_back(r);
+
+				int d = 0;
+				while(d < N && at[d] == hi[d])
+				{
+					at[d] = lo[d];
+					++d;
+				}
+				if(d == N) break;
+				++at[d];
+			}
+		}
+	}
+
+	const vector<int>&	find(const int k[N]) const
+	{
+		int i = 0;
+		for(int d = 0; d < N; ++d)
+		{
+			hash_map<int, int>::const_iterator s = slots[d].find(k[d]);
+			if(s != slots[d].end())
+				i += s->second * stride[d];
+		}
+		return lists[i];
+	}
+};
+
+struct rule_lookup_stats {
+	atomic<long long>	lookups;
+	atomic<long long>	examined;			// Rules whose full test we ran.
+
+	void	reset(void) { lookups = 0; examined = 0; }
+	void	count(long long n) { ++lookups; examined += n; }
+	void	print(const char * what, int table_size) const
+	{
+		long long l = lookups, e = examined;
+		printf("%s rules: %lld lookups, %lld rules examined (%.1f per lookup of %d).\n",
+			what, l, e, l ? (double) e / (double) l : 0.0, table_size);
+	}
+};
+
+static rule_key_index<2>	sZoningIndex;		// terrain, req_cat1
+static rule_key_index<3>	sFillIndex;			// zoning, road, variant
+static rule_key_index<2>	sPointIndex;		// zoning, feature
+static rule_key_index<2>	sFacadeIndex;		// zoning, variant
+
+static rule_lookup_stats	sZoningStats;
+static rule_lookup_stats	sFillStats;
+static rule_lookup_stats	sPointStats;
+static rule_lookup_stats	sFacadeStats;
+
+static void	BuildRuleIndexes(void)
+{
+	const int zoning_wild[2] = { NO_VALUE, NO_VALUE };
+	sZoningIndex.build(gZoningRules, [](const ZoningRule_t& r, int k[2]) { k[0] = r.terrain; k[1] = r.req_cat1; }, zoning_wild);
+
+	const int fill_wild[3] = { rule_key_exact, 0, -1 };
+	sFillIndex.build(gFillRules, [](const FillRule_t& r, int k[3]) { k[0] = r.zoning; k[1] = r.road; k[2] = r.variant; }, fill_wild);
+
+	const int point_wild[2] = { NO_VALUE, rule_key_exact };
+	sPointIndex.build(gPointRules, [](const PointRule_t& r, int k[2]) { k[0] = r.zoning; k[1] = r.feature; }, point_wild);
+
+	const int facade_wild[2] = { NO_VALUE, -1 };
+	sFacadeIndex.build(gFacadeSpellings, [](const FacadeSpelling_t& r, int k[2]) { k[0] = r.zoning; k[1] = r.variant; }, facade_wild);
+
+	sZoningStats.reset();
+	sFillStats.reset();
+	sPointStats.reset();
+	sFacadeStats.reset();
+}
+
+void	ReportZoningRuleStats(void)
+{
+	sZoningStats.print("Zoning", gZoningRules.size());
+	sFillStats.print("Fill", gFillRules.size());
+	sPointStats.print("Point", gPointRules.size());
+	sFacadeStats.print("Facade", gFacadeSpellings.size());
+}
+
 void LoadZoningRules(rf_region inRegion)
 {
 	gLandClassInfo.clear();
@@ -335,6 +477,8 @@ void LoadZoningRules(rf_region inRegion)
 		sp->width_min = sp->width_real - 10.0;
 		sp->width_max = sp->width_real + 20.0;
 	}
+
+	BuildRuleIndexes();
 }
 
 template <typename T>
@@ -408,8 +552,11 @@ static int		PickZoningRule(
 						float		minor_length,		// Length along the "short" axis of the block.
 						set<int>&	features)
 {
-	for(ZoningRuleTable::const_iterator r = gZoningRules.begin(); r != gZoningRules.end(); ++r)
+	const int key[2] = { terrain, cat1 };
+	const vector<int>& rules(sZoningIndex.find(key));
+	for(vector<int>::const_iterator i = rules.begin(); i != rules.end(); ++i)
 	{
+		const ZoningRule_t * r = &gZoningRules[*i];
 		if(r->terrain == NO_VALUE || r->terrain == terrain)
 		if(0 == r->sides_max || (r->sides_min <= num_sides && num_sides <= r->sides_max))
 		if(check_rule(r->size_min, r->size_max, area))
@@ -433,10 +580,12 @@ static int		PickZoningRule(
 		if(r->require_features.empty() || any_match(r->require_features, features))
 		if(r->crud_ok || is_subset(features, r->consume_features))
 		{
+			sZoningStats.count(i - rules.begin() + 1);
 			remove_these(features, r->consume_features);
 			return r->zoning;
 		}
 	}
+	sZoningStats.count(rules.size());
 	return NO_VALUE;
 }
 
@@ -996,6 +1145,12 @@ static void ZoneOneFace(
 
 	face->data().mParams[af_AGSides] = num_sides;
 
+	// Pull these out before the call - taking references to several params at once isn't safe if one of them has to be created.
+	double	cat1 = face->data().mParams[af_Cat1];
+	double	cat1_rat = face->data().mParams[af_Cat1Rat];
+	double	cat2 = face->data().mParams[af_Cat2];
+	double	cat2_rat = face->data().mParams[af_Cat2Rat];
+
 	//--------------------------------------------------------------------------------------------------------------------------------
 	// LET US MAKE A FREAKING DECISION!!!
 	//--------------------------------------------------------------------------------------------------------------------------------
@@ -1009,10 +1164,10 @@ static void ZoneOneFace(
 					max_height,
 					min_angle,
 					max_angle,
-					face->data().mParams[af_Cat1],
-					face->data().mParams[af_Cat1Rat],
-					face->data().mParams[af_Cat2],
-					face->data().mParams[af_Cat1Rat] + face->data().mParams[af_Cat2Rat],	// Really?  Yes.  This is the "high water mark" of BOTH cat 1 + cat 2.  That way
+					cat1,
+					cat1_rat,
+					cat2,
+					cat1_rat + cat2_rat,													// Really?  Yes.  This is the "high water mark" of BOTH cat 1 + cat 2.  That way
 					has_water,																// We can say "80% industrial, 90% urban, and we cover 80I+10U and 90I+0U.  In other
 					has_train,																// words when we can accept a mix, this lets the DOMINANT type crowd out the secondary.
 					has_local,
@@ -1981,31 +2136,45 @@ FillRule_t * GetFillRuleForBlock(Pmwx::Face_handle f)
 	int road_edge = f->data().GetParam(af_RoadEdge,0);
 	int variant = f->data().GetParam(af_Variant,0);
 
-	for(FillRuleTable::iterator r = gFillRules.begin(); r != gFillRules.end(); ++r)
-	if(r->zoning == z)
-	if(r->road == 0 || r->road == road_edge)
-	if(r->min_side_len == r->max_side_len || (r->min_side_len <= short_side && long_side <= r->max_side_len))
-	if(r->block_err_max == 0.0 || block_err < r->block_err_max)
-	if(r->min_side_major == r->max_side_major || (r->min_side_major <= long_axis && long_axis <= r->max_side_major))
-	if(r->min_side_minor == r->max_side_minor || (r->min_side_minor <= short_axis && short_axis <= r->max_side_minor))
-	if(r->ang_min == r->ang_max || (r->ang_min <= ang_min && ang_max < r->ang_max))
-	if(r->min_height == r->max_height || (r->min_height <= h && h <= r->max_height))
-	if(r->variant == -1 || r->variant == variant)
-		return &*r;
-
+	const int key[3] = { z, road_edge, variant };
+	const vector<int>& rules(sFillIndex.find(key));
+	for(vector<int>::const_iterator i = rules.begin(); i != rules.end(); ++i)
+	{
+		FillRule_t * r = &gFillRules[*i];
+		if(r->zoning == z)
+		if(r->road == 0 || r->road == road_edge)
+		if(r->min_side_len == r->max_side_len || (r->min_side_len <= short_side && long_side <= r->max_side_len))
+		if(r->block_err_max == 0.0 || block_err < r->block_err_max)
+		if(r->min_side_major == r->max_side_major || (r->min_side_major <= long_axis && long_axis <= r->max_side_major))
+		if(r->min_side_minor == r->max_side_minor || (r->min_side_minor <= short_axis && short_axis <= r->max_side_minor))
+		if(r->ang_min == r->ang_max || (r->ang_min <= ang_min && ang_max < r->ang_max))
+		if(r->min_height == r->max_height || (r->min_height <= h && h <= r->max_height))
+		if(r->variant == -1 || r->variant == variant)
+		{
+			sFillStats.count(i - rules.begin() + 1);
+			return r;
+		}
+	}
+	sFillStats.count(rules.size());
 	return NULL;
 }
 
 PointRule_t * GetPointRuleForFeature(int zoning, const GISPointFeature_t& f)
 {
-	for(PointRuleTable::iterator r = gPointRules.begin(); r != gPointRules.end(); ++r)
-	if(r->zoning == NO_VALUE || r->zoning == zoning)
-	if(r->feature == f.mFeatType)
-	if(r->height_min == r->height_max || (f.mParams.count(pf_Height) && r->height_min <= f.mParams.find(pf_Height)->second && f.mParams.find(pf_Height)->second <= r->height_max))
+	const int key[2] = { zoning, f.mFeatType };
+	const vector<int>& rules(sPointIndex.find(key));
+	for(vector<int>::const_iterator i = rules.begin(); i != rules.end(); ++i)
 	{
-		return &*r;
-
+		PointRule_t * r = &gPointRules[*i];
+		if(r->zoning == NO_VALUE || r->zoning == zoning)
+		if(r->feature == f.mFeatType)
+		if(r->height_min == r->height_max || (f.mParams.count(pf_Height) && r->height_min <= f.mParams.find(pf_Height)->second && f.mParams.find(pf_Height)->second <= r->height_max))
+		{
+			sPointStats.count(i - rules.begin() + 1);
+			return r;
+		}
 	}
+	sPointStats.count(rules.size());
 	return NULL;
 }
 
@@ -2014,32 +2183,38 @@ FacadeSpelling_t * GetFacadeRule(int zoning, int variant, double front_wall_len,
 	vector<FacadeSpelling_t *>	possible;
 	FacadeSpelling_t * emerg = NULL;
 	float emerg_dist = 0;
-	for(FacadeSpellingTable::iterator r = gFacadeSpellings.begin(); r != gFacadeSpellings.end(); ++r)
-	if(r->zoning == NO_VALUE || r->zoning == zoning)
-	if(r->variant == -1 || r->variant == variant)
-	if(r->height_min == r->height_max || (r->height_min <= height && height <= r->height_max))
-	if(r->depth_min == r->depth_max || (r->depth_min <= depth_one_fac && depth_one_fac <= r->depth_max))
+	const int key[2] = { zoning, variant };
+	const vector<int>& rules(sFacadeIndex.find(key));
+	sFacadeStats.count(rules.size());
+	for(vector<int>::const_iterator i = rules.begin(); i != rules.end(); ++i)
 	{
+		FacadeSpelling_t * r = &gFacadeSpellings[*i];
+		if(r->zoning == NO_VALUE || r->zoning == zoning)
+		if(r->variant == -1 || r->variant == variant)
+		if(r->height_min == r->height_max || (r->height_min <= height && height <= r->height_max))
+		if(r->depth_min == r->depth_max || (r->depth_min <= depth_one_fac && depth_one_fac <= r->depth_max))
 		{
-			double dist_to_this = 0;
-			if(r->width_min > front_wall_len)
-				dist_to_this = r->width_min - front_wall_len;
-			if(r->width_max < front_wall_len)
-				dist_to_this = front_wall_len - r->width_max;
-
-			if(emerg == NULL)
-			{
-				emerg = &*r;
-				emerg_dist = dist_to_this;
-			}
-			else if(dist_to_this < emerg_dist)
 			{
-				emerg = &*r;
-				emerg_dist = dist_to_this;
+				double dist_to_this = 0;
+				if(r->width_min > front_wall_len)
+					dist_to_this = r->width_min - front_wall_len;
+				if(r->width_max < front_wall_len)
+					dist_to_this = front_wall_len - r->width_max;
+
+				if(emerg == NULL)
+				{
+					emerg = r;
+					emerg_dist = dist_to_this;
+				}
+				else if(dist_to_this < emerg_dist)
+				{
+					emerg = r;
+					emerg_dist = dist_to_this;
+				}
 			}
+			if(r->width_min == r->width_max || (r->width_min <= front_wall_len && front_wall_len <= r->width_max))
+				possible.push_back(r);
 		}
-		if(r->width_min == r->width_max || (r->width_min <= front_wall_len && front_wall_len <= r->width_max))
-			possible.push_back(&*r);
 	}
 	if(possible.empty() && emerg)
 	{
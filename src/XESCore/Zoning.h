@@ -241,6 +241,9 @@ extern PointRuleTable			gPointRules;
 
 void	LoadZoningRules(rf_region inRegion);
 
+// Prints how many rules the zoning, fill, point and facade lookups have examined since the tables loaded.
+void	ReportZoningRuleStats(void);
+
 
 /*
  * Given a map and various raster parameters, go through the map and
@@ -809,6 +809,133 @@ static int DoHGTTileExport(const vector<const char *>& args)
 	return 0;
 }
 
+// What a CGIAR tile lends to its neighbors to the west and south: its west column and south row (whose first
+// sample is the southwest corner), plus enough geometry to check that it really tiles with them.  This is all
+// we keep of a decoded tile once it is written, so a bulk run decodes every source zip once.
+struct	srtm_edges {
+	double			west, east, south, north;
+	int				width, height;
+	vector<float>	west_col;
+	vector<float>	south_row;
+};
+
+static void	srtm_edges_from(const DEMGeo& dem, srtm_edges& edges)
+{
+	edges.west = dem.mWest;		edges.east = dem.mEast;
+	edges.south = dem.mSouth;	edges.north = dem.mNorth;
+	edges.width = dem.mWidth;	edges.height = dem.mHeight;
+	edges.west_col.resize(dem.mHeight);
+	edges.south_row.resize(dem.mWidth);
+	for (int n = 0; n < dem.mHeight; ++n)
+		edges.west_col[n] = dem.get(0, n);
+	for (int n = 0; n < dem.mWidth; ++n)
+		edges.south_row[n] = dem.get(n, 0);
+}
+
+static void	srtm_path(char * path, const char * dir, int x, int y)
+{
+	sprintf(path, "%s" DIR_STR "srtm_%02d_%02d.zip", dir, x, y);
+}
+
+// Copies the neighbors' edges onto our east column and north row - CGIAR tiles are missing the last row and
+// column.  A null neighbor is one that doesn't exist.  Returns false (after saying why) if a neighbor
+// doesn't tile with us.
+static bool	srtm_patch_edges(DEMGeo& me, const char * me_path, const char * src_dir, int x, int y,
+							const srtm_edges * east, const srtm_edges * north, const srtm_edges * northeast)
+{
+	char	path2[512];
+	int		n;
+	if (east)
+	{
+		if (east->west != me.mEast ||
+			east->south != me.mSouth ||
+			east->north != me.mNorth ||
+			east->height != me.mHeight)
+		{
+			srtm_path(path2, src_dir, (x%72)+1, y);
+			printf("File %s has %d by %d samples - doesn't tile right with %s.!!\n", path2, east->width, east->height, me_path);
+			return false;
+		}
+		for (n = 0; n < me.mHeight; ++n)
+			me(me.mWidth-1, n) = east->west_col[n];
+	}
+
+	if (north)
+	{
+		if (north->south != me.mNorth ||
+			north->west != me.mWest ||
+			north->east != me.mEast ||
+			north->width != me.mWidth)
+		{
+			srtm_path(path2, src_dir, x, y - 1);
+			printf("File %s has %d by %d samples - doesn't tile right with %s.!!\n", path2, north->width, north->height, me_path);
+			return false;
+		}
+		for (n = 0; n < me.mWidth; ++n)
+			me(n, me.mHeight-1) = north->south_row[n];
+	}
+
+	if (northeast)
+	{
+		if (northeast->south != me.mNorth ||
+			northeast->west != me.mEast)
+		{
+			srtm_path(path2, src_dir, (x%72)+1, y - 1);
+			printf("File %s has %d by %d samples - doesn't tile right with %s.!!\n", path2, northeast->width, northeast->height, me_path);
+			return false;
+		}
+		me(me.mWidth-1, me.mHeight-1) = northeast->south_row[0];
+	}
+	return true;
+}
+
+// Cuts a patched 6001x6001 tile into 25 1x1 degree HGTs.  The cuts and directories are made here; the zip
+// compression, which is most of the time, runs on the worker threads.  Each file is written by one thread
+// start to finish, so the files are the same as a serial write.
+static bool	srtm_write_tiles(const DEMGeo& me, const char * dst_dir)
+{
+	vector<DEMGeo>	subs(25);
+	vector<string>	paths(25);
+	char			path[512];
+	int				i, j;
+	for (i = 0; i < 5; ++i)
+	for (j = 0; j < 5; ++j)
+	{
+		DEMGeo& sub(subs[i * 5 + j]);
+		me.subset(sub, i * 1200, j * 1200, i * 1200 + 1200, j * 1200 + 1200);
+		sprintf(path, "%s" DIR_STR "%+03d%+04d" DIR_STR, dst_dir, latlon_bucket(sub.mSouth), latlon_bucket(sub.mWest));
+		FILE_make_dir_exist(path);
+		sprintf(path, "%s" DIR_STR "%+03d%+04d" DIR_STR "%+03d%+04d.hgt.zip", dst_dir, latlon_bucket(sub.mSouth), latlon_bucket(sub.mWest), (int) sub.mSouth, (int) sub.mWest);
+		printf("Writing %s...\n", path);
+		paths[i * 5 + j] = path;
+	}
+
+	vector<char>	ok(25, 0);
+	dem_parallel_rows(25, [&](int t1, int t2) {
+		for (int t = t1; t < t2; ++t)
+			ok[t] = WriteRawHGT(subs[t], paths[t].c_str());
+	});
+	for (int t = 0; t < 25; ++t)
+	if (!ok[t])
+	{
+		printf("Error writing %s\n", paths[t].c_str());
+		return false;
+	}
+	return true;
+}
+
+// Decodes one CGIAR source.  Returns false if it isn't there; out_ok is false if it is but isn't 6001x6001
+// (we can still borrow its edges).
+static bool	srtm_load(DEMGeo& dem, const char * path, bool& out_ok)
+{
+	if (!ExtractGeoTiff(dem, path, dem_want_Post, 0))
+		return false;
+	out_ok = (dem.mWidth == 6001 && dem.mHeight == 6001);
+	if (!out_ok)
+		printf("File %s has %d by %d samples - unexpected!!\n", path, dem.mWidth, dem.mHeight);
+	return true;
+}
+
 // Ben says: this routine was based on two assumptions, both of which may not be true:
 // 1. that the CGIAR SRTM tiles are 6000x6000 GeoTiffs, incorrectly offset by half a pixel, missing
 // one row and
@@ -818,89 +945,127 @@ static int DoHGTTileExport(const vector<const char *>& args)
 // -bulksrtm <src dir> <dst dir> <x> <y>
 static int DoBulkConvertSRTM(const vector<const  char *>& args)
 {
-	DEMGeo	me, north, east, northeast;
+	DEMGeo	me, other;
 	char	path[512], path2[512];
+	bool	ok;
 
 	int x = atoi(args[2]);
 	int y = atoi(args[3]);
-	int n;
-	int mode = dem_want_Post;
-	sprintf(path, "%s" DIR_STR "srtm_%02d_%02d.zip", args[0], x, y);
-	if (!ExtractGeoTiff(me, path,mode,0))
+	srtm_path(path, args[0], x, y);
+	if (!srtm_load(me, path, ok))
 	{
 		printf("File %s not found.\n", path);
 		return 0;
 	}
+	if (!ok)
+		return 0;
 
-	if (me.mWidth != 6001 || me.mHeight != 6001)
-	{
-		printf("File %s has %d by %d samples - unexpected!!\n", path, me.mWidth, me.mHeight);
+	srtm_edges	east, north, northeast;
+	bool		has_east, has_north, has_northeast;
+
+	srtm_path(path2, args[0], (x%72)+1, y);
+	if ((has_east = ExtractGeoTiff(other, path2, dem_want_Post, 0)))
+		srtm_edges_from(other, east);
+	srtm_path(path2, args[0], x, y - 1);
+	if ((has_north = ExtractGeoTiff(other, path2, dem_want_Post, 0)))
+		srtm_edges_from(other, north);
+	srtm_path(path2, args[0], (x%72)+1, y - 1);
+	if ((has_northeast = ExtractGeoTiff(other, path2, dem_want_Post, 0)))
+		srtm_edges_from(other, northeast);
+
+	if (!srtm_patch_edges(me, path, args[0], x, y,
+			has_east ? &east : NULL,
+			has_north ? &north : NULL,
+			has_northeast ? &northeast : NULL))
 		return 0;
-	}
 
-	sprintf(path2, "%s" DIR_STR "srtm_%02d_%02d.zip", args[0], (x%72)+1, y);
-	if (ExtractGeoTiff(east, path2, mode,0))
+	return srtm_write_tiles(me, args[1]) ? 0 : 1;
+}
+
+#define DoBulkConvertSRTMDir_HELP \
+"Usage: -bulksrtm_dir <src dir> <dst dir>\n"\
+"Converts every srtm_XX_YY.zip in the source dir, exactly as -bulksrtm would one at a time.\n"\
+"Each source is decoded once: we go north to south, west to east, and keep only the edges\n"\
+"that the tiles to the west and south need.\n"
+static int DoBulkConvertSRTMDir(const vector<const  char *>& args)
+{
+	vector<string>	files;
+	if (FILE_get_directory(args[0], &files, NULL) < 0)
 	{
-		if (east.mWest != me.mEast ||
-			east.mSouth != me.mSouth ||
-			east.mNorth != me.mNorth ||
-			east.mHeight != me.mHeight)
-		{
-			printf("File %s has %d by %d samples - doesn't tile right with %s.!!\n", path2, east.mWidth, east.mHeight, path);
-			return 0;
-		}
-		for (n = 0; n < me.mHeight; ++n)
-			me(me.mWidth-1, n) = east(0, n);
+		printf("Could not read directory %s.\n", args[0]);
+		return 1;
 	}
 
-	sprintf(path2, "%s" DIR_STR "srtm_%02d_%02d.zip", args[0], x, y - 1);
-	if (ExtractGeoTiff(north, path2, mode,0))
+	// CGIAR y counts rows from the north.
+	map<int, set<int> >	rows;
+	for (vector<string>::iterator f = files.begin(); f != files.end(); ++f)
 	{
-		if (north.mSouth != me.mNorth ||
-			north.mWest != me.mWest ||
-			north.mEast != me.mEast ||
-			north.mWidth != me.mWidth)
-		{
-			printf("File %s has %d by %d samples - doesn't tile right with %s.!!\n", path2, north.mWidth, north.mHeight, path);
-			return 0;
-		}
-		for (n = 0; n < me.mWidth; ++n)
-			me(n, me.mHeight-1) = north(n, 0);
+		int x, y;
+		char	check[64];
+		if (sscanf(f->c_str(), "srtm_%d_%d.zip", &x, &y) != 2) continue;
+		sprintf(check, "srtm_%02d_%02d.zip", x, y);
+		if (*f == check)
+			rows[y].insert(x);
 	}
 
-	sprintf(path2, "%s" DIR_STR "srtm_%02d_%02d.zip", args[0], (x%72)+1, y - 1);
-	if (ExtractGeoTiff(northeast, path2, mode,0))
+	map<int, srtm_edges>	north_row, this_row;
+	int						last_y = -1000;
+	for (map<int, set<int> >::iterator r = rows.begin(); r != rows.end(); ++r)
 	{
-		if (northeast.mSouth != me.mNorth ||
-			northeast.mWest != me.mEast)
-		{
-			printf("File %s has %d by %d samples - doesn't tile right with %s.!!\n", path2, northeast.mWidth, northeast.mHeight, path);
-			return 0;
-		}
-		me(me.mWidth-1, me.mHeight-1) = northeast(0,0);
-	}
+		int y = r->first;
+		if (last_y == y - 1)
+			north_row.swap(this_row);
+		else
+			north_row.clear();
+		this_row.clear();
+		last_y = y;
 
-	int i, j;
+		// A tile waits for the tile to its east to be decoded before it can be patched and written.
+		DEMGeo	pending, cur;
+		int		pending_x = -1;
+		char	pending_path[512];
 
-	DEMGeo	sub;
-	for (i = 0; i < 5; ++i)
-	for (j = 0; j < 5; ++j)
-	{
-		me.subset(sub, i * 1200, j * 1200, i * 1200 + 1200, j * 1200 + 1200);
-		sprintf(path, "%s" DIR_STR "%+03d%+04d" DIR_STR, args[1], latlon_bucket(sub.mSouth), latlon_bucket(sub.mWest));
-		FILE_make_dir_exist(path);
-		sprintf(path, "%s" DIR_STR "%+03d%+04d" DIR_STR "%+03d%+04d.hgt.zip", args[1], latlon_bucket(sub.mSouth), latlon_bucket(sub.mWest), (int) sub.mSouth, (int) sub.mWest);
-		printf("Writing %s...\n", path);
-		if (!WriteRawHGT(sub, path))
+		set<int>::iterator x = r->second.begin();
+		while (true)
 		{
-			printf("Error writing %s\n", path);
-			return 1;
+			char	path[512];
+			bool	have_cur = false, cur_ok = false;
+			if (x != r->second.end())
+			{
+				srtm_path(path, args[0], *x, y);
+				have_cur = srtm_load(cur, path, cur_ok);
+				if (have_cur)
+					srtm_edges_from(cur, this_row[*x]);
+			}
+
+			if (pending_x != -1)
+			{
+				int e = (pending_x % 72) + 1;
+				map<int, srtm_edges>::iterator east = this_row.find(e), north = north_row.find(pending_x), northeast = north_row.find(e);
+				if (srtm_patch_edges(pending, pending_path, args[0], pending_x, y,
+						east == this_row.end() ? NULL : &east->second,
+						north == north_row.end() ? NULL : &north->second,
+						northeast == north_row.end() ? NULL : &northeast->second))
+				if (!srtm_write_tiles(pending, args[1]))
+					return 1;
+				pending_x = -1;
+			}
+
+			if (x == r->second.end())
+				break;
+			if (have_cur && cur_ok)
+			{
+				pending.swap(cur);
+				pending_x = *x;
+				strcpy(pending_path, path);
+			}
+			++x;
 		}
 	}
-
 	return 0;
 }
 
+
 static DEMGeo	gMem, gMask;
 static bool has_mask = false;
 
@@ -987,6 +1152,7 @@ static	GISTool_RegCmd_t		sDemCmds[] = {
 //{ "-geotiff", 		1, 1, DoGeoTiffImport, 		"Import GeoTiff DEM", "" },
 { "-glcc", 			2, 2, DoGLCCImport, 		"Import GLCC land use raster data.", "" },
 { "-bulksrtm",		4, 4, DoBulkConvertSRTM,	"Bulk convert SRTM data.", "" },
+{ "-bulksrtm_dir",	2, 2, DoBulkConvertSRTMDir,	"Bulk convert a directory of SRTM data.", DoBulkConvertSRTMDir_HELP },
 { "-markoverlay",	0, 0, DoRemember,			"Remember the current elevation as overlay.", "" },
 { "-readmask",		1, 1, DoMaskRemember,		"Remember the current elevation as overlay.", "" },
 { "-raster_import",	4, 7, DoRasterImport,		"Import one raster DEM file.", DoRasterImport_HELP },
@@ -225,6 +225,20 @@ static int DoSpreadsheet(const vector<const char *>& args)
 	return 0;
 }
 
+static int DoCheckTerrainRules(const vector<const char *>& args)
+{
+	gNaturalTerrainSelfCheck = true;
+	if (gVerbose) printf("Terrain rule lookups will be checked against a full rule scan.\n");
+	return 0;
+}
+
+static int DoSetThreads(const vector<const char *>& args)
+{
+	gDemThreads = atoi(args[0]);
+	if (gVerbose) printf("Raster passes will use %d threads (0 = one per core).\n", gDemThreads);
+	return 0;
+}
+
 static int DoSetMeshLevel(const vector<const char *>& args)
 {
 	if(gVerbose) printf("Setting mesh level to %s\n", args[0]);
@@ -289,6 +303,7 @@ static int DoZoning(const vector<const char *>& args)
 {
 	if (gVerbose)	printf("Calculating zoning info...\n");
 	ZoneManMadeAreas(gMap, gDem[dem_Elevation], gDem[dem_LandUse], gDem[dem_ForestType], gDem[dem_ParkType], gDem[dem_Slope],gApts,	Pmwx::Face_handle(), 	gProgress);
+	if (gVerbose)	ReportZoningRuleStats();
 	return 0;
 }
 
@@ -464,6 +479,7 @@ static int DoInstantiateObjs(const vector<const char *>& args)
 	}
 
 	printf("Blocks: %d.  Split: %d. Forests: %d.  Parts: %d\n",  num_block_processed, num_blocks_with_split, num_forest_split, num_line_integ);
+	if (gVerbose)	ReportZoningRuleStats();
 	
 //	multimap<double, int> r_zone, r_sides;
 //	reverse_histo(by_zone,r_zone);
@@ -564,6 +580,8 @@ static	GISTool_RegCmd_t		sProcessCmds[] = {
 //{ "-roads",			0, 0, DoRoads,			"Generate Fake Roads.",				  "" },
 { "-spreadsheet",	1, 2, DoSpreadsheet,	"Set the spreadsheet file.",		  "" },
 { "-mesh_level",	1, 1, DoSetMeshLevel,	"Set mesh complexity.",				  "" },
+{ "-threads",		1, 1, DoSetThreads,		"Set worker threads for raster passes (0 = all cores).", "" },
+{ "-check_terrain_rules", 0, 0, DoCheckTerrainRules, "Verify terrain rule lookups.",	  "" },
 { "-upsample", 		0, 0, DoUpsample, 		"Upsample environmental parameters.", "" },
 { "-calcslope", 	0, 1, DoCalcSlope, 		"Calculate slope derivatives.", 	  "" },
 { "-calcmesh", 		1, 1, DoCalcMesh, 		"Calculate Terrain Mesh.", 	 		  "" },
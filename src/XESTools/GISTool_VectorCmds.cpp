@@ -105,18 +105,8 @@ static void	import_tiger_repository(const string& rt)
 		MFFileSet * fs = FileSet_Open(root.c_str());
 		if (fs)
 		{
-			printf("Reading %s/TGR%05d.RT1\n", root.c_str(), fnum);
-			TIGER_LoadRT1(fs, fnum);
-			printf("Reading %s/TGR%05d.RT2\n", root.c_str(), fnum);
-			TIGER_LoadRT2(fs, fnum);
-			printf("Reading %s/TGR%05d.RTP\n", root.c_str(), fnum);
-			TIGER_LoadRTP(fs, fnum);
-			printf("Reading %s/TGR%05d.RTI\n", root.c_str(), fnum);
-			TIGER_LoadRTI(fs, fnum);
-			printf("Reading %s/TGR%05d.RT7\n", root.c_str(), fnum);
-			TIGER_LoadRT7(fs, fnum);
-			printf("Reading %s/TGR%05d.RT8\n", root.c_str(), fnum);
-			TIGER_LoadRT8(fs, fnum);
+			printf("Reading %s/TGR%05d.RT1, RT2, RTP, RTI, RT7 and RT8\n", root.c_str(), fnum);
+			TIGER_LoadFileSet(fs, fnum);
 
 			FileSet_Close(fs);
 		} else
@@ -477,7 +477,7 @@ int main(int argc, char * argv[])
 
 	if (argc < 4) {
 		printf("Usage: %s <convert mode> <options> <input_file> <output_file>|-\n",argv[0]);
-		printf("Usage: %s --quilt <input_file> <width> <height> <patch size> <overlap> <trials> <output_files>\n",argv[0]);
+		printf("Usage: %s --quilt <input_file> <width> <height> <patch size> <overlap> <trials> <output_files> [<seed>]\n",argv[0]);
 		printf("       %s --version\n",argv[0]);
 		exit(1);
 	}
@@ -851,13 +851,14 @@ int main(int argc, char * argv[])
 		int splat = atoi(argv[5]);
 		int overlap = atoi(argv[6]);
 		int trials = atoi(argv[7]);
+		unsigned int seed = argc > 9 ? atoi(argv[9]) : 0;
 
 		printf("Will make %d x %d tex, with %d splats (%d overlap, %d trials.)\n", dst_w,dst_h, splat,overlap,trials);
 
 		CreateNewBitmap(dst_w,dst_h, 4, &dst);
 		if(src.channels == 3) ConvertBitmapToAlpha(&src,false);
 
-		make_texture(src, dst, splat, overlap, trials);
+		make_texture(src, dst, splat, overlap, trials, seed);
 
 		WriteBitmapToPNG(&dst, argv[8], NULL, 0, 2.2f);
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026, Laminar Research.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Stand-alone check of the binary OBJ8 cache - see readme.txt for how to build and run it.
+// The reader is pulled in whole, so we can get at its file-local number scanner and XObj8Same.
+
+#include "../../src/Obj/XObjReadWrite.cpp"
+#include <stdlib.h>
+
+static int	sFails = 0;
+
+#define CHECK(x) do { if(!(x)) { printf("FAILED: %s (line %d)\n", #x, __LINE__); ++sFails; } } while(0)
+
+// The scanner claims to be correctly rounded - so it must agree with strtof to the bit.
+static void	check_flt_scan(const char * txt)
+{
+	string	buf(txt);
+	buf += "\n";
+	xbyt *	p = (xbyt *) &buf[0];
+	xflt	got = TXT_MAP_flt_scan(p, p + buf.size(), xfals);
+	float	want = strtof(txt, NULL);
+	if(got != want)
+	{
+		printf("FAILED: TXT_MAP_flt_scan(\"%s\") gave %.9g, strtof gives %.9g\n", txt, got, want);
+		++sFails;
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	const char * obj_path = argc > 1 ? argv[1] : "sample.obj";
+	string cache_dir = string(argc > 2 ? argv[2] : "obj8_cache_tmp") + "/";
+
+	const char * numbers[] = {
+		"0", "1", "-1", "+2.5", "0.5", "-0.000125", "3.1415927", "0.57735027", "0.1", "0.0009765625",
+		"1234.5678", "-987.654321", "0.33333333333333333333", "16777217", "123456789012345678901234",
+		"0.0000000000000000000000001", NULL };
+	for(const char ** n = numbers; *n; ++n)
+		check_flt_scan(*n);
+
+	// Two numbers on one line, then one on the next - the scanner must stop at each one's end.
+	{
+		char	line[] = "1.5 -2.25\n  7\n";
+		xbyt *	p = (xbyt *) line;
+		xbyt *	e = p + strlen(line);
+		CHECK(TXT_MAP_flt_scan(p, e, xfals) ==  1.5f);
+		CHECK(TXT_MAP_flt_scan(p, e, xfals) == -2.25f);
+		CHECK(TXT_MAP_flt_scan(p, e, xtrue) ==  7.0f);
+	}
+
+	// Text parse, then a round trip through the binary format.
+	XObj8	text_obj;
+	XObj8SetCacheFolder("");
+	if(!XObj8Read(obj_path, text_obj))
+	{
+		printf("FAILED: could not read %s\n", obj_path);
+		return 1;
+	}
+	CHECK(text_obj.geo_tri.count() == 8);
+	CHECK(text_obj.indices.size() == 22);
+	CHECK(text_obj.lods.size() == 2);
+
+	string	bin;
+	XObj8WriteBinary(text_obj, bin);
+	XObj8	bin_obj;
+	CHECK(XObj8ReadBinary(bin.data(), bin.data() + bin.size(), bin_obj));
+	CHECK(XObj8Same(text_obj, bin_obj));
+
+	// A truncated cache file must be turned down, not half loaded.
+	XObj8	cut_obj;
+	CHECK(!XObj8ReadBinary(bin.data(), bin.data() + bin.size() / 2, cut_obj));
+
+	// Through the cache folder: the first read parses and writes the cache, the second loads it.
+	FILE_make_dir_exist(cache_dir.c_str());
+	XObj8SetCacheFolder(cache_dir);
+	XObj8	miss_obj, hit_obj;
+	CHECK(XObj8Read(obj_path, miss_obj));
+	CHECK(XObj8Read(obj_path, hit_obj));
+	CHECK(XObj8Same(text_obj, miss_obj));
+	CHECK(XObj8Same(text_obj, hit_obj));
+
+	vector<string> files;
+	FILE_get_directory(cache_dir, &files, NULL);
+	CHECK(files.size() == 1);						// the cache file, and no temp file left behind
+	XObj8SetCacheFolder("");
+	FILE_delete_dir_recursive(cache_dir);
+
+	if(sFails)
+		printf("%d checks FAILED\n", sFails);
+	else
+		printf("All checks passed.\n");
+	return sFails ? 1 : 0;
+}